@@ -0,0 +1,41 @@
+#include "arena.h"
+
+#include <assert.h>
+#include "platform/memory.h"
+
+static size_t AlignUp(size_t offset, size_t alignment)
+{
+    return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+void ArenaMeasure(Arena* arena, size_t size, size_t alignment)
+{
+    assert(arena->block == nullptr && alignment <= ARENA_BLOCK_ALIGNMENT);
+    arena->size = AlignUp(arena->size, alignment) + size;
+}
+
+bool ArenaCommit(Arena* arena)
+{
+    assert(arena->block == nullptr);
+    arena->offset = 0;
+    if (arena->size == 0) {
+        return true;
+    }
+    arena->block = (char*)AllocateAligned(arena->size, ARENA_BLOCK_ALIGNMENT);
+    return arena->block != nullptr;
+}
+
+// the block starts ARENA_BLOCK_ALIGNMENT aligned, so aligning offsets like ArenaMeasure did yields aligned pointers
+void* ArenaAlloc(Arena* arena, size_t size, size_t alignment)
+{
+    size_t offset = AlignUp(arena->offset, alignment);
+    assert(offset + size <= arena->size);
+    arena->offset = offset + size;
+    return arena->block + offset;
+}
+
+void ArenaRelease(Arena* arena)
+{
+    FreeAligned(arena->block);
+    *arena = Arena();
+}
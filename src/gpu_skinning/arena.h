@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+///
+/**
+    Arena - one aligned block per asset.
+    An importer first measures every array it is going to allocate with ArenaMeasure, then commits the block and
+    carves the arrays from it with ArenaAlloc in the same order. Releasing the arena frees the asset in one go.
+*/
+#define ARENA_BLOCK_ALIGNMENT 64
+
+struct Arena
+{
+    char*   block = nullptr;
+    size_t  size = 0;       // bytes measured so far, the block's capacity once committed
+    size_t  offset = 0;
+};
+
+void    ArenaMeasure(Arena* arena, size_t size, size_t alignment);
+// allocates the measured block, fails only if the allocation does
+bool    ArenaCommit(Arena* arena);
+void*   ArenaAlloc(Arena* arena, size_t size, size_t alignment);
+void    ArenaRelease(Arena* arena);
+
+template <class T>
+T* ArenaAllocArray(Arena* arena, size_t count)
+{
+    return static_cast<T*>(ArenaAlloc(arena, sizeof(T) * count, alignof(T)));
+}
@@ -0,0 +1,1240 @@
+#include "assets.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <assert.h>
+#include <emmintrin.h>
+#include "platform/timer.h"
+#include "hash.h"
+#include "gtbin.h"
+
+///
+Package g_package;
+
+bool OpenByteStream(const char* path, StreamSource* outSource, ByteStream* outStream)
+{
+    *outSource = StreamSource();
+    if (OpenPackageStream(&g_package, path, outStream)) {
+        outSource->unpacked = true;
+        return true;
+    }
+    if (!MapFile(path, &outSource->file)) {
+        return false;
+    }
+    outStream->buffer = outSource->file.data;
+    outStream->bufferSize = outSource->file.size;
+    outStream->offset = 0;
+    return true;
+}
+
+void CloseByteStream(StreamSource* source, ByteStream* stream)
+{
+    if (source->unpacked) {
+        ReleasePackageStream(stream);
+    }
+    UnmapFile(&source->file);
+    *source = StreamSource();
+}
+
+bool ReportParseError(const char* path, const ByteStream& stream, ParseStatus* outStatus)
+{
+    auto& status = stream.status;
+    printf("%s: %s at offset %llu%s%s\n", path, ParseErrorString(status.error), (unsigned long long)status.offset,
+        status.what != nullptr ? " in " : "", status.what != nullptr ? status.what : "");
+    if (outStatus != nullptr) {
+        *outStatus = status;
+    }
+    return false;
+}
+
+// magic number and version, as written by the GT exporters
+static bool ReadGTHeader(ByteStream& stream)
+{
+    if (!stream.Require(sizeof(uint32_t) * 2, "header")) {
+        return false;
+    }
+    if (stream.ReadUnchecked<uint32_t>() != 0xdeadbeef) {
+        return stream.Fail(PARSE_BAD_MAGIC, "header");
+    }
+    if (stream.ReadUnchecked<uint32_t>() != 1) {
+        return stream.Fail(PARSE_BAD_VERSION, "header");
+    }
+    return true;
+}
+
+// parents have to be joint indices or -1 and must not form a loop, SortSkeleton relies on both
+static bool ValidateJointParents(ByteStream& stream, const int* parents, uint32_t numJoints)
+{
+    for (uint32_t i = 0; i < numJoints; ++i) {
+        uint32_t depth = 0;
+        for (int parent = parents[i]; parent != -1; parent = parents[parent]) {
+            if (parent < -1 || parent >= (int)numJoints) {
+                return stream.Fail(PARSE_OUT_OF_RANGE, "joint parent");
+            }
+            if (++depth > numJoints) {
+                return stream.Fail(PARSE_INVALID, "joint hierarchy");
+            }
+        }
+    }
+    return true;
+}
+
+///
+uint32_t TransferNode(Skeleton* source, Skeleton* target, uint32_t& writeOffset, int nodeIdx)
+{
+    auto importId = source->joints[nodeIdx].importId;
+    assert(importId >= 0 && importId < MAX_NUM_BONES);
+    if (target->importRemap[importId] != -1) {  // already transferred as the parent of an earlier node
+        return (uint32_t)target->importRemap[importId];
+    }
+    if (source->joints[nodeIdx].parent != -1) {
+        source->joints[nodeIdx].parent = TransferNode(source, target, writeOffset, source->joints[nodeIdx].parent);
+    }
+    target->numJoints++;
+    target->joints[writeOffset] = source->joints[nodeIdx];
+    auto name = GetJointName(source, nodeIdx);
+    SetJointName(target, writeOffset, name, strlen(name));
+    memcpy(target->bindpose[writeOffset], source->bindpose[nodeIdx], sizeof(float) * 16);
+    memcpy(target->invBindpose[writeOffset], source->invBindpose[nodeIdx], sizeof(float) * 16);
+    target->importRemap[importId] = (int16_t)writeOffset;
+    writeOffset++;
+    return writeOffset - 1;
+}
+
+void SortSkeleton(Skeleton* source, Skeleton* target)
+{
+    target->numJoints = 0;
+    target->names = JointNames();
+    for (uint32_t i = 0; i < MAX_NUM_BONES; ++i) { target->importRemap[i] = -1; }
+    uint32_t writeOffset = 0;
+    uint32_t readOffset = 0;
+    while (readOffset < MAX_NUM_BONES && readOffset < source->numJoints) {
+        TransferNode(source, target, writeOffset, readOffset);
+        readOffset++;
+    }
+}
+
+void QuatToMatrix(const math::Vec4& quat, float* outMatrix)
+{
+    auto qx = quat.x;
+    auto qy = quat.y;
+    auto qz = quat.z;
+    auto qw = quat.w;
+
+    float temp[16];
+    temp[0] = 1.0f - 2.0f*qy*qy - 2.0f*qz*qz;
+    temp[1] = 2.0f*qx*qy - 2.0f*qz*qw;
+    temp[2] = 2.0f*qx*qz + 2.0f*qy*qw;
+    temp[3] = 0.0f;
+    temp[4] = 2.0f*qx*qy + 2.0f*qz*qw;
+    temp[5] = 1.0f - 2.0f*qx*qx - 2.0f*qz*qz;
+    temp[6] = 2.0f*qy*qz - 2.0f*qx*qw;
+    temp[7] = 0.0f;
+    temp[8] = 2.0f*qx*qz - 2.0f*qy*qw;
+    temp[9] = 2.0f*qy*qz + 2.0f*qx*qw;
+    temp[10] = 1.0f - 2.0f*qx*qx - 2.0f*qy*qy;
+    temp[11] = 0.0f;
+    temp[12] = 0.0f;
+    temp[13] = 0.0f;
+    temp[14] = 0.0f;
+    temp[15] = 1.0f;
+
+    float rot[16];
+    float conv[16];
+    math::Make4x4FloatMatrixIdentity(conv);
+    //math::Make4x4FloatRotationMatrixCMLH(conv, math::Vec3(1.0f, 0.0f, 0.0f), math::DegreesToRadians(90.0f));
+
+    math::Make4x4FloatMatrixTranspose(temp, rot);
+    math::MultiplyMatricesCM(conv, rot, outMatrix);
+}
+
+math::Vec4 QuatFromMatrix(float* mat)
+{
+    auto m = [mat](int row, int column) -> float { return math::Get4x4FloatMatrixValueCM(mat, column, row); };
+    float trace = m(0, 0) + m(1, 1) + m(2, 2);
+    math::Vec4 res;
+    if (trace > 0.0f) {
+        float s = 0.5f / math::Sqrt(trace + 1.0f);
+        res.w = 0.25f / s;
+        res.x = (m(2, 1) - m(1, 2)) * s;
+        res.y = (m(0, 2) - m(2, 0)) * s;
+        res.z = (m(1, 0) - m(0, 1)) * s;
+    }
+    else if (m(0, 0) > m(1, 1) && m(0, 0) > m(2, 2)) {
+        float s = 2.0f * math::Sqrt(1.0f + m(0, 0) - m(1, 1) - m(2, 2));
+        res.w = (m(2, 1) - m(1, 2)) / s;
+        res.x = 0.25f * s;
+        res.y = (m(0, 1) + m(1, 0)) / s;
+        res.z = (m(0, 2) + m(2, 0)) / s;
+    }
+    else if (m(1, 1) > m(2, 2)) {
+        float s = 2.0f * math::Sqrt(1.0f + m(1, 1) - m(0, 0) - m(2, 2));
+        res.w = (m(0, 2) - m(2, 0)) / s;
+        res.x = (m(0, 1) + m(1, 0)) / s;
+        res.y = 0.25f * s;
+        res.z = (m(1, 2) + m(2, 1)) / s;
+    }
+    else {
+        float s = 2.0f * math::Sqrt(1.0f + m(2, 2) - m(0, 0) - m(1, 1));
+        res.w = (m(1, 0) - m(0, 1)) / s;
+        res.x = (m(0, 2) + m(2, 0)) / s;
+        res.y = (m(1, 2) + m(2, 1)) / s;
+        res.z = 0.25f * s;
+    }
+    return math::Normalize(res);
+}
+
+
+///
+uint64_t HashSkeletonLayout(Skeleton* skeleton)
+{
+    uint64_t hash = HashFNV1a64(&skeleton->numJoints, sizeof(skeleton->numJoints));
+    for (uint32_t i = 0; i < skeleton->numJoints; ++i) {
+        hash = HashFNV1a64(&skeleton->joints[i].importId, sizeof(int), hash);
+        hash = HashFNV1a64(&skeleton->joints[i].parent, sizeof(int), hash);
+    }
+    return hash;
+}
+
+static bool BakeSkeleton(const char* sourcePath, Skeleton* skeleton)
+{
+    char bakedPath[512];
+    GTBinSource source;
+    if (!GTBinPathFor(sourcePath, bakedPath, sizeof(bakedPath)) || !GTBinSourceFor(sourcePath, 0, &source)) {
+        return false;
+    }
+    GTBinWriter writer;
+    GTBinBegin(&writer);
+    // the baked copy starts zeroed and only takes the joints in use, so bakes of the same source are identical;
+    // joint names live inside, nothing to patch
+    auto root = GTBinAlloc(&writer, sizeof(Skeleton), 16);
+    auto baked = static_cast<Skeleton*>(GTBinAt(&writer, root));
+    memcpy(baked->bindpose, skeleton->bindpose, sizeof(float) * 16 * skeleton->numJoints);
+    memcpy(baked->invBindpose, skeleton->invBindpose, sizeof(float) * 16 * skeleton->numJoints);
+    baked->names = skeleton->names;
+    memcpy(baked->joints, skeleton->joints, sizeof(Joint) * skeleton->numJoints);
+    memcpy(baked->importRemap, skeleton->importRemap, sizeof(skeleton->importRemap));
+    baked->numJoints = skeleton->numJoints;
+    return GTBinFinish(&writer, bakedPath, GTBIN_SKELETON, source, root);
+}
+
+bool LoadBakedSkeleton(const char* sourcePath, Skeleton* outSkeleton)
+{
+    char bakedPath[512];
+    GTBinSource source;
+    if (!GTBinPathFor(sourcePath, bakedPath, sizeof(bakedPath)) || !GTBinSourceFor(sourcePath, 0, &source)) {
+        return false;
+    }
+    FileMapping file;
+    void* root = nullptr;
+    if (!GTBinLoad(bakedPath, GTBIN_SKELETON, sizeof(Skeleton), source, &file, &root)) {
+        return false;
+    }
+    memcpy(outSkeleton, root, sizeof(Skeleton));
+    UnmapFile(&file);
+    return true;
+}
+
+#define SGA_JOINT_TRANSFORM_SIZE (sizeof(math::Vec3) * 2 + sizeof(math::Vec4))    // position, scale, rotation
+
+static bool ValidateSGASkeleton(ByteStream& stream)
+{
+    if (!stream.Require(sizeof(uint32_t) + sizeof(uint8_t) + sizeof(uint16_t), "header")) {
+        return false;
+    }
+    if (stream.ReadUnchecked<uint32_t>() != 383405658) {
+        return stream.Fail(PARSE_BAD_MAGIC, "header");
+    }
+    if (stream.ReadUnchecked<uint8_t>() != 1) {
+        return stream.Fail(PARSE_BAD_VERSION, "header");
+    }
+    auto nameLen = stream.ReadUnchecked<uint16_t>();
+    if (!stream.Require(nameLen + sizeof(uint16_t), "skeleton name")) {
+        return false;
+    }
+    stream.SkipUnchecked(nameLen);
+    auto numJoints = stream.ReadUnchecked<uint16_t>();
+    if (numJoints > MAX_NUM_BONES) {
+        return stream.Fail(PARSE_OUT_OF_RANGE, "joint count");
+    }
+    int parents[MAX_NUM_BONES];
+    for (auto i = 0; i < MAX_NUM_BONES; ++i) { parents[i] = -1; }
+    for (uint32_t i = 0; i < numJoints; ++i) {
+        if (!stream.Require(sizeof(uint16_t), "joint name")) {
+            return false;
+        }
+        auto jointNameLen = stream.ReadUnchecked<uint16_t>();
+        if (!stream.Require(jointNameLen + SGA_JOINT_TRANSFORM_SIZE + sizeof(uint8_t) + sizeof(uint16_t), "joint")) {
+            return false;
+        }
+        stream.SkipUnchecked(jointNameLen + SGA_JOINT_TRANSFORM_SIZE + sizeof(uint8_t));
+        auto numChildren = stream.ReadUnchecked<uint16_t>();
+        if (numChildren > MAX_NUM_BONES) {
+            return stream.Fail(PARSE_OUT_OF_RANGE, "joint children");
+        }
+        if (!stream.Require(sizeof(uint16_t) * numChildren, "joint children")) {
+            return false;
+        }
+        for (uint16_t c = 0; c < numChildren; ++c) {
+            auto child = stream.ReadUnchecked<uint16_t>();
+            if (child >= numJoints) {
+                return stream.Fail(PARSE_OUT_OF_RANGE, "joint children");
+            }
+            parents[child] = (int)i;
+        }
+    }
+    return ValidateJointParents(stream, parents, numJoints);
+}
+
+bool ImportSkeletonFromMemory(ByteStream& stream, Skeleton* outSkeleton)
+{
+    {
+        ByteStream check = stream;
+        if (!ValidateSGASkeleton(check)) {
+            stream.status = check.status;
+            return false;
+        }
+    }
+    stream.SkipUnchecked(sizeof(uint32_t) + sizeof(uint8_t));  // magic number, version
+
+    auto nameLen = stream.ReadUnchecked<uint16_t>();
+    stream.SkipUnchecked(nameLen);   // skip the name
+
+    outSkeleton->numJoints = (uint32_t)stream.ReadUnchecked<uint16_t>(); 
+    
+    Skeleton tempSkeleton;
+    tempSkeleton.numJoints = outSkeleton->numJoints;
+    int tempParentIndexTable[MAX_NUM_BONES];
+    for (auto i = 0; i < MAX_NUM_BONES; ++i) { tempParentIndexTable[i] = -1; }
+
+    for (uint32_t i = 0; i < outSkeleton->numJoints; ++i) {
+        // read the bone name and store it
+        auto nameLen = stream.ReadUnchecked<uint16_t>();
+        const char* name = stream.buffer + stream.offset;
+        stream.SkipUnchecked(nameLen);
+        if (!SetJointName(&tempSkeleton, i, name, nameLen)) {
+            return stream.Fail(PARSE_OUT_OF_RANGE, "joint names");
+        }
+        // read the bind pose
+        auto& joint = tempSkeleton.joints[i];   
+        joint.importId = i;
+
+        /*
+        float spaceConversion[16] = {
+            1.0f, 0.0f, 0.0f, 0.0f,
+            0.0f, 0.0f, 1.0f, 0.0f,
+            0.0f, 1.0f, 0.0f, 0.0f,
+            0.0f, 0.0f, 0.0f, 1.0f,
+        };
+
+        float temp[16];
+        stream.ReadBytes(temp, sizeof(float) * 16);
+        math::MultiplyMatricesCM(spaceConversion, temp, tempSkeleton.bindpose[i]);
+        */
+        //stream.ReadBytes(tempSkeleton.bindpose[i], sizeof(float) * 16);
+        auto pos = stream.ReadUnchecked<math::Vec3>();
+        auto scale = stream.ReadUnchecked<math::Vec3>();  // ignore scale 
+        auto rot = stream.ReadUnchecked<math::Vec4>();
+
+        float rotMat[16];
+        float transMat[16];
+        float transScaled[16];
+        float scaleMat[16];
+        QuatToMatrix(rot, rotMat);
+        math::Make4x4FloatTranslationMatrixCM(transMat, pos);   // 
+        math::Make4x4FloatMatrixIdentity(scaleMat);
+        scaleMat[0] = scale.x;
+        scaleMat[5] = scale.y;
+        scaleMat[10] = scale.z;
+        
+        math::MultiplyMatricesCM(transMat, scaleMat, transScaled);
+        math::MultiplyMatricesCM(transScaled, rotMat, tempSkeleton.joints[i].bindpose);
+       
+
+        //math::Make4x4FloatTranslationMatrixCM(tempSkeleton.joints[i].bindpose, pos);
+        auto isParent = stream.ReadUnchecked<uint8_t>() == 1;
+        if (isParent) {
+            joint.parent = -1;
+        }
+        else {
+            joint.parent = 0;
+        }
+        auto numChildren = stream.ReadUnchecked<uint16_t>();
+        for(uint16_t c = 0; c < numChildren; ++c) {
+            tempParentIndexTable[stream.ReadUnchecked<uint16_t>()] = i;
+        }
+    }
+    for (uint16_t i = 0; i < tempSkeleton.numJoints; ++i) {
+        tempSkeleton.joints[i].parent = tempParentIndexTable[i];
+    }
+    SortSkeleton(&tempSkeleton, outSkeleton);
+    outSkeleton->numJoints = tempSkeleton.numJoints;
+    for (int i = 0; i < (int)outSkeleton->numJoints; ++i) {
+        assert(outSkeleton->joints[i].parent < i);
+    }
+    // compute inverse bind transforms as well as global space bind and inverse bind transform for each bone
+    for (int i = 0; i < (int)outSkeleton->numJoints; ++i) {
+        auto& joint = outSkeleton->joints[i];
+        if (joint.parent == -1) {
+            math::Copy4x4FloatMatrixCM(joint.bindpose, outSkeleton->bindpose[i]);
+        }
+        else {
+            math::MultiplyMatricesCM(outSkeleton->bindpose[joint.parent], joint.bindpose, outSkeleton->bindpose[i]);
+        }
+        math::Inverse4x4FloatMatrixCM(outSkeleton->bindpose[i], outSkeleton->invBindpose[i]);
+        math::Inverse4x4FloatMatrixCM(joint.bindpose, joint.invBindpose);
+    }
+
+    return true;
+}
+
+bool ImportSkeletonFromSGA(const char* path, Skeleton* outSkeleton, ParseStatus* outStatus)
+{
+    StreamSource source;
+    ByteStream stream;
+    if (!OpenByteStream(path, &source, &stream)) {
+        return false;
+    }
+
+    auto res = ImportSkeletonFromMemory(stream, outSkeleton) || ReportParseError(path, stream, outStatus);
+    CloseByteStream(&source, &stream);
+    return res;
+}
+
+#define GTSKEL_JOINT_SIZE (sizeof(float) * 16 + sizeof(int32_t))   // bindpose, parent; after the name
+
+static bool ValidateGTSkeleton(ByteStream& stream)
+{
+    if (!ReadGTHeader(stream) || !stream.Require(sizeof(uint32_t), "joint count")) {
+        return false;
+    }
+    auto numJoints = stream.ReadUnchecked<uint32_t>();
+    if (numJoints > MAX_NUM_BONES) {
+        return stream.Fail(PARSE_OUT_OF_RANGE, "joint count");
+    }
+    int parents[MAX_NUM_BONES];
+    for (uint32_t i = 0; i < numJoints; ++i) {
+        if (!stream.Require(sizeof(uint32_t), "joint name")) {
+            return false;
+        }
+        auto nameLen = stream.ReadUnchecked<uint32_t>();
+        if (!stream.Require((size_t)nameLen + GTSKEL_JOINT_SIZE, "joint")) {
+            return false;
+        }
+        stream.SkipUnchecked(nameLen + sizeof(float) * 16);
+        parents[i] = stream.ReadUnchecked<int32_t>();
+    }
+    return ValidateJointParents(stream, parents, numJoints);
+}
+
+bool ImportGTSkeleton(const char* path, Skeleton* outSkeleton, ParseStatus* outStatus)
+{
+    StreamSource source;
+    ByteStream stream;
+    if (!OpenByteStream(path, &source, &stream)) {
+        return false;
+    }
+
+    {
+        ByteStream check = stream;
+        if (!ValidateGTSkeleton(check)) {
+            ReportParseError(path, check, outStatus);
+            CloseByteStream(&source, &stream);
+            return false;
+        }
+    }
+    stream.SkipUnchecked(sizeof(uint32_t) * 2);    // magic number, version
+
+    Skeleton tempSkeleton;
+
+    tempSkeleton.numJoints = stream.ReadUnchecked<uint32_t>();
+    for (uint32_t i = 0; i < tempSkeleton.numJoints; ++i) {
+        uint32_t nameLen = stream.ReadUnchecked<uint32_t>();
+        const char* name = stream.buffer + stream.offset;
+        stream.SkipUnchecked(nameLen);
+        if (!SetJointName(&tempSkeleton, i, name, nameLen)) {
+            stream.Fail(PARSE_OUT_OF_RANGE, "joint names");
+            ReportParseError(path, stream, outStatus);
+            CloseByteStream(&source, &stream);
+            return false;
+        }
+
+        float bindpose[16];
+        stream.ReadBytesUnchecked(bindpose, sizeof(float) * 16);
+        math::Copy4x4FloatMatrixCM(bindpose, tempSkeleton.bindpose[i]);
+        
+        tempSkeleton.joints[i].importId = i;
+        tempSkeleton.joints[i].parent = stream.ReadUnchecked<int32_t>();
+    }
+    CloseByteStream(&source, &stream);
+    
+    SortSkeleton(&tempSkeleton, outSkeleton);
+    for (int i = 0; i < (int)outSkeleton->numJoints; ++i) {
+        assert(outSkeleton->joints[i].parent < i);
+    }
+    // compute inverse bind transforms as well as global space bind and inverse bind transform for each bone, make joint transforms local to parent
+    for (int i = 0; i < (int)outSkeleton->numJoints; ++i) {
+        auto& joint = outSkeleton->joints[i];
+        if (joint.parent == -1) {
+            math::Copy4x4FloatMatrixCM(outSkeleton->bindpose[i], joint.bindpose);
+        }
+        else {
+            math::MultiplyMatricesCM(outSkeleton->invBindpose[joint.parent], outSkeleton->bindpose[i], joint.bindpose);
+        }
+        math::Inverse4x4FloatMatrixCM(outSkeleton->bindpose[i], outSkeleton->invBindpose[i]);
+        math::Inverse4x4FloatMatrixCM(joint.bindpose, joint.invBindpose);
+
+    }
+    BakeSkeleton(path, outSkeleton);
+
+    return true;
+}
+///
+// probes the name map for name, returns the slot holding it or the free slot it would go into
+static uint32_t FindJointNameSlot(JointNames* names, const char* name, size_t nameLen, uint64_t hash)
+{
+    uint32_t slot = (uint32_t)hash & (JOINT_NAME_MAP_SIZE - 1);
+    while (names->map[slot] != 0) {
+        uint32_t joint = names->map[slot] - 1u;
+        const char* candidate = names->pool + names->offsets[joint];
+        if (names->hashes[joint] == hash && strncmp(candidate, name, nameLen) == 0 && candidate[nameLen] == '\0') {
+            return slot;
+        }
+        slot = (slot + 1) & (JOINT_NAME_MAP_SIZE - 1);
+    }
+    return slot;
+}
+
+bool SetJointName(Skeleton* skeleton, uint32_t jointIdx, const char* name, size_t nameLen)
+{
+    assert(jointIdx < MAX_NUM_BONES);
+    auto names = &skeleton->names;
+    uint64_t hash = HashFNV1a64(name, nameLen);
+    uint32_t slot = FindJointNameSlot(names, name, nameLen, hash);
+    if (names->map[slot] != 0) {
+        names->offsets[jointIdx] = names->offsets[names->map[slot] - 1u];
+    }
+    else {
+        if (names->poolSize + nameLen + 1 > JOINT_NAME_POOL_SIZE) {
+            return false;
+        }
+        memcpy(names->pool + names->poolSize, name, nameLen);
+        names->pool[names->poolSize + nameLen] = '\0';
+        names->offsets[jointIdx] = names->poolSize;
+        names->poolSize += (uint32_t)nameLen + 1;
+        names->map[slot] = (uint8_t)(jointIdx + 1);
+    }
+    names->hashes[jointIdx] = hash;
+    return true;
+}
+
+const char* GetJointName(Skeleton* skeleton, uint32_t jointIdx)
+{
+    return skeleton->names.pool + skeleton->names.offsets[jointIdx];
+}
+
+int GetBoneWithName(Skeleton* skeleton, const char* name)
+{
+    size_t nameLen = strlen(name);
+    uint32_t slot = FindJointNameSlot(&skeleton->names, name, nameLen, HashFNV1a64(name, nameLen));
+    return (int)skeleton->names.map[slot] - 1;
+}
+
+int GetBoneWithImportId(Skeleton* skeleton, int importId)
+{
+    return importId >= 0 && importId < MAX_NUM_BONES ? skeleton->importRemap[importId] : -1;
+}
+///
+bool ImportAnimationFromSGA(const char* path, Skeleton* targetSkeleton, AnimationClip* outAnimations, uint32_t* outNumAnimations)
+{
+    // disabled, the parameters are only read by the importer kept below
+    (void)path; (void)targetSkeleton; (void)outAnimations; (void)outNumAnimations;
+    return false;
+    //StreamSource source;
+    //ByteStream stream;
+    //if (!OpenByteStream(path, &source, &stream)) {
+    //    return false;
+    //}
+
+    //{
+    //    Skeleton tempSkeleton;
+    //    if (!ImportSkeletonFromMemory(stream, &tempSkeleton)) {
+    //        assert(false);
+    //        return false;
+    //    }
+    //}
+
+    //*outNumAnimations = (uint32_t)stream.Read<uint16_t>();
+    //if (outAnimations != nullptr) {
+    //    for (uint32_t i = 0; i < *outNumAnimations; ++i) {
+    //        Animation& anim = outAnimations[i];
+    //        auto nameLen = stream.Read<uint16_t>();
+    //        anim.name = (char*)malloc(nameLen);
+    //        stream.ReadBytes(anim.name, nameLen);
+    //        auto numAffectedBones = stream.Read<uint16_t>();
+    //       
+    //        float biggestTimestamp = 0.0f;
+    //        for (uint16_t j = 0; j < numAffectedBones; ++j) {
+    //            auto importId = stream.Read<uint16_t>();
+    //            auto id = GetBoneWithImportId(targetSkeleton, importId);
+    //            auto& track = anim.tracks[id];
+    //            track.numKeyframes = stream.Read<uint32_t>();
+    //            track.keyframes = new KeyFrame[track.numKeyframes];
+    //            for (uint32_t k = 0; k < track.numKeyframes; ++k) {
+    //                auto& frame = track.keyframes[k];
+    //                frame.timeStamp = stream.Read<float>();
+    //                if (frame.timeStamp > biggestTimestamp) { biggestTimestamp = frame.timeStamp; }
+    //                frame.jointTransform.position = stream.Read<math::Vec3>();  
+    //                frame.jointTransform.scale = stream.Read<math::Vec3>();     // 
+    //                frame.jointTransform.rotation = stream.Read<math::Vec4>();  // rotation as a 4-component quaternion
+    //            }
+    //        }
+    //        anim.duration = biggestTimestamp;
+    //    }
+    //}
+    //return true;
+}
+
+
+bool BakeAnimation(const char* sourcePath, Skeleton* targetSkeleton, AnimationClip* clip)
+{
+    char bakedPath[512];
+    GTBinSource source;
+    if (!GTBinPathFor(sourcePath, bakedPath, sizeof(bakedPath)) || !GTBinSourceFor(sourcePath, HashSkeletonLayout(targetSkeleton), &source)) {
+        return false;
+    }
+    GTBinWriter writer;
+    GTBinBegin(&writer);
+    // a zeroed copy of the clip's fields, padding included, so bakes of the same source are identical; the arena
+    // stays empty, baked clips live in their mapping
+    auto root = GTBinAlloc(&writer, sizeof(AnimationClip), 16);
+    auto baked = static_cast<AnimationClip*>(GTBinAt(&writer, root));
+    baked->numTracks = clip->numTracks;
+    baked->duration = clip->duration;
+    for (uint32_t i = 0; i < MAX_NUM_BONES; ++i) {
+        baked->tracks[i].numKeyframes = clip->tracks[i].numKeyframes;
+    }
+    auto name = GTBinWrite(&writer, clip->name, strlen(clip->name) + 1, 1);
+    GTBinPointer(&writer, root + offsetof(AnimationClip, name), name);
+    size_t timesOffsets[MAX_NUM_BONES];
+    for (uint32_t i = 0; i < MAX_NUM_BONES; ++i) {
+        auto& track = clip->tracks[i];
+        auto slot = root + offsetof(AnimationClip, tracks) + i * sizeof(BoneTrack);
+        if (track.numKeyframes == 0) {
+            continue;
+        }
+        uint32_t sharedTimes = FindSharedTimes(clip, i);
+        timesOffsets[i] = sharedTimes != i ? timesOffsets[sharedTimes] : GTBinWrite(&writer, track.times, sizeof(float) * track.numKeyframes, 16);
+        GTBinPointer(&writer, slot + offsetof(BoneTrack, times), timesOffsets[i]);
+        auto keyframes = GTBinWrite(&writer, track.keyframes, sizeof(Keyframe) * track.numKeyframes, 16);
+        GTBinPointer(&writer, slot + offsetof(BoneTrack, keyframes), keyframes);
+    }
+    return GTBinFinish(&writer, bakedPath, GTBIN_ANIMATION_CLIP, source, root);
+}
+
+bool LoadBakedAnimation(const char* sourcePath, Skeleton* targetSkeleton, FileMapping* outFile, AnimationClip* outAnimation)
+{
+    char bakedPath[512];
+    GTBinSource source;
+    if (!GTBinPathFor(sourcePath, bakedPath, sizeof(bakedPath)) || !GTBinSourceFor(sourcePath, HashSkeletonLayout(targetSkeleton), &source)) {
+        return false;
+    }
+    void* root = nullptr;
+    if (!GTBinLoad(bakedPath, GTBIN_ANIMATION_CLIP, sizeof(AnimationClip), source, outFile, &root)) {
+        return false;
+    }
+    memcpy(outAnimation, root, sizeof(AnimationClip));
+    return true;
+}
+
+KeySpan FindKeySpan(const float* times, uint32_t numKeys, float time)
+{
+    uint32_t first = 0;
+    uint32_t count = numKeys;
+    while (count > 0) {     // first key after time
+        uint32_t step = count / 2;
+        if (times[first + step] <= time) {
+            first += step + 1;
+            count -= step + 1;
+        }
+        else {
+            count = step;
+        }
+    }
+    KeySpan span;
+    span.next = first < numKeys ? first : numKeys - 1;
+    span.prev = first > 0 ? first - 1 : 0;
+    if (span.prev != span.next) {
+        span.alpha = (time - times[span.prev]) / (times[span.next] - times[span.prev]);
+    }
+    return span;
+}
+
+KeySpan AdvanceKeySpan(const float* times, uint32_t numKeys, float time, uint32_t* cursor)
+{
+    uint32_t prev = *cursor;
+    bool found = prev < numKeys && times[prev] <= time;
+    for (uint32_t step = 0; found && prev + 1 < numKeys && times[prev + 1] <= time; ++step) {
+        found = step < KEY_CURSOR_MAX_STEPS;
+        prev++;
+    }
+    if (!found) {
+        KeySpan span = FindKeySpan(times, numKeys, time);
+        *cursor = span.prev;
+        return span;
+    }
+    KeySpan span;
+    span.prev = prev;
+    span.next = prev + 1 < numKeys ? prev + 1 : prev;
+    if (span.prev != span.next) {
+        span.alpha = (time - times[span.prev]) / (times[span.next] - times[span.prev]);
+    }
+    *cursor = prev;
+    return span;
+}
+
+uint32_t FindSharedTimes(const AnimationClip* clip, uint32_t trackIdx)
+{
+    auto& track = clip->tracks[trackIdx];
+    for (uint32_t i = 0; i < trackIdx; ++i) {
+        auto& other = clip->tracks[i];
+        if (other.numKeyframes == track.numKeyframes && track.numKeyframes != 0 &&
+            (other.times == track.times || memcmp(other.times, track.times, sizeof(float) * track.numKeyframes) == 0)) {
+            return i;
+        }
+    }
+    return trackIdx;
+}
+
+void ReleaseAnimationClip(AnimationClip* clip)
+{
+    ArenaRelease(&clip->arena);
+    *clip = AnimationClip();
+}
+
+//
+// the track of the first numTracks whose keys in the source are at the same timestamps as the keys at keys, numTracks if there is none
+static uint32_t FindSharedTimestamps(const char* keys, uint32_t numKeyframes, const char* const* trackKeys, const uint32_t* trackNumKeyframes, uint32_t numTracks)
+{
+    for (uint32_t j = 0; j < numTracks; ++j) {
+        bool same = trackNumKeyframes[j] == numKeyframes;
+        for (uint32_t k = 0; same && k < numKeyframes; ++k) {
+            same = memcmp(keys + k * GTANIM_KEYFRAME_SIZE, trackKeys[j] + k * GTANIM_KEYFRAME_SIZE, sizeof(float)) == 0;
+        }
+        if (same) {
+            return j;
+        }
+    }
+    return numTracks;
+}
+
+bool ImportGTAnimation(const char* path, Skeleton* targetSkeleton, AnimationClip* outAnimation, ParseStatus* outStatus)
+{
+    StreamSource source;
+    ByteStream stream;
+    if (!OpenByteStream(path, &source, &stream)) {
+        return false;
+    }
+
+    AnimationClip& anim = *outAnimation;
+    const char* trackKeys[MAX_NUM_BONES];       // per track in source order
+    uint32_t trackNumKeyframes[MAX_NUM_BONES];
+    uint32_t sharedTimes[MAX_NUM_BONES];        // the first track keyed at the same times
+    {   // validating and sizing pass, the name, every distinct times array and all keyframes go into one block
+        ByteStream sizingStream = stream;
+        bool valid = ReadGTHeader(sizingStream) && sizingStream.Require(sizeof(uint32_t), "clip name");
+        uint32_t numTracks = 0;
+        if (valid) {
+            auto nameLen = sizingStream.ReadUnchecked<uint32_t>();
+            ArenaMeasure(&anim.arena, (size_t)nameLen + 1, 1);
+            valid = sizingStream.Require((size_t)nameLen + sizeof(uint32_t), "clip name");
+            if (valid) {
+                sizingStream.SkipUnchecked(nameLen);
+                numTracks = sizingStream.ReadUnchecked<uint32_t>();
+            }
+        }
+        if (numTracks > MAX_NUM_BONES) {
+            valid = sizingStream.Fail(PARSE_OUT_OF_RANGE, "track count");
+        }
+        for (uint32_t j = 0; valid && j < numTracks; ++j) {
+            valid = sizingStream.Require(sizeof(uint32_t) * 2, "track");
+            if (valid && GetBoneWithImportId(targetSkeleton, (int)sizingStream.ReadUnchecked<uint32_t>()) < 0) {
+                valid = sizingStream.Fail(PARSE_OUT_OF_RANGE, "track joint");
+            }
+            uint32_t numKeyframes = 0;
+            if (valid) {
+                numKeyframes = sizingStream.ReadUnchecked<uint32_t>();
+                valid = sizingStream.Require(GTANIM_KEYFRAME_SIZE * numKeyframes, "keyframes");
+            }
+            if (valid) {
+                trackKeys[j] = sizingStream.buffer + sizingStream.offset;
+                trackNumKeyframes[j] = numKeyframes;
+                sharedTimes[j] = FindSharedTimestamps(trackKeys[j], numKeyframes, trackKeys, trackNumKeyframes, j);
+                sizingStream.SkipUnchecked(GTANIM_KEYFRAME_SIZE * numKeyframes);
+                if (sharedTimes[j] == j) {
+                    ArenaMeasure(&anim.arena, sizeof(float) * numKeyframes, alignof(float));
+                }
+                ArenaMeasure(&anim.arena, sizeof(Keyframe) * numKeyframes, alignof(Keyframe));
+            }
+        }
+        if (!valid) {
+            ReportParseError(path, sizingStream, outStatus);
+            CloseByteStream(&source, &stream);
+            anim = AnimationClip();
+            return false;
+        }
+    }
+    if (!ArenaCommit(&anim.arena)) {
+        printf("%s: out of memory\n", path);
+        CloseByteStream(&source, &stream);
+        anim = AnimationClip();
+        return false;
+    }
+    stream.SkipUnchecked(sizeof(uint32_t) * 2);    // magic number, version
+    auto nameLen = stream.ReadUnchecked<uint32_t>();
+    anim.name = ArenaAllocArray<char>(&anim.arena, (size_t)nameLen + 1);
+    stream.ReadBytesUnchecked(anim.name, nameLen);
+    anim.name[nameLen] = '\0';
+    float biggestTimestamp = 0.0f;
+    
+    anim.numTracks = stream.ReadUnchecked<uint32_t>();
+    float* trackTimes[MAX_NUM_BONES];
+    for (uint32_t j = 0; j < anim.numTracks; ++j) {
+        auto importId = stream.ReadUnchecked<uint32_t>();
+        auto id = GetBoneWithImportId(targetSkeleton, importId);
+        {   // translation
+            auto& track = anim.tracks[id];
+            track.numKeyframes = stream.ReadUnchecked<uint32_t>();
+            //assert(track.numKeyframes != 0);
+            bool ownTimes = sharedTimes[j] == j;
+            track.times = ownTimes ? ArenaAllocArray<float>(&anim.arena, track.numKeyframes) : trackTimes[sharedTimes[j]];
+            track.keyframes = ArenaAllocArray<Keyframe>(&anim.arena, track.numKeyframes);
+            trackTimes[j] = track.times;
+            //printf("Bone: %s\n", targetSkeleton->nameTable[id]);
+            for (uint32_t k = 0; k < track.numKeyframes; ++k) {
+                auto& frame = track.keyframes[k];
+                float timeStamp = stream.ReadUnchecked<float>();
+                if (ownTimes) { track.times[k] = timeStamp; }
+                if (timeStamp > biggestTimestamp) { biggestTimestamp = timeStamp; }
+                frame.position = stream.ReadUnchecked<math::Vec3>();
+                frame.rotation = stream.ReadUnchecked<math::Vec4>();
+            }
+        }
+    }
+    CloseByteStream(&source, &stream);
+    
+    anim.duration = biggestTimestamp;
+    BakeAnimation(path, targetSkeleton, outAnimation);
+     
+    return true;
+}
+///
+/**
+    GTMeshExporter writes vertices as
+        position (3f), normal (3f), uv0 (2f), uv1 (2f), tangent (4f), blend weights (4f), blend indices (4u)
+    which is the Vertex layout with a second uv set wedged in after the first one.
+*/
+static const size_t GTMESH_VERTEX_STRIDE = sizeof(Vertex) + sizeof(float) * 2;
+static const size_t GTMESH_UV1_OFFSET = offsetof(Vertex, tangent);
+static_assert(sizeof(Vertex) == 80 && offsetof(Vertex, tangent) == 32, "DecodeGTMeshVertices assumes the 80 byte Vertex layout");
+
+// reference path, reads every field through the stream
+static void DecodeGTMeshVerticesPerField(ByteStream& stream, Vertex* outVertices, uint32_t numVertices)
+{
+    for (uint32_t i = 0; i < numVertices; ++i) {
+        auto& vert = outVertices[i];
+
+        vert.position = stream.Read<math::Vec3>();
+        vert.normal = stream.Read<math::Vec3>();
+        stream.ReadBytes(vert.uv, sizeof(float) * 2);
+        stream.ReadBytes(nullptr, sizeof(float) * 2);   // @NOTE ignore second UV set
+        vert.tangent = stream.Read<math::Vec4>();
+        stream.ReadBytes(vert.blendWeights, sizeof(float) * 4);
+        stream.ReadBytes(vert.blendIndices, sizeof(uint32_t) * 4);
+    }
+}
+
+// moves each vertex as five 16 byte runs, dropping uv1; the caller Required the whole vertex block
+static void DecodeGTMeshVertices(ByteStream& stream, Vertex* outVertices, uint32_t numVertices)
+{
+    size_t blockSize = GTMESH_VERTEX_STRIDE * numVertices;
+    const char* src = stream.buffer + stream.offset;
+    char* dst = (char*)outVertices;
+    for (uint32_t i = 0; i < numVertices; ++i) {
+        // position, normal, uv0
+        __m128i a = _mm_loadu_si128((const __m128i*)(src + 0));
+        __m128i b = _mm_loadu_si128((const __m128i*)(src + 16));
+        // tangent, blend weights, blend indices
+        __m128i c = _mm_loadu_si128((const __m128i*)(src + GTMESH_UV1_OFFSET + 8));
+        __m128i d = _mm_loadu_si128((const __m128i*)(src + GTMESH_UV1_OFFSET + 24));
+        __m128i e = _mm_loadu_si128((const __m128i*)(src + GTMESH_UV1_OFFSET + 40));
+        _mm_storeu_si128((__m128i*)(dst + 0), a);
+        _mm_storeu_si128((__m128i*)(dst + 16), b);
+        _mm_storeu_si128((__m128i*)(dst + 32), c);
+        _mm_storeu_si128((__m128i*)(dst + 48), d);
+        _mm_storeu_si128((__m128i*)(dst + 64), e);
+        src += GTMESH_VERTEX_STRIDE;
+        dst += sizeof(Vertex);
+    }
+    stream.SkipUnchecked(blockSize);
+}
+
+static bool BakeMesh(const char* sourcePath, MeshDesc* desc)
+{
+    char bakedPath[512];
+    GTBinSource source;
+    if (!GTBinPathFor(sourcePath, bakedPath, sizeof(bakedPath)) || !GTBinSourceFor(sourcePath, 0, &source)) {
+        return false;
+    }
+    GTBinWriter writer;
+    GTBinBegin(&writer);
+    // a zeroed copy of the desc's fields, padding included, so bakes of the same source are identical
+    auto root = GTBinAlloc(&writer, sizeof(MeshDesc), 16);
+    auto baked = static_cast<MeshDesc*>(GTBinAt(&writer, root));
+    baked->numVertices = desc->numVertices;
+    baked->numIndices = desc->numIndices;
+    baked->numSubmeshes = desc->numSubmeshes;
+    auto vertices = GTBinWrite(&writer, desc->vertices, sizeof(Vertex) * desc->numVertices, 16);
+    auto indices = GTBinWrite(&writer, desc->indices, sizeof(IndexType) * desc->numIndices, 16);
+    auto submeshes = GTBinWrite(&writer, desc->submeshes, sizeof(Submesh) * desc->numSubmeshes, alignof(Submesh));
+    GTBinPointer(&writer, root + offsetof(MeshDesc, vertices), vertices);
+    GTBinPointer(&writer, root + offsetof(MeshDesc, indices), indices);
+    GTBinPointer(&writer, root + offsetof(MeshDesc, submeshes), submeshes);
+    return GTBinFinish(&writer, bakedPath, GTBIN_MESH, source, root);
+}
+
+// outDesc points into outFile, keep it mapped while the desc is in use
+bool LoadBakedMesh(const char* sourcePath, FileMapping* outFile, MeshDesc* outDesc)
+{
+    char bakedPath[512];
+    GTBinSource source;
+    if (!GTBinPathFor(sourcePath, bakedPath, sizeof(bakedPath)) || !GTBinSourceFor(sourcePath, 0, &source)) {
+        return false;
+    }
+    void* root = nullptr;
+    if (!GTBinLoad(bakedPath, GTBIN_MESH, sizeof(MeshDesc), source, outFile, &root)) {
+        return false;
+    }
+    memcpy(outDesc, root, sizeof(MeshDesc));
+    return true;
+}
+
+void ReleaseMeshDesc(MeshDesc* desc)
+{
+    ArenaRelease(&desc->arena);
+    *desc = MeshDesc();
+}
+
+// validates the layout and counts vertices, indices and submeshes, the submesh ranges are filled in on decode
+static bool ValidateGTMesh(ByteStream& stream, MeshDesc* outDesc)
+{
+    if (!ReadGTHeader(stream) || !stream.Require(sizeof(uint32_t), "vertex count")) {
+        return false;
+    }
+    outDesc->numVertices = stream.ReadUnchecked<uint32_t>();
+    if (!stream.Require(GTMESH_VERTEX_STRIDE * outDesc->numVertices + sizeof(uint32_t) * 2, "vertices")) {
+        return false;
+    }
+    stream.SkipUnchecked(GTMESH_VERTEX_STRIDE * outDesc->numVertices);
+    auto indexSize = stream.ReadUnchecked<uint32_t>();
+    if (indexSize != sizeof(uint16_t) && indexSize != sizeof(uint32_t)) {
+        return stream.Fail(PARSE_INVALID, "index size");
+    }
+    // every submesh takes at least its index count, so the count is bounded by the file size
+    outDesc->numSubmeshes = stream.ReadUnchecked<uint32_t>();
+    uint64_t numIndices = 0;
+    for (uint32_t i = 0; i < outDesc->numSubmeshes; ++i) {
+        if (!stream.Require(sizeof(uint32_t), "submesh")) {
+            return false;
+        }
+        auto numSubmeshIndices = stream.ReadUnchecked<uint32_t>();
+        if (!stream.Require((size_t)indexSize * numSubmeshIndices, "indices")) {
+            return false;
+        }
+        stream.SkipUnchecked((size_t)indexSize * numSubmeshIndices);
+        numIndices += numSubmeshIndices;
+    }
+    if (numIndices > UINT32_MAX) {
+        return stream.Fail(PARSE_OUT_OF_RANGE, "index count");
+    }
+    outDesc->numIndices = (uint32_t)numIndices;
+    return true;
+}
+
+bool ImportGTMesh(const char* path, MeshDesc* outDesc, ParseStatus* outStatus, MeshImportStats* outStats)
+{
+    StreamSource source;
+    ByteStream stream;
+    if (!OpenByteStream(path, &source, &stream)) {
+        return false;
+    }
+
+    MeshDesc& meshDesc = *outDesc;
+    meshDesc = MeshDesc();
+    {   // size vertices, the index buffer and the submeshes from the headers first, so all decode straight into one block
+        ByteStream sizingStream = stream;
+        if (!ValidateGTMesh(sizingStream, &meshDesc)) {
+            ReportParseError(path, sizingStream, outStatus);
+            CloseByteStream(&source, &stream);
+            meshDesc = MeshDesc();
+            return false;
+        }
+        ArenaMeasure(&meshDesc.arena, sizeof(Vertex) * meshDesc.numVertices, alignof(Vertex));
+        ArenaMeasure(&meshDesc.arena, sizeof(IndexType) * meshDesc.numIndices, alignof(IndexType));
+        ArenaMeasure(&meshDesc.arena, sizeof(Submesh) * meshDesc.numSubmeshes, alignof(Submesh));
+    }
+    if (!ArenaCommit(&meshDesc.arena)) {
+        printf("%s: out of memory\n", path);
+        CloseByteStream(&source, &stream);
+        meshDesc = MeshDesc();
+        return false;
+    }
+    meshDesc.vertices = ArenaAllocArray<Vertex>(&meshDesc.arena, meshDesc.numVertices);
+    meshDesc.indices = ArenaAllocArray<IndexType>(&meshDesc.arena, meshDesc.numIndices);
+    meshDesc.submeshes = ArenaAllocArray<Submesh>(&meshDesc.arena, meshDesc.numSubmeshes);
+
+    stream.SkipUnchecked(sizeof(uint32_t) * 3);    // magic number, version, numVertices
+    {
+        auto start = GetTicks();
+        DecodeGTMeshVertices(stream, meshDesc.vertices, meshDesc.numVertices);
+        auto seconds = TicksToSeconds(GetTicks() - start);
+        if (outStats != nullptr) {
+            *outStats = MeshImportStats();
+            outStats->numVertices = meshDesc.numVertices;
+            outStats->vertexBytes = (size_t)GTMESH_VERTEX_STRIDE * meshDesc.numVertices;
+            outStats->decodeSeconds = seconds;
+#ifdef GT_DEVELOPMENT
+            // reference timing of the per-field path
+            Vertex* scratch = new Vertex[meshDesc.numVertices];
+            ByteStream fieldStream = stream;
+            fieldStream.offset -= outStats->vertexBytes;
+            start = GetTicks();
+            DecodeGTMeshVerticesPerField(fieldStream, scratch, meshDesc.numVertices);
+            outStats->perFieldSeconds = TicksToSeconds(GetTicks() - start);
+            delete[] scratch;
+#endif
+        }
+    }
+
+    auto indexSize = stream.ReadUnchecked<uint32_t>();
+    stream.SkipUnchecked(sizeof(uint32_t));    // numSubmeshes
+    uint32_t firstIndex = 0;
+    for (uint32_t i = 0; i < meshDesc.numSubmeshes; ++i) {
+        auto& submesh = meshDesc.submeshes[i];
+        submesh.firstIndex = firstIndex;
+        submesh.numIndices = stream.ReadUnchecked<uint32_t>();
+        submesh.materialId = 0;     // gtmesh carries no materials
+        firstIndex += submesh.numIndices;
+        IndexType* indices = meshDesc.indices + submesh.firstIndex;
+        if (indexSize == sizeof(IndexType)) {
+            stream.ReadBytesUnchecked(indices, sizeof(IndexType) * submesh.numIndices);
+            continue;
+        }
+        for (uint32_t idx = 0; idx < submesh.numIndices; ++idx) {
+            indices[idx] = (IndexType)stream.ReadUnchecked<uint16_t>();
+        }
+    }
+    CloseByteStream(&source, &stream);
+    BakeMesh(path, &meshDesc);
+
+    return true;
+}
+
+
+struct SGMSubmeshHeader
+{
+    uint8_t     materialId = 0;
+    uint32_t    numVertices = 0;
+    size_t      vertexSize = 0;     // in the file
+};
+
+// leaves stream at the submesh's vertices, only the one vertex layout the importer decodes is accepted
+static bool ReadSGMSubmeshHeader(ByteStream& stream, SGMSubmeshHeader* outHeader)
+{
+    if (!stream.Require(sizeof(uint8_t) * 2 + sizeof(uint32_t) + sizeof(uint8_t) * 4, "submesh")) {
+        return false;
+    }
+    stream.SkipUnchecked(sizeof(uint8_t));     // submesh ID
+    outHeader->materialId = stream.ReadUnchecked<uint8_t>();
+    outHeader->numVertices = stream.ReadUnchecked<uint32_t>();
+
+    size_t totalVertexSize = sizeof(math::Vec3) * 2;
+
+    auto numUVSets = stream.ReadUnchecked<uint8_t>();
+    totalVertexSize += sizeof(float) * 2 * numUVSets;
+    auto numColorChannels = stream.ReadUnchecked<uint8_t>();
+    totalVertexSize += sizeof(math::Vec4) * numColorChannels;
+
+    auto hasTangents = stream.ReadUnchecked<uint8_t>();
+    totalVertexSize += hasTangents ? sizeof(math::Vec4) : 0;
+
+    auto hasBones = stream.ReadUnchecked<uint8_t>();
+    totalVertexSize += hasBones ? sizeof(float) * 4 * 2 : 0;
+
+    if (numUVSets != 1 || numColorChannels != 0 || hasTangents != 1 || hasBones != 1 || totalVertexSize != sizeof(Vertex)) {
+        return stream.Fail(PARSE_INVALID, "submesh vertex layout");
+    }
+    outHeader->vertexSize = totalVertexSize;
+    return true;
+}
+
+// skips the materials and validates the submeshes, leaves their count and the buffer sizes in outDesc
+static bool ValidateSGM(ByteStream& stream, MeshDesc* outDesc, size_t* outSubmeshOffset)
+{
+    if (!stream.Require(sizeof(uint32_t) + sizeof(uint8_t), "header")) {
+        return false;
+    }
+    if (stream.ReadUnchecked<uint32_t>() != 352658064) {
+        return stream.Fail(PARSE_BAD_MAGIC, "header");
+    }
+    if (stream.ReadUnchecked<uint8_t>() != 3) {
+        return stream.Fail(PARSE_BAD_VERSION, "header");
+    }
+    // the material block is small and skipped, the checked reads fail the stream if it's cut short
+    auto numMaterials = stream.Read<uint8_t>();
+    for (uint8_t i = 0; i < numMaterials && stream.Ok(); ++i) {
+        stream.Read<uint8_t>();     // material ID
+        auto numUVSets = stream.Read<uint8_t>();
+        for (uint8_t k = 0; k < numUVSets && stream.Ok(); ++k) {
+            auto numTextures = stream.Read<uint8_t>();
+            for (uint8_t j = 0; j < numTextures && stream.Ok(); ++j) {
+                stream.Read<uint8_t>();     // texture type hint
+                auto l = stream.Read<uint16_t>();    // filename length
+                stream.ReadBytes(nullptr, l);    // filename
+            }
+        }
+        auto numColors = stream.Read<uint8_t>();
+        stream.ReadBytes(nullptr, (sizeof(uint8_t) + sizeof(float) * 4) * numColors);   // color type hint, color
+    }
+    if (!stream.Ok() || !stream.Require(sizeof(uint8_t), "submesh count")) {
+        return false;
+    }
+
+    outDesc->numSubmeshes = stream.ReadUnchecked<uint8_t>();
+    *outSubmeshOffset = stream.offset;
+    uint64_t numVertices = 0;
+    uint64_t numIndices = 0;
+    for (uint32_t i = 0; i < outDesc->numSubmeshes; ++i) {
+        SGMSubmeshHeader header;
+        if (!ReadSGMSubmeshHeader(stream, &header)
+            || !stream.Require(header.vertexSize * header.numVertices + sizeof(uint32_t) + sizeof(uint8_t), "vertices")) {
+            return false;
+        }
+        stream.SkipUnchecked(header.vertexSize * header.numVertices);
+        auto numSubmeshIndices = stream.ReadUnchecked<uint32_t>();
+        auto indexSize = stream.ReadUnchecked<uint8_t>();
+        if (indexSize != sizeof(uint16_t) && indexSize != sizeof(uint32_t)) {
+            return stream.Fail(PARSE_INVALID, "index size");
+        }
+        if (!stream.Require((size_t)indexSize * numSubmeshIndices, "indices")) {
+            return false;
+        }
+        stream.SkipUnchecked((size_t)indexSize * numSubmeshIndices);
+        numVertices += header.numVertices;
+        numIndices += numSubmeshIndices;
+    }
+    if (numVertices > UINT32_MAX || numIndices > UINT32_MAX) {
+        return stream.Fail(PARSE_OUT_OF_RANGE, "vertex or index count");
+    }
+    outDesc->numVertices = (uint32_t)numVertices;
+    outDesc->numIndices = (uint32_t)numIndices;
+    return true;
+}
+
+bool ImportSGM(const char* path, MeshDesc* outDesc, ParseStatus* outStatus)
+{
+    StreamSource source;
+    ByteStream stream;
+    if (!OpenByteStream(path, &source, &stream)) {
+        return false;
+    }
+
+    MeshDesc& meshDesc = *outDesc;
+    meshDesc = MeshDesc();
+    size_t submeshOffset = 0;
+    {   // size the final buffers from the submesh headers first, so every submesh decodes straight into place
+        ByteStream sizingStream = stream;
+        if (!ValidateSGM(sizingStream, &meshDesc, &submeshOffset)) {
+            ReportParseError(path, sizingStream, outStatus);
+            CloseByteStream(&source, &stream);
+            meshDesc = MeshDesc();
+            return false;
+        }
+        ArenaMeasure(&meshDesc.arena, sizeof(Vertex) * meshDesc.numVertices, alignof(Vertex));
+        ArenaMeasure(&meshDesc.arena, sizeof(IndexType) * meshDesc.numIndices, alignof(IndexType));
+        ArenaMeasure(&meshDesc.arena, sizeof(Submesh) * meshDesc.numSubmeshes, alignof(Submesh));
+    }
+    if (!ArenaCommit(&meshDesc.arena)) {
+        printf("%s: out of memory\n", path);
+        CloseByteStream(&source, &stream);
+        meshDesc = MeshDesc();
+        return false;
+    }
+    meshDesc.vertices = ArenaAllocArray<Vertex>(&meshDesc.arena, meshDesc.numVertices);
+    meshDesc.indices = ArenaAllocArray<IndexType>(&meshDesc.arena, meshDesc.numIndices);
+    meshDesc.submeshes = ArenaAllocArray<Submesh>(&meshDesc.arena, meshDesc.numSubmeshes);
+
+    stream.SkipUnchecked(submeshOffset);   // magic number, version, materials, submesh count
+    uint32_t vertexOffset = 0;
+    uint32_t firstIndex = 0;
+    for (uint32_t i = 0; i < meshDesc.numSubmeshes; ++i) {
+        SGMSubmeshHeader header;
+        ReadSGMSubmeshHeader(stream, &header);
+        Vertex* vertices = meshDesc.vertices + vertexOffset;
+        for (uint32_t vtx = 0; vtx < header.numVertices; ++vtx) {     // explicit loop because we convert bone weights
+            auto& vert = vertices[vtx];
+
+            vert.position = stream.ReadUnchecked<math::Vec3>();
+            vert.normal = stream.ReadUnchecked<math::Vec3>();
+            stream.ReadBytesUnchecked(vert.uv, sizeof(float) * 2);
+            vert.tangent = stream.ReadUnchecked<math::Vec4>();   
+            stream.ReadBytesUnchecked(vert.blendWeights, sizeof(float) * 4);
+            for (auto w = 0; w < 4; ++w) {
+                float indexAsFloat = stream.ReadUnchecked<float>();
+                vert.blendIndices[w] = (uint32_t)(indexAsFloat);
+            }
+        }
+
+        // submesh indices are local to its vertices, offset them into the merged vertex buffer
+        auto& submesh = meshDesc.submeshes[i];
+        submesh.firstIndex = firstIndex;
+        submesh.numIndices = stream.ReadUnchecked<uint32_t>();
+        submesh.materialId = header.materialId;
+        firstIndex += submesh.numIndices;
+        IndexType* indices = meshDesc.indices + submesh.firstIndex;
+        auto indexSize = stream.ReadUnchecked<uint8_t>();
+        if (indexSize == 4) {
+            stream.ReadBytesUnchecked(indices, sizeof(IndexType) * submesh.numIndices);
+            for (uint32_t idx = 0; idx < submesh.numIndices; ++idx) {
+                indices[idx] += vertexOffset;
+            }
+        }
+        else {
+            for (uint32_t idx = 0; idx < submesh.numIndices; ++idx) {
+                auto smallIndex = stream.ReadUnchecked<uint16_t>();
+                indices[idx] = (uint32_t)(smallIndex) + vertexOffset;
+            }
+        }
+        vertexOffset += header.numVertices;
+    }
+    CloseByteStream(&source, &stream);
+
+    //
+    uint32_t numUnnormalized = 0;
+    for (auto i = 0u; i < meshDesc.numVertices; ++i) {
+
+        auto weightSum = 0.f;
+        for (auto j = 0; j < 4; ++j) {
+            weightSum += meshDesc.vertices[i].blendWeights[j];
+        }
+        numUnnormalized += math::Abs(1.0f - weightSum) <= 0.00001f ? 0 : 1;
+    }
+    if (numUnnormalized != 0) {
+        printf("%s: blend weights of %u vertices don't add up to 1\n", path, numUnnormalized);
+    }
+
+    BakeMesh(path, &meshDesc);
+
+    return true;
+}
@@ -0,0 +1,212 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "math.h"
+#include "platform/file.h"
+#include "bytestream.h"
+#include "package.h"
+#include "arena.h"
+
+///
+/**
+    Asset types and importers shared by the renderer and the offline cooker (gtcook).
+    Nothing in here may depend on D3D11 or Windows, the cooker builds on Linux.
+    Importers bake their result into a .gtbin next to the source (see gtbin.h), LoadBaked* picks those up again.
+    Sources are validated before anything is decoded (see bytestream.h), malformed files fail the import with the
+    error in outStatus instead of asserting.
+*/
+
+///
+extern Package g_package;   // mounted by AppInit if one was built for the assets
+
+// what a ByteStream opened with OpenByteStream reads from
+struct StreamSource
+{
+    FileMapping file;               // loose files are mapped
+    bool        unpacked = false;   // files found in the mounted package are decompressed into a heap block
+};
+
+// looks the path up in the mounted package first and maps the loose file otherwise, release with CloseByteStream once parsing is done
+bool OpenByteStream(const char* path, StreamSource* outSource, ByteStream* outStream);
+void CloseByteStream(StreamSource* source, ByteStream* stream);
+// prints why stream failed and hands the status to the caller, returns false; call before closing the stream
+bool ReportParseError(const char* path, const ByteStream& stream, ParseStatus* outStatus = nullptr);
+
+///
+struct Vertex
+{
+    math::Vec3  position;
+    math::Vec3  normal;
+    float       uv[2];
+    math::Vec4  tangent;
+    float       blendWeights[4];
+    uint32_t    blendIndices[4];
+};
+
+using IndexType = uint32_t;
+
+// range of the mesh's index buffer drawn with one material
+struct Submesh
+{
+    uint32_t    firstIndex = 0;
+    uint32_t    numIndices = 0;
+    uint32_t    materialId = 0;
+};
+
+struct MeshDesc
+{
+    Vertex*     vertices = nullptr;
+    IndexType*  indices = nullptr;
+    Submesh*    submeshes = nullptr;
+
+    uint32_t    numVertices = 0;
+    uint32_t    numIndices = 0;
+    uint32_t    numSubmeshes = 0;
+
+    Arena       arena;      // holds vertices, indices and submeshes of imported descs
+};
+
+// imported descs own their vertices and indices, baked ones point into the mapping they were loaded from
+void ReleaseMeshDesc(MeshDesc* desc);
+
+struct MeshImportStats
+{
+    uint32_t    numVertices = 0;
+    size_t      vertexBytes = 0;            // of the source's vertex block
+    double      decodeSeconds = 0.0;        // 0 if the decode was too quick for the timer
+    double      perFieldSeconds = 0.0;      // GT_DEVELOPMENT builds only, the per-field reference path on the same block
+};
+
+// fills outStats, if given, with the vertex decode timing, the importer itself reports nothing but parse errors
+bool ImportGTMesh(const char* path, MeshDesc* outDesc, ParseStatus* outStatus = nullptr, MeshImportStats* outStats = nullptr);
+bool ImportSGM(const char* path, MeshDesc* outDesc, ParseStatus* outStatus = nullptr);
+bool LoadBakedMesh(const char* sourcePath, FileMapping* outFile, MeshDesc* outDesc);
+
+///
+#define MAX_NUM_BONES 128
+
+struct Joint
+{
+    float   bindpose[16];   // local space bindpose
+    float   invBindpose[16];
+    float   globalTransform[16];
+    float   localTransform[16];
+    int     importId;   // @HACK
+    int     parent;
+};
+
+struct JointTransform
+{
+    math::Vec3 translation;
+    math::Vec4 rotation;
+};
+
+// joint names are interned into a pool inside the skeleton and found through an open addressed hash map,
+// both only hold offsets, so skeletons can be copied and baked as one block of memory
+#define JOINT_NAME_POOL_SIZE    (MAX_NUM_BONES * 32)
+#define JOINT_NAME_MAP_SIZE     (MAX_NUM_BONES * 2)     // power of two, at most half full
+
+struct JointNames
+{
+    char        pool[JOINT_NAME_POOL_SIZE];     // zero terminated names back to back, each distinct name once
+    uint32_t    poolSize = 0;
+    uint32_t    offsets[MAX_NUM_BONES];         // into pool, per joint
+    uint64_t    hashes[MAX_NUM_BONES];          // of the name, per joint
+    uint8_t     map[JOINT_NAME_MAP_SIZE] = {};  // joint index + 1, 0 marks free slots
+};
+
+struct Skeleton
+{
+    float bindpose[MAX_NUM_BONES][16];      // global space bindposes
+    float invBindpose[MAX_NUM_BONES][16];   // global space inverse bindposes
+    JointNames names;                       // contains human readable names of joints
+    Joint joints[MAX_NUM_BONES];            // actual joints
+    int16_t importRemap[MAX_NUM_BONES];     // sorted joint index per importId, -1 if there is none; built by SortSkeleton
+    uint32_t numJoints;
+};
+
+// transfers the node after its ancestors and records it in target->importRemap, returns its index in target
+uint32_t    TransferNode(Skeleton* source, Skeleton* target, uint32_t& writeOffset, int nodeIdx);
+// orders joints parents first, target is reset
+void        SortSkeleton(Skeleton* source, Skeleton* target);
+
+void        QuatToMatrix(const math::Vec4& quat, float* outMatrix);
+// inverse of QuatToMatrix, expects a pure rotation in the upper 3x3
+math::Vec4  QuatFromMatrix(float* mat);
+
+// names a joint once, joints sharing a name share its characters; returns false if the pool is full
+bool        SetJointName(Skeleton* skeleton, uint32_t jointIdx, const char* name, size_t nameLen);
+const char* GetJointName(Skeleton* skeleton, uint32_t jointIdx);
+
+// returns the first joint with the name
+int GetBoneWithName(Skeleton* skeleton, const char* name);
+// O(1) through importRemap, clips and meshes refer to joints by importId
+int GetBoneWithImportId(Skeleton* skeleton, int importId);
+
+// identifies the joint order clips are remapped to, baked clips are stale once it changes
+uint64_t HashSkeletonLayout(Skeleton* skeleton);
+// loads the sorted skeleton baked by ImportGTSkeleton
+bool LoadBakedSkeleton(const char* sourcePath, Skeleton* outSkeleton);
+// failures are left in stream.status
+bool ImportSkeletonFromMemory(ByteStream& stream, Skeleton* outSkeleton);
+bool ImportSkeletonFromSGA(const char* path, Skeleton* outSkeleton, ParseStatus* outStatus = nullptr);
+bool ImportGTSkeleton(const char* path, Skeleton* outSkeleton, ParseStatus* outStatus = nullptr);
+
+///
+/**
+    A track's keys are split into its times and its keyframes, key k is keyframes[k] at times[k]. Exporters sample
+    every joint at the same frame times, so tracks keyed at the same times share one times array: importers and
+    bakes keep each distinct array of a clip once, and samplers search the keys around a time once per array
+    instead of once per joint.
+*/
+struct Keyframe
+{
+    math::Vec3      position;
+    math::Vec4      rotation;
+};
+
+#define GTANIM_KEYFRAME_SIZE (sizeof(float) + sizeof(math::Vec3) + sizeof(math::Vec4))  // .gtanimclip keys: timestamp, position, rotation
+
+struct BoneTrack
+{
+    uint32_t    numKeyframes = 0;
+    float*      times = nullptr;        // ascending, possibly shared with other tracks of the clip
+    Keyframe*   keyframes = nullptr;
+};
+
+struct AnimationClip
+{
+    char*           name  = nullptr;
+    uint32_t        numTracks = 0;
+    BoneTrack       tracks[MAX_NUM_BONES];
+    float           duration = 0.0f;
+    Arena           arena;      // holds name and keyframes of imported clips
+};
+
+// the keys around a time: prev is the last key at or before it and next the first one after it, both are the
+// first or the last key outside the track; alpha blends from prev to next
+struct KeySpan
+{
+    uint32_t    prev = 0;
+    uint32_t    next = 0;
+    float       alpha = 0.0f;
+};
+
+// binary search, numKeys must not be 0
+KeySpan  FindKeySpan(const float* times, uint32_t numKeys, float time);
+// FindKeySpan resuming at cursor, the prev key of an earlier search on any array, and moving it to the new prev key;
+// playback walks forward from there, a cursor past time or more than KEY_CURSOR_MAX_STEPS behind it searches instead
+#define KEY_CURSOR_MAX_STEPS 4
+KeySpan  AdvanceKeySpan(const float* times, uint32_t numKeys, float time, uint32_t* cursor);
+// the first track of the clip keyed at the same times as track trackIdx, trackIdx itself if there is none
+uint32_t FindSharedTimes(const AnimationClip* clip, uint32_t trackIdx);
+// frees a clip loaded by ImportGTAnimation, baked clips live in their mapping instead
+void ReleaseAnimationClip(AnimationClip* clip);
+
+// loads a clip baked by ImportGTAnimation against the same skeleton, keyframes stay in outFile
+bool LoadBakedAnimation(const char* sourcePath, Skeleton* targetSkeleton, FileMapping* outFile, AnimationClip* outAnimation);
+// bakes clip as the source's bake, for clips processed after import
+bool BakeAnimation(const char* sourcePath, Skeleton* targetSkeleton, AnimationClip* clip);
+bool ImportAnimationFromSGA(const char* path, Skeleton* targetSkeleton, AnimationClip* outAnimations, uint32_t* outNumAnimations);
+bool ImportGTAnimation(const char* path, Skeleton* targetSkeleton, AnimationClip* outAnimation, ParseStatus* outStatus = nullptr);
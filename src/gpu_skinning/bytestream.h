@@ -0,0 +1,119 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+///
+/**
+    Importers parse in two passes. A validating pass walks the section headers with the checked reads, Requires
+    every section it skips and checks counts against the runtime limits. The decoding pass then knows the whole
+    file is in bounds and reads with the unchecked calls, so no per-field checks are left in the hot loops.
+    The first failure is recorded in status and sticks, checked reads past the end of the buffer return zeros.
+*/
+enum ParseError : uint32_t
+{
+    PARSE_OK = 0,
+    PARSE_TRUNCATED,        // a section runs past the end of the buffer
+    PARSE_BAD_MAGIC,
+    PARSE_BAD_VERSION,
+    PARSE_OUT_OF_RANGE,     // a count or index exceeds what the runtime structures hold
+    PARSE_INVALID,          // a value the format doesn't allow
+};
+
+static const char* ParseErrorString(ParseError error)
+{
+    switch (error) {
+    case PARSE_OK:              return "ok";
+    case PARSE_TRUNCATED:       return "truncated";
+    case PARSE_BAD_MAGIC:       return "bad magic number";
+    case PARSE_BAD_VERSION:     return "unsupported version";
+    case PARSE_OUT_OF_RANGE:    return "out of range";
+    case PARSE_INVALID:         return "invalid";
+    }
+    return "unknown error";
+}
+
+struct ParseStatus
+{
+    ParseError  error = PARSE_OK;
+    size_t      offset = 0;         // stream offset the failing section starts at
+    const char* what = nullptr;     // the failing section, a string literal
+};
+
+struct ByteStream
+{
+    const char* buffer = nullptr;
+    size_t      bufferSize = 0;
+    size_t      offset = 0;
+    ParseStatus status;
+
+    template <class T>
+    T Read()
+    {
+        T res;
+        if (ReadBytes(&res, sizeof(res)) != sizeof(res)) {
+            res = T();
+        }
+        return res;
+    }
+
+    // short reads are truncated to the end of the buffer and fail the stream
+    size_t ReadBytes(void* dest, size_t numBytes)
+    {
+        if (numBytes > bufferSize - offset) {
+            Fail(PARSE_TRUNCATED, nullptr);
+            numBytes = bufferSize - offset;
+        }
+        if (dest == nullptr) { offset += numBytes;  return numBytes; };
+        memcpy(dest, buffer + offset, numBytes);
+        offset += numBytes;
+        return numBytes;
+    }
+
+    bool Ok() const
+    {
+        return status.error == PARSE_OK;
+    }
+
+    // records the first failure only, always returns false
+    bool Fail(ParseError error, const char* what)
+    {
+        if (status.error == PARSE_OK) {
+            status.error = error;
+            status.offset = offset;
+            status.what = what;
+        }
+        return false;
+    }
+
+    // checks that numBytes are left, after which they may be read unchecked
+    bool Require(size_t numBytes, const char* what)
+    {
+        if (status.error != PARSE_OK) {
+            return false;
+        }
+        return numBytes <= bufferSize - offset || Fail(PARSE_TRUNCATED, what);
+    }
+
+    // only for bytes a Require covered
+    template <class T>
+    T ReadUnchecked()
+    {
+        T res;
+        memcpy(&res, buffer + offset, sizeof(res));
+        offset += sizeof(res);
+        return res;
+    }
+
+    void ReadBytesUnchecked(void* dest, size_t numBytes)
+    {
+        memcpy(dest, buffer + offset, numBytes);
+        offset += numBytes;
+    }
+
+    void SkipUnchecked(size_t numBytes)
+    {
+        offset += numBytes;
+    }
+};
@@ -0,0 +1,55 @@
+#include "checksum.h"
+
+#include <atomic>
+#include "hash.h"
+#include "platform/timer.h"
+
+#define CHECKSUM_SEED 0x4753554d  // 'GSUM'
+
+static std::atomic<uint32_t> g_checksumMode { CHECKSUM_VERIFY };
+static std::atomic<uint64_t> g_numSectionsVerified { 0 };
+static std::atomic<uint64_t> g_numBytesVerified { 0 };
+static std::atomic<uint64_t> g_numChecksumFailures { 0 };
+static std::atomic<uint64_t> g_verifyTicks { 0 };
+
+uint64_t ComputeChecksum(const void* data, size_t size)
+{
+    return HashXXH64(data, size, CHECKSUM_SEED);
+}
+
+void SetChecksumMode(ChecksumMode mode)
+{
+    g_checksumMode.store(mode, std::memory_order_relaxed);
+}
+
+ChecksumMode GetChecksumMode()
+{
+    return (ChecksumMode)g_checksumMode.load(std::memory_order_relaxed);
+}
+
+bool VerifyChecksum(const void* data, size_t size, uint64_t checksum)
+{
+    auto mode = GetChecksumMode();
+    if (mode == CHECKSUM_OFF) {
+        return true;
+    }
+    uint64_t start = mode == CHECKSUM_VERIFY_TIMED ? GetTicks() : 0;
+    bool valid = ComputeChecksum(data, size) == checksum;
+    if (mode == CHECKSUM_VERIFY_TIMED) {
+        g_verifyTicks.fetch_add(GetTicks() - start, std::memory_order_relaxed);
+    }
+    g_numSectionsVerified.fetch_add(1, std::memory_order_relaxed);
+    g_numBytesVerified.fetch_add(size, std::memory_order_relaxed);
+    if (!valid) {
+        g_numChecksumFailures.fetch_add(1, std::memory_order_relaxed);
+    }
+    return valid;
+}
+
+void GetChecksumStats(ChecksumStats* outStats)
+{
+    outStats->numSections = g_numSectionsVerified.load(std::memory_order_relaxed);
+    outStats->numBytes = g_numBytesVerified.load(std::memory_order_relaxed);
+    outStats->numFailures = g_numChecksumFailures.load(std::memory_order_relaxed);
+    outStats->seconds = TicksToSeconds(g_verifyTicks.load(std::memory_order_relaxed));
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+///
+/**
+    Section checksums for the formats we write ourselves (.gtbin sections, .gtpak chunks).
+    Sections are hashed with XXH64, whose four independent lanes keep up with memory bandwidth, so verifying on
+    every load is cheap enough to leave on. In CHECKSUM_VERIFY_TIMED every verification is also timed, the totals
+    are what GetChecksumStats reports.
+*/
+enum ChecksumMode : uint32_t
+{
+    CHECKSUM_OFF,
+    CHECKSUM_VERIFY,
+    CHECKSUM_VERIFY_TIMED,
+};
+
+struct ChecksumStats
+{
+    uint64_t    numSections = 0;
+    uint64_t    numBytes = 0;
+    uint64_t    numFailures = 0;
+    double      seconds = 0.0;      // only counts verifications done in CHECKSUM_VERIFY_TIMED
+};
+
+uint64_t        ComputeChecksum(const void* data, size_t size);
+
+// defaults to CHECKSUM_VERIFY, safe to change while loads are running
+void            SetChecksumMode(ChecksumMode mode);
+ChecksumMode    GetChecksumMode();
+
+// true if the section matches or verification is off
+bool            VerifyChecksum(const void* data, size_t size, uint64_t checksum);
+void            GetChecksumStats(ChecksumStats* outStats);
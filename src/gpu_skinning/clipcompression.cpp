@@ -0,0 +1,596 @@
+#include "clipcompression.h"
+#include "clipmetric.h"
+#include "gtbin.h"
+#include "hash.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+///
+#define SMALLEST_THREE_RANGE    0.70710678f     // bound of all but the largest component of a unit quaternion
+#define MAX_KEY_BITS            (2 + 6 * MAX_COMPRESSED_BITS)
+
+static uint32_t QuantizeUnit(float value, uint32_t numBits)
+{
+    uint32_t maxValue = (1u << numBits) - 1;
+    return (uint32_t)(math::Clamp(value, 0.0f, 1.0f) * (float)maxValue + 0.5f);
+}
+
+static float DequantizeUnit(uint32_t value, uint32_t numBits)
+{
+    return (float)value / (float)((1u << numBits) - 1);
+}
+
+// count <= 32, words must hold a word past the one the last bit is in
+static uint32_t ReadBits(const uint32_t* words, uint32_t bitOffset, uint32_t count)
+{
+    const uint32_t* word = words + (bitOffset >> 5);
+    uint64_t window = (uint64_t)word[0] | ((uint64_t)word[1] << 32);
+    return (uint32_t)(window >> (bitOffset & 31)) & (uint32_t)((1ull << count) - 1);
+}
+
+// the bits written to must be clear
+static void WriteBits(uint32_t* words, uint32_t bitOffset, uint32_t value, uint32_t count)
+{
+    uint64_t shifted = (uint64_t)(value & (uint32_t)((1ull << count) - 1)) << (bitOffset & 31);
+    uint32_t* word = words + (bitOffset >> 5);
+    word[0] |= (uint32_t)shifted;
+    word[1] |= (uint32_t)(shifted >> 32);
+}
+
+static void EncodeRotation(math::Vec4 rotation, uint32_t numBits, uint32_t* words, uint32_t bitOffset)
+{
+    rotation = math::Normalize(rotation);
+    uint32_t largest = 0;
+    for (uint32_t i = 1; i < 4; ++i) {
+        if (math::Abs(rotation[i]) > math::Abs(rotation[largest])) { largest = i; }
+    }
+    if (rotation[largest] < 0.0f) {
+        rotation = -rotation;
+    }
+    WriteBits(words, bitOffset, largest, 2);
+    bitOffset += 2;
+    for (uint32_t i = 0; i < 4; ++i) {
+        if (i != largest) {
+            WriteBits(words, bitOffset, QuantizeUnit(rotation[i] / SMALLEST_THREE_RANGE * 0.5f + 0.5f, numBits), numBits);
+            bitOffset += numBits;
+        }
+    }
+}
+
+static math::Vec4 DecodeRotation(const uint32_t* words, uint32_t bitOffset, uint32_t numBits)
+{
+    uint32_t largest = ReadBits(words, bitOffset, 2);
+    bitOffset += 2;
+    math::Vec4 rotation;
+    float sumOfSquares = 0.0f;
+    for (uint32_t i = 0; i < 4; ++i) {
+        if (i == largest) {
+            continue;
+        }
+        float component = (DequantizeUnit(ReadBits(words, bitOffset, numBits), numBits) * 2.0f - 1.0f) * SMALLEST_THREE_RANGE;
+        rotation[i] = component;
+        sumOfSquares += component * component;
+        bitOffset += numBits;
+    }
+    rotation[largest] = sqrtf(math::Max(0.0f, 1.0f - sumOfSquares));
+    return rotation;
+}
+
+static void EncodeTranslation(const CompressedTrack& track, const math::Vec3& translation, uint32_t numBits, uint32_t* words, uint32_t bitOffset)
+{
+    for (int i = 0; i < 3; ++i) {
+        float extent = track.translationExtent[i];
+        uint32_t value = extent > 0.0f ? QuantizeUnit((translation[i] - track.translationMin[i]) / extent, numBits) : 0;
+        WriteBits(words, bitOffset + i * numBits, value, numBits);
+    }
+}
+
+static math::Vec3 DecodeTranslation(const CompressedTrack& track, const uint32_t* words, uint32_t bitOffset, uint32_t numBits)
+{
+    math::Vec3 translation;
+    for (int i = 0; i < 3; ++i) {
+        translation[i] = track.translationMin[i] + DequantizeUnit(ReadBits(words, bitOffset + i * numBits, numBits), numBits) * track.translationExtent[i];
+    }
+    return translation;
+}
+
+static void DecodeKeyframe(const CompressedTrack* track, uint32_t keyIdx, math::Vec3* outTranslation, math::Vec4* outRotation)
+{
+    auto& segment = track->segments[keyIdx / COMPRESSED_SEGMENT_KEYS];
+    uint32_t bitOffset = segment.bitOffset + (keyIdx % COMPRESSED_SEGMENT_KEYS) * segment.keyBits;
+    if (track->flags & TRACK_CONSTANT_ROTATION) {
+        *outRotation = track->rotation;
+    }
+    else {
+        *outRotation = DecodeRotation(track->bits, bitOffset, segment.rotationBits);
+        bitOffset += 2 + 3 * segment.rotationBits;
+    }
+    if (track->flags & TRACK_CONSTANT_TRANSLATION) {
+        *outTranslation = track->translationMin;
+    }
+    else {
+        *outTranslation = DecodeTranslation(*track, track->bits, bitOffset, segment.translationBits);
+    }
+}
+
+// (re)writes the segment at the bit rates, it must be the last one written so far
+static void EncodeSegment(CompressedTrack* track, const Keyframe* keys, uint32_t segmentIdx, uint32_t rotationBits, uint32_t translationBits)
+{
+    bool constantRotation = (track->flags & TRACK_CONSTANT_ROTATION) != 0;
+    bool constantTranslation = (track->flags & TRACK_CONSTANT_TRANSLATION) != 0;
+    auto& segment = track->segments[segmentIdx];
+    segment.rotationBits = (uint8_t)rotationBits;
+    segment.translationBits = (uint8_t)translationBits;
+    segment.keyBits = (uint16_t)((constantRotation ? 0 : 2 + 3 * rotationBits) + (constantTranslation ? 0 : 3 * translationBits));
+
+    uint32_t firstKey = segmentIdx * COMPRESSED_SEGMENT_KEYS;
+    uint32_t lastKey = math::Min(track->numKeyframes, firstKey + COMPRESSED_SEGMENT_KEYS);
+    uint32_t firstWord = segment.bitOffset >> 5;
+    uint32_t endWord = (segment.bitOffset + (lastKey - firstKey) * MAX_KEY_BITS + 31) / 32 + 1;
+    track->bits[firstWord] &= (1u << (segment.bitOffset & 31)) - 1;
+    memset(track->bits + firstWord + 1, 0, sizeof(uint32_t) * (endWord - firstWord - 1));
+    for (uint32_t k = firstKey; k < lastKey; ++k) {
+        uint32_t bitOffset = segment.bitOffset + (k - firstKey) * segment.keyBits;
+        if (!constantRotation) {
+            EncodeRotation(keys[k].rotation, rotationBits, track->bits, bitOffset);
+            bitOffset += 2 + 3 * rotationBits;
+        }
+        if (!constantTranslation) {
+            EncodeTranslation(*track, keys[k].position, translationBits, track->bits, bitOffset);
+        }
+    }
+}
+
+///
+static bool IsOnFrameGrid(const AnimationClip* clip, float frameRate)
+{
+    for (uint32_t i = 0; i < MAX_NUM_BONES; ++i) {
+        auto& track = clip->tracks[i];
+        for (uint32_t k = 0; k < track.numKeyframes; ++k) {
+            float frame = track.times[k] * frameRate;
+            if (frame < -0.5f || frame > MAX_COMPRESSED_FRAME || math::Abs(frame - roundf(frame)) > 0.05f) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// the lowest frame rate all keyframe times are multiples of, 0 if there is none
+static float FindFrameRate(const AnimationClip* clip)
+{
+    float minDelta = 0.0f;
+    for (uint32_t i = 0; i < MAX_NUM_BONES; ++i) {
+        auto& track = clip->tracks[i];
+        for (uint32_t k = 1; k < track.numKeyframes; ++k) {
+            float delta = track.times[k] - track.times[k - 1];
+            if (delta > 0.0f && (minDelta == 0.0f || delta < minDelta)) { minDelta = delta; }
+        }
+    }
+    if (minDelta == 0.0f) {     // nothing but single keys, any rate does
+        return 30.0f;
+    }
+    // keys may skip frames, so the smallest step isn't necessarily a single frame
+    const float commonRates[] = { 24.0f, 25.0f, 30.0f, 48.0f, 50.0f, 60.0f, 120.0f };
+    float stepRate = roundf(1.0f / minDelta);
+    if (stepRate >= 1.0f && IsOnFrameGrid(clip, stepRate)) {
+        return stepRate;
+    }
+    for (float frameRate : commonRates) {
+        if (IsOnFrameGrid(clip, frameRate)) {
+            return frameRate;
+        }
+    }
+    return 0.0f;
+}
+
+///
+struct BitRateSearch
+{
+    const AnimationClip*    source = nullptr;
+    CompressionSettings     settings;
+    ClipErrorMetric         metric;
+    float                   frameRate = 0.0f;
+    CompressedTrack         tracks[MAX_NUM_BONES];  // bit streams sized for the highest bit rates
+    float                   budgets[MAX_NUM_BONES]; // of maxError, per joint including its ancestors
+    Arena                   scratch;                // holds the tracks' arrays
+};
+
+// model space transform of the joint at the key time, through the quantized tracks of the joint and its ancestors or
+// the source's; quantized tracks are sampled at the frame the key was snapped to, retiming isn't error
+static JointTransform ModelTransform(const BitRateSearch* search, int jointIdx, float time, bool quantized)
+{
+    JointTransform model;
+    model.rotation = math::Vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    int chain[MAX_NUM_BONES];
+    int depth = 0;
+    for (int i = jointIdx; i != -1; i = search->metric.skeleton->joints[i].parent) {
+        chain[depth++] = i;
+    }
+    while (depth > 0) {
+        int i = chain[--depth];
+        JointTransform sampled = search->metric.bindLocal[i];
+        if (quantized && search->tracks[i].numKeyframes != 0) {
+            SampleCompressedTrack(&search->tracks[i], roundf(time * search->frameRate), &sampled.translation, &sampled.rotation);
+        }
+        else if (!quantized && search->source->tracks[i].numKeyframes != 0) {
+            auto& source = search->source->tracks[i];
+            SampleKeyframes(source.times, source.keyframes, source.numKeyframes, time, &sampled);
+        }
+        model = ComposeJointTransforms(model, LocalJointTransform(&search->metric, i, sampled));
+    }
+    return model;
+}
+
+bool BeginCompressClip(const AnimationClip* clip, Skeleton* skeleton, const CompressionSettings& settings, BitRateSearch** outSearch)
+{
+    float frameRate = FindFrameRate(clip);
+    if (frameRate == 0.0f) {
+        printf("%s: keyframes aren't on a fixed frame grid, the clip can't be compressed\n", clip->name);
+        return false;
+    }
+    for (uint32_t i = 0; i < MAX_NUM_BONES; ++i) {
+        auto& track = clip->tracks[i];
+        for (uint32_t k = 0; k < track.numKeyframes; ++k) {
+            if (math::Abs(math::Length(track.keyframes[k].rotation) - 1.0f) > 0.001f) {
+                printf("%s: rotations aren't unit quaternions, the clip can't be compressed\n", clip->name);
+                return false;
+            }
+        }
+    }
+    BitRateSearch* search = new BitRateSearch();
+    search->source = clip;
+    search->settings = settings;
+    search->frameRate = frameRate;
+    InitClipErrorMetric(&search->metric, clip, skeleton, settings.vertexDistance);
+
+    // a joint may add its share of maxError to what its ancestors already spend, every chain from the root to a
+    // leaf has maxError to spend in total and a parent can't leave its children without
+    uint32_t depths[MAX_NUM_BONES];
+    uint32_t heights[MAX_NUM_BONES] = {};
+    for (uint32_t i = 0; i < skeleton->numJoints; ++i) {
+        int parent = skeleton->joints[i].parent;
+        depths[i] = parent != -1 ? depths[parent] + 1 : 0;
+    }
+    for (uint32_t i = skeleton->numJoints; i-- > 1;) {
+        int parent = skeleton->joints[i].parent;
+        if (parent != -1) {
+            heights[parent] = math::Max(heights[parent], heights[i] + 1);
+        }
+    }
+    for (uint32_t i = 0; i < skeleton->numJoints; ++i) {
+        search->budgets[i] = settings.maxError * (float)(depths[i] + 1) / (float)(depths[i] + heights[i] + 1);
+    }
+
+    // pick the constant parts and translation ranges of every track first, the scratch block is sized from them
+    for (uint32_t i = 0; i < skeleton->numJoints; ++i) {
+        auto& source = clip->tracks[i];
+        auto& track = search->tracks[i];
+        if (source.numKeyframes == 0) {
+            continue;
+        }
+        track.numKeyframes = source.numKeyframes;
+        uint32_t firstRotation[3] = {};
+        EncodeRotation(source.keyframes[0].rotation, MAX_COMPRESSED_BITS, firstRotation, 0);
+        math::Vec3 minTranslation = source.keyframes[0].position;
+        math::Vec3 maxTranslation = minTranslation;
+        bool constantRotation = true;
+        for (uint32_t k = 1; k < source.numKeyframes; ++k) {
+            auto& key = source.keyframes[k];
+            if (source.times[k] < source.times[k - 1]) {
+                printf("%s: keyframes out of order, the clip can't be compressed\n", clip->name);
+                delete search;
+                return false;
+            }
+            uint32_t rotation[3] = {};
+            EncodeRotation(key.rotation, MAX_COMPRESSED_BITS, rotation, 0);
+            constantRotation &= memcmp(rotation, firstRotation, sizeof(rotation)) == 0;
+            for (int c = 0; c < 3; ++c) {
+                minTranslation[c] = math::Min(minTranslation[c], key.position[c]);
+                maxTranslation[c] = math::Max(maxTranslation[c], key.position[c]);
+            }
+        }
+        track.rotation = math::Normalize(source.keyframes[0].rotation);
+        track.translationMin = minTranslation;
+        track.translationExtent = maxTranslation - minTranslation;
+        bool constantTranslation = track.translationExtent.x == 0.0f && track.translationExtent.y == 0.0f && track.translationExtent.z == 0.0f;
+        track.flags = (constantRotation ? (uint32_t)TRACK_CONSTANT_ROTATION : 0u) | (constantTranslation ? (uint32_t)TRACK_CONSTANT_TRANSLATION : 0u);
+        track.numBitWords = (track.numKeyframes * MAX_KEY_BITS + 31) / 32 + 1;
+
+        uint32_t numSegments = (track.numKeyframes + COMPRESSED_SEGMENT_KEYS - 1) / COMPRESSED_SEGMENT_KEYS;
+        ArenaMeasure(&search->scratch, sizeof(uint16_t) * track.numKeyframes, alignof(uint16_t));
+        ArenaMeasure(&search->scratch, sizeof(CompressedSegment) * numSegments, alignof(CompressedSegment));
+        ArenaMeasure(&search->scratch, sizeof(uint32_t) * track.numBitWords, alignof(uint32_t));
+    }
+    if (!ArenaCommit(&search->scratch)) {
+        printf("%s: out of memory\n", clip->name);
+        delete search;
+        return false;
+    }
+    for (uint32_t i = 0; i < skeleton->numJoints; ++i) {
+        auto& source = clip->tracks[i];
+        auto& track = search->tracks[i];
+        if (track.numKeyframes == 0) {
+            continue;
+        }
+        uint32_t numSegments = (track.numKeyframes + COMPRESSED_SEGMENT_KEYS - 1) / COMPRESSED_SEGMENT_KEYS;
+        track.frames = ArenaAllocArray<uint16_t>(&search->scratch, track.numKeyframes);
+        track.segments = ArenaAllocArray<CompressedSegment>(&search->scratch, numSegments);
+        track.bits = ArenaAllocArray<uint32_t>(&search->scratch, track.numBitWords);
+        for (uint32_t k = 0; k < track.numKeyframes; ++k) {
+            track.frames[k] = (uint16_t)roundf(source.times[k] * frameRate);
+        }
+        for (uint32_t s = 0; s < numSegments; ++s) {
+            track.segments[s] = CompressedSegment();
+        }
+        memset(track.bits, 0, sizeof(uint32_t) * track.numBitWords);
+    }
+    *outSearch = search;
+    return true;
+}
+
+// tries bit rates from the lowest up per segment, rotations first with full precision translations
+void SearchTrackBitRates(BitRateSearch* search, uint32_t jointIdx)
+{
+    auto& track = search->tracks[jointIdx];
+    auto& source = search->source->tracks[jointIdx];
+    if (track.numKeyframes == 0) {
+        return;
+    }
+    int parent = search->metric.skeleton->joints[jointIdx].parent;
+    JointTransform identity;
+    identity.rotation = math::Vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    JointTransform* parentModels = new JointTransform[track.numKeyframes];
+    JointTransform* sourceModels = new JointTransform[track.numKeyframes];
+    for (uint32_t k = 0; k < track.numKeyframes; ++k) {
+        float time = source.times[k];
+        JointTransform sourceParent = parent != -1 ? ModelTransform(search, parent, time, false) : identity;
+        parentModels[k] = parent != -1 ? ModelTransform(search, parent, time, true) : identity;
+        JointTransform local;
+        local.translation = source.keyframes[k].position;
+        local.rotation = source.keyframes[k].rotation;
+        sourceModels[k] = ComposeJointTransforms(sourceParent, LocalJointTransform(&search->metric, jointIdx, local));
+    }
+
+    float shell = search->metric.shellDistance[jointIdx];
+    bool constantRotation = (track.flags & TRACK_CONSTANT_ROTATION) != 0;
+    bool constantTranslation = (track.flags & TRACK_CONSTANT_TRANSLATION) != 0;
+    uint32_t numSegments = (track.numKeyframes + COMPRESSED_SEGMENT_KEYS - 1) / COMPRESSED_SEGMENT_KEYS;
+    uint32_t bitOffset = 0;
+    for (uint32_t s = 0; s < numSegments; ++s) {
+        uint32_t firstKey = s * COMPRESSED_SEGMENT_KEYS;
+        uint32_t lastKey = math::Min(track.numKeyframes, firstKey + COMPRESSED_SEGMENT_KEYS);
+        track.segments[s].bitOffset = bitOffset;
+        auto Fits = [&](uint32_t rotationBits, uint32_t translationBits) -> bool {
+            EncodeSegment(&track, source.keyframes, s, rotationBits, translationBits);
+            for (uint32_t k = firstKey; k < lastKey; ++k) {
+                JointTransform sampled;
+                DecodeKeyframe(&track, k, &sampled.translation, &sampled.rotation);
+                JointTransform model = ComposeJointTransforms(parentModels[k], LocalJointTransform(&search->metric, jointIdx, sampled));
+                if (ModelSpaceError(model, sourceModels[k], shell) > search->budgets[jointIdx]) {
+                    return false;
+                }
+            }
+            return true;
+        };
+        // keys the quantized ancestors already push past the budget get the highest rates
+        uint32_t rotationBits = constantRotation ? 0 : MAX_COMPRESSED_BITS;
+        uint32_t translationBits = constantTranslation ? 0 : MAX_COMPRESSED_BITS;
+        for (uint32_t bits = MIN_COMPRESSED_BITS; !constantRotation && bits < MAX_COMPRESSED_BITS; ++bits) {
+            if (Fits(bits, translationBits)) {
+                rotationBits = bits;
+                break;
+            }
+        }
+        for (uint32_t bits = MIN_COMPRESSED_BITS; !constantTranslation && bits < MAX_COMPRESSED_BITS; ++bits) {
+            if (Fits(rotationBits, bits)) {
+                translationBits = bits;
+                break;
+            }
+        }
+        EncodeSegment(&track, source.keyframes, s, rotationBits, translationBits);
+        bitOffset += track.segments[s].keyBits * (lastKey - firstKey);
+    }
+    track.numBitWords = (bitOffset + 31) / 32 + 1;
+    delete[] sourceModels;
+    delete[] parentModels;
+}
+
+bool EndCompressClip(BitRateSearch* search, CompressedClip* outClip, CompressionStats* outStats)
+{
+    auto clip = search->source;
+    auto skeleton = search->metric.skeleton;
+    auto& compressed = *outClip;
+    CompressionStats stats;
+    size_t nameLen = strlen(clip->name);
+    ArenaMeasure(&compressed.arena, nameLen + 1, 1);
+    for (uint32_t i = 0; i < skeleton->numJoints; ++i) {
+        auto& track = search->tracks[i];
+        if (track.numKeyframes == 0) {
+            continue;
+        }
+        uint32_t numSegments = (track.numKeyframes + COMPRESSED_SEGMENT_KEYS - 1) / COMPRESSED_SEGMENT_KEYS;
+        ArenaMeasure(&compressed.arena, sizeof(uint16_t) * track.numKeyframes, alignof(uint16_t));
+        ArenaMeasure(&compressed.arena, sizeof(CompressedSegment) * numSegments, alignof(CompressedSegment));
+        ArenaMeasure(&compressed.arena, sizeof(uint32_t) * track.numBitWords, alignof(uint32_t));
+        stats.rawBytes += sizeof(Keyframe) * track.numKeyframes + (FindSharedTimes(clip, i) == i ? sizeof(float) * track.numKeyframes : 0);
+        stats.compressedBytes += sizeof(uint16_t) * track.numKeyframes + sizeof(CompressedSegment) * numSegments + sizeof(uint32_t) * track.numBitWords;
+
+        // measure what the quantization cost at the keys themselves
+        for (uint32_t k = 0; k < track.numKeyframes; ++k) {
+            float time = clip->tracks[i].times[k];
+            JointTransform source = ModelTransform(search, (int)i, time, false);
+            JointTransform model = ModelTransform(search, (int)i, time, true);
+            stats.maxError = math::Max(stats.maxError, ModelSpaceError(model, source, search->settings.vertexDistance));
+        }
+    }
+    bool success = ArenaCommit(&compressed.arena);
+    if (success) {
+        compressed.name = ArenaAllocArray<char>(&compressed.arena, nameLen + 1);
+        memcpy(compressed.name, clip->name, nameLen + 1);
+        compressed.numTracks = clip->numTracks;
+        compressed.duration = clip->duration;
+        compressed.frameRate = search->frameRate;
+        for (uint32_t i = 0; i < skeleton->numJoints; ++i) {
+            auto& source = search->tracks[i];
+            auto& track = compressed.tracks[i];
+            if (source.numKeyframes == 0) {
+                continue;
+            }
+            uint32_t numSegments = (source.numKeyframes + COMPRESSED_SEGMENT_KEYS - 1) / COMPRESSED_SEGMENT_KEYS;
+            track = source;
+            track.frames = ArenaAllocArray<uint16_t>(&compressed.arena, track.numKeyframes);
+            track.segments = ArenaAllocArray<CompressedSegment>(&compressed.arena, numSegments);
+            track.bits = ArenaAllocArray<uint32_t>(&compressed.arena, track.numBitWords);
+            memcpy(track.frames, source.frames, sizeof(uint16_t) * track.numKeyframes);
+            memcpy(track.segments, source.segments, sizeof(CompressedSegment) * numSegments);
+            memcpy(track.bits, source.bits, sizeof(uint32_t) * track.numBitWords);
+        }
+    }
+    else {
+        printf("%s: out of memory\n", clip->name);
+        compressed = CompressedClip();
+    }
+    ArenaRelease(&search->scratch);
+    delete search;
+    if (success && outStats != nullptr) {
+        *outStats = stats;
+    }
+    return success;
+}
+
+bool CompressClip(const AnimationClip* clip, Skeleton* skeleton, const CompressionSettings& settings, CompressedClip* outClip, CompressionStats* outStats)
+{
+    BitRateSearch* search = nullptr;
+    if (!BeginCompressClip(clip, skeleton, settings, &search)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < skeleton->numJoints; ++i) {    // sorted skeletons list parents first
+        SearchTrackBitRates(search, i);
+    }
+    return EndCompressClip(search, outClip, outStats);
+}
+
+void ReleaseCompressedClip(CompressedClip* clip)
+{
+    ArenaRelease(&clip->arena);
+    *clip = CompressedClip();
+}
+
+// same keys as the ComputeLocalPoses for whole clips: the last one at or before frame and the one after it
+void SampleCompressedTrack(const CompressedTrack* track, float frame, math::Vec3* outTranslation, math::Vec4* outRotation)
+{
+    uint32_t first = 0;
+    uint32_t count = track->numKeyframes;
+    while (count > 0) {     // first key after frame
+        uint32_t step = count / 2;
+        if ((float)track->frames[first + step] <= frame) {
+            first += step + 1;
+            count -= step + 1;
+        }
+        else {
+            count = step;
+        }
+    }
+    uint32_t next = first < track->numKeyframes ? first : track->numKeyframes - 1;
+    uint32_t prev = first > 0 ? first - 1 : 0;
+    if (prev == next) {
+        DecodeKeyframe(track, prev, outTranslation, outRotation);
+        return;
+    }
+    float alpha = (frame - (float)track->frames[prev]) / (float)(track->frames[next] - track->frames[prev]);
+    math::Vec3 prevTranslation, nextTranslation;
+    math::Vec4 prevRotation, nextRotation;
+    DecodeKeyframe(track, prev, &prevTranslation, &prevRotation);
+    DecodeKeyframe(track, next, &nextTranslation, &nextRotation);
+    *outTranslation = (track->flags & TRACK_CONSTANT_TRANSLATION) ? prevTranslation : math::Lerp(prevTranslation, nextTranslation, alpha);
+    *outRotation = (track->flags & TRACK_CONSTANT_ROTATION) ? prevRotation : math::Slerp(prevRotation, nextRotation, alpha);
+}
+
+///
+// the joint order the tracks were remapped to and the encoding, either one changing makes the bake stale
+static uint64_t HashCompressedClipDependencies(Skeleton* targetSkeleton)
+{
+    uint32_t version = CLIP_COMPRESSION_VERSION;
+    return HashFNV1a64(&version, sizeof(version), HashSkeletonLayout(targetSkeleton));
+}
+
+bool BakeCompressedClip(const char* sourcePath, Skeleton* targetSkeleton, CompressedClip* clip)
+{
+    char bakedPath[512];
+    GTBinSource source;
+    if (!GTBinPathFor(sourcePath, bakedPath, sizeof(bakedPath), "q") || !GTBinSourceFor(sourcePath, HashCompressedClipDependencies(targetSkeleton), &source)) {
+        return false;
+    }
+    GTBinWriter writer;
+    GTBinBegin(&writer);
+    // a zeroed copy of the clip's fields, padding included, so bakes of the same source are identical; the arena
+    // stays empty, baked clips live in their mapping
+    auto root = GTBinAlloc(&writer, sizeof(CompressedClip), 16);
+    auto baked = static_cast<CompressedClip*>(GTBinAt(&writer, root));
+    baked->numTracks = clip->numTracks;
+    baked->duration = clip->duration;
+    baked->frameRate = clip->frameRate;
+    for (uint32_t i = 0; i < MAX_NUM_BONES; ++i) {
+        auto& track = clip->tracks[i];
+        baked->tracks[i].numKeyframes = track.numKeyframes;
+        baked->tracks[i].flags = track.flags;
+        baked->tracks[i].numBitWords = track.numBitWords;
+        baked->tracks[i].rotation = track.rotation;
+        baked->tracks[i].translationMin = track.translationMin;
+        baked->tracks[i].translationExtent = track.translationExtent;
+    }
+    auto name = GTBinWrite(&writer, clip->name, strlen(clip->name) + 1, 1);
+    GTBinPointer(&writer, root + offsetof(CompressedClip, name), name);
+    for (uint32_t i = 0; i < MAX_NUM_BONES; ++i) {
+        auto& track = clip->tracks[i];
+        if (track.numKeyframes == 0) {
+            continue;
+        }
+        auto trackOffset = root + offsetof(CompressedClip, tracks) + i * sizeof(CompressedTrack);
+        size_t numSegments = (track.numKeyframes + COMPRESSED_SEGMENT_KEYS - 1) / COMPRESSED_SEGMENT_KEYS;
+        GTBinPointer(&writer, trackOffset + offsetof(CompressedTrack, frames), GTBinWrite(&writer, track.frames, sizeof(uint16_t) * track.numKeyframes, alignof(uint16_t)));
+        GTBinPointer(&writer, trackOffset + offsetof(CompressedTrack, segments), GTBinWrite(&writer, track.segments, sizeof(CompressedSegment) * numSegments, alignof(CompressedSegment)));
+        GTBinPointer(&writer, trackOffset + offsetof(CompressedTrack, bits), GTBinWrite(&writer, track.bits, sizeof(uint32_t) * track.numBitWords, alignof(uint32_t)));
+    }
+    return GTBinFinish(&writer, bakedPath, GTBIN_COMPRESSED_CLIP, source, root);
+}
+
+bool LoadBakedCompressedClip(const char* sourcePath, Skeleton* targetSkeleton, FileMapping* outFile, CompressedClip* outClip)
+{
+    char bakedPath[512];
+    GTBinSource source;
+    if (!GTBinPathFor(sourcePath, bakedPath, sizeof(bakedPath), "q") || !GTBinSourceFor(sourcePath, HashCompressedClipDependencies(targetSkeleton), &source)) {
+        return false;
+    }
+    void* root = nullptr;
+    if (!GTBinLoad(bakedPath, GTBIN_COMPRESSED_CLIP, sizeof(CompressedClip), source, outFile, &root)) {
+        return false;
+    }
+    memcpy(outClip, root, sizeof(CompressedClip));
+    return true;
+}
+
+bool ImportCompressedClip(const char* path, Skeleton* targetSkeleton, CompressedClip* outClip, CompressionStats* outStats)
+{
+    AnimationClip* clip = new AnimationClip();
+    FileMapping bakedFile;
+    bool baked = LoadBakedAnimation(path, targetSkeleton, &bakedFile, clip);
+    if (!baked && !ImportGTAnimation(path, targetSkeleton, clip)) {
+        delete clip;
+        return false;
+    }
+    bool success = CompressClip(clip, targetSkeleton, CompressionSettings(), outClip, outStats);
+    if (baked) {
+        UnmapFile(&bakedFile);
+    }
+    else {
+        ReleaseAnimationClip(clip);
+    }
+    delete clip;
+    if (success) {
+        BakeCompressedClip(path, targetSkeleton, outClip);
+    }
+    return success;
+}
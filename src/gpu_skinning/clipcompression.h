@@ -0,0 +1,99 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "assets.h"
+
+///
+/**
+    Compressed clips
+    CompressClip quantizes an imported clip's keyframes:
+        frames          keyframe times as 16 bit frame indices at the clip's frame rate
+        rotations       smallest three: the index of the largest component in 2 bits and the other three at the
+                        segment's rotation bit rate each, the largest one is rebuilt from the unit length
+        translations    3 components at the segment's translation bit rate, normalized to the track's range
+    Each track is cut into segments of COMPRESSED_SEGMENT_KEYS keyframes with bit rates of their own, packed back to
+    back into one bit stream per track. The bit rates of every segment are the lowest ones that keep the hierarchical
+    error (see clipmetric.h) under maxError, searched parents first against the already quantized ancestors, so a
+    spine joint ends up with more bits than a finger.
+    Tracks whose rotation or translation never changes store it once at full precision. Quaternions are flipped into
+    the hemisphere of their largest component, Slerp takes the short way between keys anyway.
+    Compressed clips are baked next to the source like everything else, as <source>.q.gtbin.
+*/
+#define CLIP_COMPRESSION_VERSION    2   // part of the baked clip's dependency hash, bump when the encoding changes
+#define MAX_COMPRESSED_FRAME        0xffff
+#define COMPRESSED_SEGMENT_KEYS     32
+#define MIN_COMPRESSED_BITS         3
+#define MAX_COMPRESSED_BITS         16
+
+enum CompressedTrackFlags : uint32_t
+{
+    TRACK_CONSTANT_ROTATION     = 1 << 0,   // rotation is the rotation, segments hold no rotations
+    TRACK_CONSTANT_TRANSLATION  = 1 << 1,   // translationMin is the translation, segments hold no translations
+};
+
+struct CompressedSegment
+{
+    uint32_t    bitOffset = 0;              // of the segment's first keyframe in the track's bit stream
+    uint8_t     rotationBits = 0;           // per smallest three component, 0 for constant rotations
+    uint8_t     translationBits = 0;        // per component, 0 for constant translations
+    uint16_t    keyBits = 0;                // per keyframe
+};
+
+struct CompressedTrack
+{
+    uint32_t            numKeyframes = 0;
+    uint32_t            flags = 0;
+    uint16_t*           frames = nullptr;       // per keyframe, ascending
+    CompressedSegment*  segments = nullptr;     // per COMPRESSED_SEGMENT_KEYS keyframes
+    uint32_t*           bits = nullptr;         // keyframes at their segment's bit rates, lowest bits first
+    uint32_t            numBitWords = 0;        // words in bits, the last one is padding for reads past the end
+    math::Vec4          rotation;
+    math::Vec3          translationMin;
+    math::Vec3          translationExtent;      // per component, 0 if the component never changes
+};
+
+struct CompressedClip
+{
+    char*           name = nullptr;
+    uint32_t        numTracks = 0;
+    CompressedTrack tracks[MAX_NUM_BONES];
+    float           duration = 0.0f;
+    float           frameRate = 0.0f;       // frames per second of the frame indices
+    Arena           arena;                  // holds name and track data of compressed clips
+};
+
+struct CompressionSettings
+{
+    float       maxError = 0.0005f;         // hierarchical error at the keyframes, in the units of the skeleton (meters)
+    float       vertexDistance = 0.03f;     // see ClipErrorMetric
+};
+
+struct CompressionStats
+{
+    size_t      rawBytes = 0;               // keyframes of the source clip
+    size_t      compressedBytes = 0;        // frames, segments and bit streams
+    float       maxError = 0.0f;            // hierarchical error at the keyframes, vertexDistance out of each joint
+};
+
+// the clip's tracks must be remapped to skeleton; fails for clips whose keyframes aren't on a fixed frame grid or
+// run past MAX_COMPRESSED_FRAME, and for clips with rotations that aren't unit quaternions
+bool CompressClip(const AnimationClip* clip, Skeleton* skeleton, const CompressionSettings& settings, CompressedClip* outClip, CompressionStats* outStats = nullptr);
+// frees a clip made by CompressClip, baked clips live in their mapping instead
+void ReleaseCompressedClip(CompressedClip* clip);
+
+// CompressClip searches every track on the calling thread. A track's search only reads its ancestors, so the
+// tracks of one depth of the hierarchy can be searched on any threads at once once the depths above are done.
+// clip must stay alive until the search ends, EndCompressClip frees search whether it succeeds or not.
+struct BitRateSearch;
+bool BeginCompressClip(const AnimationClip* clip, Skeleton* skeleton, const CompressionSettings& settings, BitRateSearch** outSearch);
+void SearchTrackBitRates(BitRateSearch* search, uint32_t jointIdx);
+bool EndCompressClip(BitRateSearch* search, CompressedClip* outClip, CompressionStats* outStats = nullptr);
+
+// frame is the time in frames, time * frameRate
+void SampleCompressedTrack(const CompressedTrack* track, float frame, math::Vec3* outTranslation, math::Vec4* outRotation);
+
+bool BakeCompressedClip(const char* sourcePath, Skeleton* targetSkeleton, CompressedClip* clip);
+bool LoadBakedCompressedClip(const char* sourcePath, Skeleton* targetSkeleton, FileMapping* outFile, CompressedClip* outClip);
+// compresses the clip at path with the default settings, loaded from its bake or imported, and bakes the result
+bool ImportCompressedClip(const char* path, Skeleton* targetSkeleton, CompressedClip* outClip, CompressionStats* outStats = nullptr);
@@ -0,0 +1,93 @@
+#include "clipmetric.h"
+#include <math.h>
+
+///
+static math::Vec4 QuatMultiply(const math::Vec4& a, const math::Vec4& b)
+{
+    return math::Vec4(
+        a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+        a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+        a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+        a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z);
+}
+
+static math::Vec3 QuatRotate(const math::Vec4& q, const math::Vec3& v)
+{
+    math::Vec3 t = 2.0f * math::Cross(q.xyz, v);
+    return v + q.w * t + math::Cross(q.xyz, t);
+}
+
+///
+// how far each joint's descendants can get from it over the clip: the longest chain of the largest local offsets
+// below it, children come after their parents in sorted skeletons
+static void ComputeShellDistances(ClipErrorMetric* metric, const AnimationClip* clip, float vertexDistance)
+{
+    auto skeleton = metric->skeleton;
+    for (uint32_t i = 0; i < skeleton->numJoints; ++i) {
+        metric->shellDistance[i] = vertexDistance;
+    }
+    for (uint32_t i = skeleton->numJoints; i-- > 1;) {
+        auto& track = clip->tracks[i];
+        float offset = math::Length(metric->bindOffset[i] + metric->bindLocal[i].translation);
+        for (uint32_t k = 0; k < track.numKeyframes; ++k) {
+            offset = math::Max(offset, math::Length(metric->bindOffset[i] + track.keyframes[k].position));
+        }
+        int parent = skeleton->joints[i].parent;
+        if (parent != -1) {
+            metric->shellDistance[parent] = math::Max(metric->shellDistance[parent], metric->shellDistance[i] + offset);
+        }
+    }
+}
+
+void InitClipErrorMetric(ClipErrorMetric* metric, const AnimationClip* clip, Skeleton* skeleton, float vertexDistance)
+{
+    metric->skeleton = skeleton;
+    for (uint32_t i = 0; i < skeleton->numJoints; ++i) {
+        auto& joint = skeleton->joints[i];
+        auto bindTranslation = math::Get4x4FloatMatrixColumnCM(joint.bindpose, 3).xyz;
+        metric->bindOffset[i] = i == 0 ? math::Vec3() : bindTranslation;
+        metric->bindLocal[i].translation = i == 0 ? bindTranslation : math::Vec3();
+        metric->bindLocal[i].rotation = QuatFromMatrix(joint.bindpose);
+    }
+    ComputeShellDistances(metric, clip, vertexDistance);
+}
+
+JointTransform LocalJointTransform(const ClipErrorMetric* metric, uint32_t jointIdx, const JointTransform& sampled)
+{
+    JointTransform local = sampled;
+    local.translation = local.translation + metric->bindOffset[jointIdx];
+    return local;
+}
+
+JointTransform ComposeJointTransforms(const JointTransform& parent, const JointTransform& local)
+{
+    JointTransform model;
+    model.translation = parent.translation + QuatRotate(parent.rotation, local.translation);
+    model.rotation = QuatMultiply(parent.rotation, local.rotation);
+    return model;
+}
+
+// the arc a point at distance sweeps through the rotation error bounds it whatever direction the point sits in
+float ModelSpaceError(const JointTransform& a, const JointTransform& b, float distance)
+{
+    math::Vec4 rotationA = math::Normalize(a.rotation);
+    math::Vec4 rotationB = math::Normalize(b.rotation);
+    if (math::Dot(rotationA, rotationB) < 0.0f) {
+        rotationB = -rotationB;
+    }
+    // from the chord between the quaternions, acos of their dot product is too coarse for small angles
+    float chord = math::Min(2.0f, math::Length(rotationA - rotationB));
+    return math::Length(a.translation - b.translation) + 4.0f * asinf(chord * 0.5f) * distance;
+}
+
+void SampleKeyframes(const float* times, const Keyframe* keys, uint32_t numKeys, float time, JointTransform* outTransform)
+{
+    KeySpan span = FindKeySpan(times, numKeys, time);
+    if (span.prev == span.next) {
+        outTransform->translation = keys[span.prev].position;
+        outTransform->rotation = keys[span.prev].rotation;
+        return;
+    }
+    outTransform->translation = math::Lerp(keys[span.prev].position, keys[span.next].position, span.alpha);
+    outTransform->rotation = math::Slerp(keys[span.prev].rotation, keys[span.next].rotation, span.alpha);
+}
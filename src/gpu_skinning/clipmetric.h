@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "assets.h"
+
+///
+/**
+    Hierarchical clip error
+    Clip reduction and compression both measure their error in model space, the way it shows on the skin. A joint is
+    posed through its parent chain, with the already processed ancestor tracks, and compared against the source
+    pose. The error is the most a virtual vertex at the joint's shell distance can move: translation error plus
+    rotation error times the distance. The shell distance is the longest chain of local offsets below the joint
+    plus vertexDistance, so the error bounds the skin anywhere below the joint, and joints high up the hierarchy
+    end up with tighter budgets than fingers.
+    Joint transforms here are composed from quaternions exactly like ApplyLayerToSkeleton and TransformHierarchy
+    compose the matrices.
+*/
+struct ClipErrorMetric
+{
+    Skeleton*       skeleton = nullptr;
+    JointTransform  bindLocal[MAX_NUM_BONES];       // layer transforms of joints without a track, like ComputeBindPose
+    math::Vec3      bindOffset[MAX_NUM_BONES];      // bind translation ApplyLayerToSkeleton adds to all but the root
+    float           shellDistance[MAX_NUM_BONES];
+};
+
+// the clip's tracks must be remapped to skeleton, which must be sorted
+void            InitClipErrorMetric(ClipErrorMetric* metric, const AnimationClip* clip, Skeleton* skeleton, float vertexDistance);
+
+// the local transform ApplyLayerToSkeleton builds from a layer transform
+JointTransform  LocalJointTransform(const ClipErrorMetric* metric, uint32_t jointIdx, const JointTransform& sampled);
+// parent * local
+JointTransform  ComposeJointTransforms(const JointTransform& parent, const JointTransform& local);
+// the most a point within distance of the joint moves between the two model transforms
+float           ModelSpaceError(const JointTransform& a, const JointTransform& b, float distance);
+
+// samples keys like ComputeLocalPoses does: the last key at or before time and the one after it
+void            SampleKeyframes(const float* times, const Keyframe* keys, uint32_t numKeys, float time, JointTransform* outTransform);
@@ -0,0 +1,207 @@
+#include "clipreduction.h"
+#include "clipmetric.h"
+#include <stdio.h>
+#include <string.h>
+
+///
+struct ReductionTrack
+{
+    const float*    times = nullptr;    // of the source
+    const Keyframe* keys = nullptr;
+    float*          reducedTimes = nullptr; // kept keys, numReduced of them
+    Keyframe*       reduced = nullptr;
+    uint32_t        numKeys = 0;
+    uint32_t        numReduced = 0;
+};
+
+struct ReductionContext
+{
+    ClipErrorMetric metric;
+    ReductionTrack  tracks[MAX_NUM_BONES];
+};
+
+// model space transform of the joint at time, through the reduced keys of the joint and its ancestors or the source's
+static JointTransform ModelTransform(ReductionContext* context, int jointIdx, float time, bool reduced)
+{
+    JointTransform model;
+    model.rotation = math::Vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    int chain[MAX_NUM_BONES];
+    int depth = 0;
+    for (int i = jointIdx; i != -1; i = context->metric.skeleton->joints[i].parent) {
+        chain[depth++] = i;
+    }
+    while (depth > 0) {
+        int i = chain[--depth];
+        auto& track = context->tracks[i];
+        JointTransform sampled = context->metric.bindLocal[i];
+        if (track.numKeys != 0) {
+            SampleKeyframes(reduced ? track.reducedTimes : track.times, reduced ? track.reduced : track.keys, reduced ? track.numReduced : track.numKeys,
+                time, &sampled);
+        }
+        model = ComposeJointTransforms(model, LocalJointTransform(&context->metric, i, sampled));
+    }
+    return model;
+}
+
+// greedily extends the span between the last kept key and the next one for as long as every key inside it is
+// reproduced within maxError; parents must have been reduced already
+static void ReduceTrack(ReductionContext* context, uint32_t jointIdx, float maxError, JointTransform* parentModels, JointTransform* sourceModels)
+{
+    auto& track = context->tracks[jointIdx];
+    int parent = context->metric.skeleton->joints[jointIdx].parent;
+    JointTransform identity;
+    identity.rotation = math::Vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    for (uint32_t k = 0; k < track.numKeys; ++k) {
+        float time = track.times[k];
+        JointTransform sourceParent = parent != -1 ? ModelTransform(context, parent, time, false) : identity;
+        parentModels[k] = parent != -1 ? ModelTransform(context, parent, time, true) : identity;
+        JointTransform local;
+        local.translation = track.keys[k].position;
+        local.rotation = track.keys[k].rotation;
+        sourceModels[k] = ComposeJointTransforms(sourceParent, LocalJointTransform(&context->metric, jointIdx, local));
+    }
+
+    float shell = context->metric.shellDistance[jointIdx];
+    auto Reproduces = [&](const float* times, const Keyframe* keys, uint32_t numKeys, uint32_t firstKey, uint32_t lastKey) -> bool {
+        for (uint32_t k = firstKey; k <= lastKey; ++k) {
+            JointTransform sampled;
+            SampleKeyframes(times, keys, numKeys, track.times[k], &sampled);
+            JointTransform model = ComposeJointTransforms(parentModels[k], LocalJointTransform(&context->metric, jointIdx, sampled));
+            if (ModelSpaceError(model, sourceModels[k], shell) > maxError) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    // the metric compares unit rotations, the runtime builds its matrices from the keys as they are
+    for (uint32_t k = 0; k < track.numKeys; ++k) {
+        if (math::Abs(math::Length(track.keys[k].rotation) - 1.0f) > 0.001f) {
+            memcpy(track.reducedTimes, track.times, sizeof(float) * track.numKeys);
+            memcpy(track.reduced, track.keys, sizeof(Keyframe) * track.numKeys);
+            track.numReduced = track.numKeys;
+            return;
+        }
+    }
+
+    // a single key holds the track if it does everywhere
+    auto Keep = [&](uint32_t k) {
+        track.reducedTimes[track.numReduced] = track.times[k];
+        track.reduced[track.numReduced++] = track.keys[k];
+    };
+    track.numReduced = 0;
+    Keep(0);
+    if (track.numKeys > 1 && Reproduces(track.times, track.keys, 1, 0, track.numKeys - 1)) {
+        return;
+    }
+    uint32_t anchor = 0;
+    for (uint32_t k = 1; k + 1 < track.numKeys; ++k) {
+        float spanTimes[2] = { track.times[anchor], track.times[k + 1] };
+        Keyframe span[2] = { track.keys[anchor], track.keys[k + 1] };
+        if (!Reproduces(spanTimes, span, 2, anchor + 1, k)) {
+            Keep(k);
+            anchor = k;
+        }
+    }
+    if (track.numKeys > 1) {
+        Keep(track.numKeys - 1);
+    }
+}
+
+bool ReduceClip(const AnimationClip* clip, Skeleton* skeleton, const ReductionSettings& settings, AnimationClip* outClip, ReductionStats* outStats)
+{
+    ReductionContext* context = new ReductionContext();
+    InitClipErrorMetric(&context->metric, clip, skeleton, settings.vertexDistance);
+    uint32_t maxKeys = 0;
+    size_t numKeys = 0;
+    for (uint32_t i = 0; i < skeleton->numJoints; ++i) {
+        auto& track = context->tracks[i];
+        track.times = clip->tracks[i].times;
+        track.keys = clip->tracks[i].keyframes;
+        track.numKeys = clip->tracks[i].numKeyframes;
+        numKeys += track.numKeys;
+        maxKeys = math::Max(maxKeys, track.numKeys);
+    }
+    float* reducedTimes = new float[numKeys != 0 ? numKeys : 1];
+    Keyframe* reducedKeys = new Keyframe[numKeys != 0 ? numKeys : 1];
+    JointTransform* parentModels = new JointTransform[maxKeys != 0 ? maxKeys : 1];
+    JointTransform* sourceModels = new JointTransform[maxKeys != 0 ? maxKeys : 1];
+
+    // sorted skeletons list parents first, so every parent is final before its children are reduced
+    size_t reducedOffset = 0;
+    for (uint32_t i = 0; i < skeleton->numJoints; ++i) {
+        auto& track = context->tracks[i];
+        if (track.numKeys == 0) {
+            continue;
+        }
+        track.reducedTimes = reducedTimes + reducedOffset;
+        track.reduced = reducedKeys + reducedOffset;
+        reducedOffset += track.numKeys;
+        ReduceTrack(context, i, settings.maxError, parentModels, sourceModels);
+    }
+
+    // tracks that kept keys at the same times share them again
+    ReductionStats stats;
+    auto& reduced = *outClip;
+    size_t nameLen = strlen(clip->name);
+    uint32_t sharedTimes[MAX_NUM_BONES];
+    ArenaMeasure(&reduced.arena, nameLen + 1, 1);
+    for (uint32_t i = 0; i < skeleton->numJoints; ++i) {
+        auto& track = context->tracks[i];
+        sharedTimes[i] = i;
+        for (uint32_t j = 0; j < i && sharedTimes[i] == i; ++j) {
+            auto& other = context->tracks[j];
+            if (track.numReduced != 0 && other.numReduced == track.numReduced && memcmp(other.reducedTimes, track.reducedTimes, sizeof(float) * track.numReduced) == 0) {
+                sharedTimes[i] = j;
+            }
+        }
+        if (sharedTimes[i] == i) {
+            ArenaMeasure(&reduced.arena, sizeof(float) * track.numReduced, alignof(float));
+        }
+        ArenaMeasure(&reduced.arena, sizeof(Keyframe) * track.numReduced, alignof(Keyframe));
+        stats.numKeyframes += track.numKeys;
+        stats.numReducedKeyframes += track.numReduced;
+        for (uint32_t k = 0; k < track.numKeys; ++k) {
+            float time = track.times[k];
+            JointTransform source = ModelTransform(context, (int)i, time, false);
+            JointTransform model = ModelTransform(context, (int)i, time, true);
+            stats.maxError = math::Max(stats.maxError, ModelSpaceError(model, source, settings.vertexDistance));
+        }
+    }
+    bool success = ArenaCommit(&reduced.arena);
+    if (success) {
+        reduced.name = ArenaAllocArray<char>(&reduced.arena, nameLen + 1);
+        memcpy(reduced.name, clip->name, nameLen + 1);
+        reduced.numTracks = clip->numTracks;
+        reduced.duration = clip->duration;
+        for (uint32_t i = 0; i < skeleton->numJoints; ++i) {
+            auto& track = context->tracks[i];
+            if (track.numReduced == 0) {
+                continue;
+            }
+            reduced.tracks[i].numKeyframes = track.numReduced;
+            if (sharedTimes[i] == i) {
+                reduced.tracks[i].times = ArenaAllocArray<float>(&reduced.arena, track.numReduced);
+                memcpy(reduced.tracks[i].times, track.reducedTimes, sizeof(float) * track.numReduced);
+            }
+            else {
+                reduced.tracks[i].times = reduced.tracks[sharedTimes[i]].times;
+            }
+            reduced.tracks[i].keyframes = ArenaAllocArray<Keyframe>(&reduced.arena, track.numReduced);
+            memcpy(reduced.tracks[i].keyframes, track.reduced, sizeof(Keyframe) * track.numReduced);
+        }
+    }
+    else {
+        printf("%s: out of memory\n", clip->name);
+        reduced = AnimationClip();
+    }
+    delete[] sourceModels;
+    delete[] parentModels;
+    delete[] reducedKeys;
+    delete[] reducedTimes;
+    delete context;
+    if (success && outStats != nullptr) {
+        *outStats = stats;
+    }
+    return success;
+}
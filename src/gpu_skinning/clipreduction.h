@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "assets.h"
+
+///
+/**
+    Keyframe reduction
+    ReduceClip drops every keyframe the runtime can interpolate from its neighbours closely enough, measured with
+    the hierarchical error in clipmetric.h: tracks are reduced parents first and children are held to the error
+    against the reduced ancestors.
+    Keys are only checked at the source's keyframe times, the source is assumed to be sampled densely. Tracks with
+    rotations that aren't unit quaternions are kept whole, the metric can't judge what the runtime makes of them.
+    The result is an ordinary AnimationClip, sampled like any other and baked in place of the source's keys.
+*/
+struct ReductionSettings
+{
+    float       maxError = 0.0001f;         // at the virtual vertices, in the units of the skeleton (meters)
+    float       vertexDistance = 0.03f;     // how far out of the leaf joints the virtual vertices sit, a rough skin depth
+};
+
+struct ReductionStats
+{
+    uint32_t    numKeyframes = 0;           // of the source clip
+    uint32_t    numReducedKeyframes = 0;
+    float       maxError = 0.0f;            // largest virtual vertex error at the source's keys, vertexDistance out of each joint
+};
+
+// the clip's tracks must be remapped to skeleton, outClip holds its keyframes in its arena like an imported clip
+bool ReduceClip(const AnimationClip* clip, Skeleton* skeleton, const ReductionSettings& settings, AnimationClip* outClip, ReductionStats* outStats = nullptr);
@@ -0,0 +1,248 @@
+#include "clipresampling.h"
+#include "clipmetric.h"
+#include "gtbin.h"
+#include "hash.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <xmmintrin.h>
+
+///
+// model space transforms of every joint, skeleton sorted parents first
+static void ComposeModelTransforms(const ClipErrorMetric* metric, const JointTransform* sampled, JointTransform* outModels)
+{
+    auto skeleton = metric->skeleton;
+    for (uint32_t i = 0; i < skeleton->numJoints; ++i) {
+        JointTransform parent;
+        parent.rotation = math::Vec4(0.0f, 0.0f, 0.0f, 1.0f);
+        if (skeleton->joints[i].parent != -1) {
+            parent = outModels[skeleton->joints[i].parent];
+        }
+        outModels[i] = ComposeJointTransforms(parent, LocalJointTransform(metric, i, sampled[i]));
+    }
+}
+
+// poses both clips at and halfway between the frames, where the nlerp strays furthest from the source's slerp
+static float MeasureResampleError(const AnimationClip* clip, const ResampledClip* resampled, Skeleton* skeleton, float vertexDistance)
+{
+    ClipErrorMetric* metric = new ClipErrorMetric();
+    InitClipErrorMetric(metric, clip, skeleton, vertexDistance);
+    JointTransform* sampled = new JointTransform[MAX_NUM_BONES * 4];
+    JointTransform* resampledLocals = sampled + MAX_NUM_BONES;
+    JointTransform* sourceModels = sampled + MAX_NUM_BONES * 2;
+    JointTransform* resampledModels = sampled + MAX_NUM_BONES * 3;
+    float maxError = 0.0f;
+    for (uint32_t s = 0; s < resampled->numFrames * 2 - 1; ++s) {
+        float time = math::Min(clip->duration, (float)s * 0.5f / resampled->frameRate);
+        for (uint32_t i = 0; i < skeleton->numJoints; ++i) {
+            auto& track = clip->tracks[i];
+            sampled[i] = metric->bindLocal[i];
+            if (track.numKeyframes != 0) {
+                SampleKeyframes(track.times, track.keyframes, track.numKeyframes, time, &sampled[i]);
+            }
+            resampledLocals[i] = metric->bindLocal[i];
+        }
+        SampleResampledClip(resampled, time, resampledLocals);
+        ComposeModelTransforms(metric, sampled, sourceModels);
+        ComposeModelTransforms(metric, resampledLocals, resampledModels);
+        for (uint32_t i = 0; i < skeleton->numJoints; ++i) {
+            maxError = math::Max(maxError, ModelSpaceError(resampledModels[i], sourceModels[i], vertexDistance));
+        }
+    }
+    delete[] sampled;
+    delete metric;
+    return maxError;
+}
+
+bool ResampleClip(const AnimationClip* clip, Skeleton* skeleton, const ResampleSettings& settings, ResampledClip* outClip, ResampleStats* outStats)
+{
+    // frames are spaced evenly over the clip, as close to the requested rate as that allows
+    float numIntervals = roundf(clip->duration * settings.frameRate);
+    if (!(numIntervals < (float)MAX_RESAMPLED_FRAMES)) {
+        printf("%s: the clip is too long to be resampled at %.1f frames per second\n", clip->name, settings.frameRate);
+        return false;
+    }
+    auto& resampled = *outClip;
+    resampled.duration = clip->duration;
+    resampled.numFrames = (uint32_t)math::Max(numIntervals, 1.0f) + 1;
+    resampled.frameRate = clip->duration > 0.0f ? (float)(resampled.numFrames - 1) / clip->duration : settings.frameRate;
+
+    uint16_t channelJoints[MAX_NUM_BONES + RESAMPLED_LANES];
+    uint32_t numChannels = 0;
+    for (uint32_t i = 0; i < skeleton->numJoints; ++i) {
+        if (clip->tracks[i].numKeyframes != 0) {
+            channelJoints[numChannels++] = (uint16_t)i;
+        }
+    }
+    while (numChannels % RESAMPLED_LANES != 0) {
+        channelJoints[numChannels++] = RESAMPLED_NO_JOINT;
+    }
+    resampled.numChannels = numChannels;
+    size_t frameSize = RESAMPLED_COMPONENTS * numChannels;
+    size_t nameLen = strlen(clip->name);
+    ArenaMeasure(&resampled.arena, nameLen + 1, 1);
+    ArenaMeasure(&resampled.arena, sizeof(uint16_t) * numChannels, alignof(uint16_t));
+    ArenaMeasure(&resampled.arena, sizeof(float) * frameSize * resampled.numFrames, 16);
+    if (!ArenaCommit(&resampled.arena)) {
+        printf("%s: out of memory\n", clip->name);
+        resampled = ResampledClip();
+        return false;
+    }
+    resampled.name = ArenaAllocArray<char>(&resampled.arena, nameLen + 1);
+    memcpy(resampled.name, clip->name, nameLen + 1);
+    resampled.joints = ArenaAllocArray<uint16_t>(&resampled.arena, numChannels);
+    memcpy(resampled.joints, channelJoints, sizeof(uint16_t) * numChannels);
+    resampled.frames = static_cast<float*>(ArenaAlloc(&resampled.arena, sizeof(float) * frameSize * resampled.numFrames, 16));
+
+    for (uint32_t f = 0; f < resampled.numFrames; ++f) {
+        float time = math::Min(clip->duration, (float)f / resampled.frameRate);
+        float* frame = resampled.frames + f * frameSize;
+        for (uint32_t c = 0; c < numChannels; ++c) {
+            JointTransform sampled;
+            sampled.rotation = math::Vec4(0.0f, 0.0f, 0.0f, 1.0f);     // padding keeps a unit rotation for the nlerp
+            if (channelJoints[c] != RESAMPLED_NO_JOINT) {
+                auto& track = clip->tracks[channelJoints[c]];
+                SampleKeyframes(track.times, track.keyframes, track.numKeyframes, time, &sampled);
+                sampled.rotation = math::Normalize(sampled.rotation);
+            }
+            if (f > 0) {
+                const float* previous = frame - frameSize;
+                math::Vec4 previousRotation(previous[3 * numChannels + c], previous[4 * numChannels + c], previous[5 * numChannels + c], previous[6 * numChannels + c]);
+                if (math::Dot(previousRotation, sampled.rotation) < 0.0f) {
+                    sampled.rotation = -sampled.rotation;
+                }
+            }
+            frame[0 * numChannels + c] = sampled.translation.x;
+            frame[1 * numChannels + c] = sampled.translation.y;
+            frame[2 * numChannels + c] = sampled.translation.z;
+            frame[3 * numChannels + c] = sampled.rotation.x;
+            frame[4 * numChannels + c] = sampled.rotation.y;
+            frame[5 * numChannels + c] = sampled.rotation.z;
+            frame[6 * numChannels + c] = sampled.rotation.w;
+        }
+    }
+
+    if (outStats != nullptr) {
+        ResampleStats stats;
+        for (uint32_t i = 0; i < skeleton->numJoints; ++i) {
+            uint32_t numKeyframes = clip->tracks[i].numKeyframes;
+            stats.rawBytes += sizeof(Keyframe) * numKeyframes + (numKeyframes != 0 && FindSharedTimes(clip, i) == i ? sizeof(float) * numKeyframes : 0);
+        }
+        stats.resampledBytes = sizeof(uint16_t) * numChannels + sizeof(float) * frameSize * resampled.numFrames;
+        stats.maxError = MeasureResampleError(clip, outClip, skeleton, settings.vertexDistance);
+        *outStats = stats;
+    }
+    return true;
+}
+
+void ReleaseResampledClip(ResampledClip* clip)
+{
+    ArenaRelease(&clip->arena);
+    *clip = ResampledClip();
+}
+
+// blends RESAMPLED_LANES channels a step, then scatters them to their joints
+void SampleResampledClip(const ResampledClip* clip, float time, JointTransform* outTransforms)
+{
+    float frame = math::Clamp(time * clip->frameRate, 0.0f, (float)(clip->numFrames - 1));
+    uint32_t prev = (uint32_t)frame;
+    uint32_t next = math::Min(prev + 1, clip->numFrames - 1);
+    uint32_t numChannels = clip->numChannels;
+    size_t frameSize = RESAMPLED_COMPONENTS * numChannels;
+    const float* prevFrame = clip->frames + prev * frameSize;
+    const float* nextFrame = clip->frames + next * frameSize;
+    __m128 alpha = _mm_set1_ps(frame - (float)prev);
+    alignas(16) float lanes[RESAMPLED_COMPONENTS][RESAMPLED_LANES];
+    for (uint32_t c = 0; c < numChannels; c += RESAMPLED_LANES) {
+        __m128 blended[RESAMPLED_COMPONENTS];
+        for (uint32_t k = 0; k < RESAMPLED_COMPONENTS; ++k) {
+            __m128 from = _mm_load_ps(prevFrame + k * numChannels + c);
+            __m128 to = _mm_load_ps(nextFrame + k * numChannels + c);
+            blended[k] = _mm_add_ps(from, _mm_mul_ps(_mm_sub_ps(to, from), alpha));
+        }
+        __m128 lengthSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(blended[3], blended[3]), _mm_mul_ps(blended[4], blended[4])),
+            _mm_add_ps(_mm_mul_ps(blended[5], blended[5]), _mm_mul_ps(blended[6], blended[6])));
+        __m128 invLength = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(lengthSq));
+        for (uint32_t k = 0; k < RESAMPLED_COMPONENTS; ++k) {
+            _mm_store_ps(lanes[k], k < 3 ? blended[k] : _mm_mul_ps(blended[k], invLength));
+        }
+        for (uint32_t lane = 0; lane < RESAMPLED_LANES; ++lane) {
+            uint32_t jointIdx = clip->joints[c + lane];
+            if (jointIdx == RESAMPLED_NO_JOINT) {
+                break;      // padding only follows the last joint
+            }
+            outTransforms[jointIdx].translation = math::Vec3(lanes[0][lane], lanes[1][lane], lanes[2][lane]);
+            outTransforms[jointIdx].rotation = math::Vec4(lanes[3][lane], lanes[4][lane], lanes[5][lane], lanes[6][lane]);
+        }
+    }
+}
+
+///
+// the joint order the tracks were remapped to and the layout, either one changing makes the bake stale
+static uint64_t HashResampledClipDependencies(Skeleton* targetSkeleton)
+{
+    uint32_t version = CLIP_RESAMPLING_VERSION;
+    return HashFNV1a64(&version, sizeof(version), HashSkeletonLayout(targetSkeleton));
+}
+
+bool BakeResampledClip(const char* sourcePath, Skeleton* targetSkeleton, ResampledClip* clip)
+{
+    char bakedPath[512];
+    GTBinSource source;
+    if (!GTBinPathFor(sourcePath, bakedPath, sizeof(bakedPath), "r") || !GTBinSourceFor(sourcePath, HashResampledClipDependencies(targetSkeleton), &source)) {
+        return false;
+    }
+    GTBinWriter writer;
+    GTBinBegin(&writer);
+    // a zeroed copy of the clip's fields, so bakes of the same source are identical; the arena stays empty, baked
+    // clips live in their mapping
+    auto root = GTBinAlloc(&writer, sizeof(ResampledClip), 16);
+    auto baked = static_cast<ResampledClip*>(GTBinAt(&writer, root));
+    baked->duration = clip->duration;
+    baked->frameRate = clip->frameRate;
+    baked->numFrames = clip->numFrames;
+    baked->numChannels = clip->numChannels;
+    GTBinPointer(&writer, root + offsetof(ResampledClip, name), GTBinWrite(&writer, clip->name, strlen(clip->name) + 1, 1));
+    GTBinPointer(&writer, root + offsetof(ResampledClip, joints), GTBinWrite(&writer, clip->joints, sizeof(uint16_t) * clip->numChannels, alignof(uint16_t)));
+    size_t framesSize = sizeof(float) * RESAMPLED_COMPONENTS * clip->numChannels * clip->numFrames;
+    GTBinPointer(&writer, root + offsetof(ResampledClip, frames), GTBinWrite(&writer, clip->frames, framesSize, 16));
+    return GTBinFinish(&writer, bakedPath, GTBIN_RESAMPLED_CLIP, source, root);
+}
+
+bool LoadBakedResampledClip(const char* sourcePath, Skeleton* targetSkeleton, FileMapping* outFile, ResampledClip* outClip)
+{
+    char bakedPath[512];
+    GTBinSource source;
+    if (!GTBinPathFor(sourcePath, bakedPath, sizeof(bakedPath), "r") || !GTBinSourceFor(sourcePath, HashResampledClipDependencies(targetSkeleton), &source)) {
+        return false;
+    }
+    void* root = nullptr;
+    if (!GTBinLoad(bakedPath, GTBIN_RESAMPLED_CLIP, sizeof(ResampledClip), source, outFile, &root)) {
+        return false;
+    }
+    memcpy(outClip, root, sizeof(ResampledClip));
+    return true;
+}
+
+bool ImportResampledClip(const char* path, Skeleton* targetSkeleton, ResampledClip* outClip, ResampleStats* outStats)
+{
+    AnimationClip* clip = new AnimationClip();
+    FileMapping bakedFile;
+    bool baked = LoadBakedAnimation(path, targetSkeleton, &bakedFile, clip);
+    if (!baked && !ImportGTAnimation(path, targetSkeleton, clip)) {
+        delete clip;
+        return false;
+    }
+    bool success = ResampleClip(clip, targetSkeleton, ResampleSettings(), outClip, outStats);
+    if (baked) {
+        UnmapFile(&bakedFile);
+    }
+    else {
+        ReleaseAnimationClip(clip);
+    }
+    delete clip;
+    if (success) {
+        BakeResampledClip(path, targetSkeleton, outClip);
+    }
+    return success;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "assets.h"
+
+///
+/**
+    Resampled clips
+    ResampleClip samples every track of a clip at a fixed frame rate and stores the frames one after the other, each
+    in structure of arrays form: the x, y and z of all animated joints' translations, then the x, y, z and w of their
+    rotations. Sampling a pose reads two neighbouring frames front to back and blends RESAMPLED_LANES joints at once
+    with SSE, a lerp for translations and a normalized lerp for rotations, there's no key search and no per track
+    pointer to follow. Rotations are flipped into the hemisphere of the previous frame's, so the nlerp needs no sign
+    test; at the source's frame rate it stays within a fraction of the error budgets of reduction and compression.
+    Channels are the animated joints in skeleton order, padded to a multiple of RESAMPLED_LANES with lanes that
+    animate no joint, and every frame starts 16 byte aligned.
+    Resampled clips are baked next to the source like everything else, as <source>.r.gtbin.
+*/
+#define CLIP_RESAMPLING_VERSION     1   // part of the baked clip's dependency hash, bump when the layout changes
+#define RESAMPLED_LANES             4
+#define RESAMPLED_COMPONENTS        7   // translation x, y, z and rotation x, y, z, w
+#define RESAMPLED_NO_JOINT          0xffff
+#define MAX_RESAMPLED_FRAMES        (1 << 20)
+
+struct ResampledClip
+{
+    char*       name = nullptr;
+    float       duration = 0.0f;
+    float       frameRate = 0.0f;       // frames per second, spaced so the last frame falls on duration
+    uint32_t    numFrames = 0;
+    uint32_t    numChannels = 0;        // multiple of RESAMPLED_LANES
+    uint16_t*   joints = nullptr;       // per channel, RESAMPLED_NO_JOINT for padding
+    float*      frames = nullptr;       // numFrames * RESAMPLED_COMPONENTS * numChannels, per frame one array per component
+    Arena       arena;                  // holds name, joints and frames of resampled clips
+};
+
+struct ResampleSettings
+{
+    float       frameRate = 60.0f;          // the exporters' rate, clips keyed at it are resampled at their keys
+    float       vertexDistance = 0.03f;     // see ClipErrorMetric
+};
+
+struct ResampleStats
+{
+    size_t      rawBytes = 0;               // times and keyframes of the source clip
+    size_t      resampledBytes = 0;         // joints and frames
+    float       maxError = 0.0f;            // hierarchical error at and halfway between the frames, vertexDistance out of each joint
+};
+
+// the clip's tracks must be remapped to skeleton, which must be sorted; fails for clips that would take more than
+// MAX_RESAMPLED_FRAMES frames
+bool ResampleClip(const AnimationClip* clip, Skeleton* skeleton, const ResampleSettings& settings, ResampledClip* outClip, ResampleStats* outStats = nullptr);
+// frees a clip made by ResampleClip, baked clips live in their mapping instead
+void ReleaseResampledClip(ResampledClip* clip);
+
+// writes the transforms of the animated joints at time, clamped to the clip, and leaves the others alone
+void SampleResampledClip(const ResampledClip* clip, float time, JointTransform* outTransforms);
+
+bool BakeResampledClip(const char* sourcePath, Skeleton* targetSkeleton, ResampledClip* clip);
+bool LoadBakedResampledClip(const char* sourcePath, Skeleton* targetSkeleton, FileMapping* outFile, ResampledClip* outClip);
+// resamples the clip at path with the default settings, loaded from its bake or imported, and bakes the result
+bool ImportResampledClip(const char* path, Skeleton* targetSkeleton, ResampledClip* outClip, ResampleStats* outStats = nullptr);
@@ -0,0 +1,341 @@
+#include "clipsegments.h"
+#include "gtbin.h"
+#include "hash.h"
+#include "checksum.h"
+#include "platform/memory.h"
+#include "platform/thread.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+///
+static uint64_t HashSegmentedClipDependencies(Skeleton* targetSkeleton)
+{
+    uint32_t version = CLIP_SEGMENTS_VERSION;
+    return HashFNV1a64(&version, sizeof(version), HashSkeletonLayout(targetSkeleton));
+}
+
+static uint32_t CountSegments(float duration, float segmentDuration)
+{
+    uint32_t numSegments = (uint32_t)ceilf(duration / segmentDuration);
+    return numSegments != 0 ? numSegments : 1;
+}
+
+// the segment sampling time reads from, times outside the clip clamp to the first or last one like the keys do
+static uint32_t SegmentAt(const SegmentedClip* clip, float time)
+{
+    float segment = floorf(time / clip->segmentDuration);
+    if (!(segment > 0.0f)) {
+        return 0;
+    }
+    return segment < (float)clip->numSegments ? (uint32_t)segment : clip->numSegments - 1;
+}
+
+// the keys sampling anywhere in [start, end] can read: from the last key before start to the first key after end,
+// strictly so times a rounding error outside the window still find both of their keys
+static void FindSegmentKeys(const BoneTrack& track, float start, float end, uint32_t* outFirst, uint32_t* outCount)
+{
+    uint32_t first = 0;
+    while (first + 1 < track.numKeyframes && track.times[first + 1] < start) {
+        first++;
+    }
+    uint32_t last = first;
+    while (last + 1 < track.numKeyframes && track.times[last] <= end) {
+        last++;
+    }
+    *outFirst = first;
+    *outCount = track.numKeyframes != 0 ? last - first + 1 : 0;
+}
+
+bool BakeSegmentedClip(const char* sourcePath, Skeleton* targetSkeleton, const AnimationClip* clip)
+{
+    char bakedPath[512];
+    GTBinSource source;
+    if (!GTBinPathFor(sourcePath, bakedPath, sizeof(bakedPath), "s") || !GTBinSourceFor(sourcePath, HashSegmentedClipDependencies(targetSkeleton), &source)) {
+        return false;
+    }
+    SegmentedClip segmented;
+    segmented.numTracks = clip->numTracks;
+    segmented.duration = clip->duration;
+    segmented.segmentDuration = CLIP_SEGMENT_DURATION;
+    segmented.numSegments = CountSegments(clip->duration, CLIP_SEGMENT_DURATION);
+    for (uint32_t i = 0; i < MAX_NUM_BONES; ++i) {
+        if (clip->tracks[i].numKeyframes != 0) {
+            segmented.numTrackSlots = i + 1;
+        }
+    }
+    ClipSegment* segments = new ClipSegment[segmented.numSegments];
+    ClipSegmentTrack* tracks = new ClipSegmentTrack[MAX_NUM_BONES];
+    uint32_t sourceKeys[MAX_NUM_BONES];     // first key of each track in the source
+    uint32_t sharedTimes[MAX_NUM_BONES];    // tracks with the same keys in the source have them in every segment
+    for (uint32_t i = 0; i < segmented.numTrackSlots; ++i) {
+        sharedTimes[i] = FindSharedTimes(clip, i);
+    }
+    uint32_t timesOffset = (uint32_t)((sizeof(ClipSegmentTrack) * segmented.numTrackSlots + alignof(float) - 1) & ~(alignof(float) - 1));
+    char* block = nullptr;
+    size_t blockCapacity = 0;
+
+    GTBinWriter writer;
+    GTBinBegin(&writer);
+    for (uint32_t s = 0; s < segmented.numSegments; ++s) {
+        float start = (float)s * CLIP_SEGMENT_DURATION;
+        float end = (float)(s + 1) * CLIP_SEGMENT_DURATION;
+        uint32_t numTimes = 0;
+        uint32_t numKeyframes = 0;
+        for (uint32_t i = 0; i < segmented.numTrackSlots; ++i) {
+            FindSegmentKeys(clip->tracks[i], start, end, &sourceKeys[i], &tracks[i].numKeyframes);
+            tracks[i].firstTime = sharedTimes[i] != i ? tracks[sharedTimes[i]].firstTime : numTimes;
+            numTimes += sharedTimes[i] != i ? 0 : tracks[i].numKeyframes;
+            tracks[i].firstKeyframe = numKeyframes;
+            numKeyframes += tracks[i].numKeyframes;
+        }
+        uint32_t keyframesOffset = (uint32_t)((timesOffset + sizeof(float) * numTimes + alignof(Keyframe) - 1) & ~(alignof(Keyframe) - 1));
+        size_t blockSize = keyframesOffset + sizeof(Keyframe) * numKeyframes;
+        if (blockSize > blockCapacity) {
+            free(block);
+            block = (char*)malloc(blockSize);
+            blockCapacity = blockSize;
+        }
+        memset(block, 0x0, keyframesOffset);
+        memcpy(block, tracks, sizeof(ClipSegmentTrack) * segmented.numTrackSlots);
+        float* times = (float*)(block + timesOffset);
+        Keyframe* keyframes = (Keyframe*)(block + keyframesOffset);
+        for (uint32_t i = 0; i < segmented.numTrackSlots; ++i) {
+            if (tracks[i].numKeyframes != 0) {
+                if (sharedTimes[i] == i) {
+                    memcpy(times + tracks[i].firstTime, clip->tracks[i].times + sourceKeys[i], sizeof(float) * tracks[i].numKeyframes);
+                }
+                memcpy(keyframes + tracks[i].firstKeyframe, clip->tracks[i].keyframes + sourceKeys[i], sizeof(Keyframe) * tracks[i].numKeyframes);
+            }
+        }
+        segments[s].offset = GTBinWriteStreamed(&writer, block, blockSize, 16);
+        segments[s].size = (uint32_t)blockSize;
+        segments[s].timesOffset = timesOffset;
+        segments[s].keyframesOffset = keyframesOffset;
+        segments[s].checksum = ComputeChecksum(block, blockSize);
+        segmented.maxSegmentSize = math::Max(segmented.maxSegmentSize, (uint32_t)blockSize);
+    }
+    free(block);
+    delete[] tracks;
+
+    // zeroed copies of the clip's and the segments' fields, padding included, so bakes of the same source are identical
+    auto root = GTBinAlloc(&writer, sizeof(SegmentedClip), 16);
+    auto baked = static_cast<SegmentedClip*>(GTBinAt(&writer, root));
+    baked->numTracks = segmented.numTracks;
+    baked->numTrackSlots = segmented.numTrackSlots;
+    baked->numSegments = segmented.numSegments;
+    baked->maxSegmentSize = segmented.maxSegmentSize;
+    baked->duration = segmented.duration;
+    baked->segmentDuration = segmented.segmentDuration;
+    auto segmentTable = GTBinAlloc(&writer, sizeof(ClipSegment) * segmented.numSegments, alignof(ClipSegment));
+    auto bakedSegments = static_cast<ClipSegment*>(GTBinAt(&writer, segmentTable));
+    for (uint32_t s = 0; s < segmented.numSegments; ++s) {
+        bakedSegments[s].offset = segments[s].offset;
+        bakedSegments[s].size = segments[s].size;
+        bakedSegments[s].timesOffset = segments[s].timesOffset;
+        bakedSegments[s].keyframesOffset = segments[s].keyframesOffset;
+        bakedSegments[s].checksum = segments[s].checksum;
+    }
+    GTBinPointer(&writer, root + offsetof(SegmentedClip, segments), segmentTable);
+    auto name = GTBinWrite(&writer, clip->name, strlen(clip->name) + 1, 1);
+    GTBinPointer(&writer, root + offsetof(SegmentedClip, name), name);
+    delete[] segments;
+    return GTBinFinish(&writer, bakedPath, GTBIN_SEGMENTED_CLIP, source, root);
+}
+
+bool LoadBakedSegmentedClip(const char* sourcePath, Skeleton* targetSkeleton, FileMapping* outFile, SegmentedClip* outClip)
+{
+    char bakedPath[512];
+    GTBinSource source;
+    if (!GTBinPathFor(sourcePath, bakedPath, sizeof(bakedPath), "s") || !GTBinSourceFor(sourcePath, HashSegmentedClipDependencies(targetSkeleton), &source)) {
+        return false;
+    }
+    void* root = nullptr;
+    if (!GTBinLoad(bakedPath, GTBIN_SEGMENTED_CLIP, sizeof(SegmentedClip), source, outFile, &root)) {
+        return false;
+    }
+    memcpy(outClip, root, sizeof(SegmentedClip));
+    // blocks are only checksummed once they are streamed in, their table has to hold up before that
+    size_t streamedSize = outFile->size - (size_t)(GTBinStreamed(outFile) - outFile->data);
+    bool valid = outClip->numSegments != 0 && outClip->numTrackSlots <= MAX_NUM_BONES && outClip->segmentDuration > 0.0f;
+    for (uint32_t s = 0; valid && s < outClip->numSegments; ++s) {
+        auto& segment = outClip->segments[s];
+        valid = segment.offset <= streamedSize && segment.size <= streamedSize - segment.offset && segment.size <= outClip->maxSegmentSize
+            && segment.timesOffset >= sizeof(ClipSegmentTrack) * outClip->numTrackSlots && segment.keyframesOffset >= segment.timesOffset
+            && segment.keyframesOffset <= segment.size;
+    }
+    if (!valid) {
+        printf("%s: corrupt segment table\n", bakedPath);
+        UnmapFile(outFile);
+        *outClip = SegmentedClip();
+        return false;
+    }
+    return true;
+}
+
+///
+// copies the slot's segment out of the mapping into its block and points the slot's clip at it
+static bool ReadSegment(StreamedClip* streamed, StreamedSegmentSlot* slot)
+{
+    auto& segmented = streamed->segmented;
+    auto& segment = segmented.segments[slot->segmentIdx];
+    memcpy(slot->block, GTBinStreamed(&streamed->file) + segment.offset, segment.size);
+    if (!VerifyChecksum(slot->block, segment.size, segment.checksum)) {
+        printf("%s: segment %d doesn't match its checksum\n", segmented.name, slot->segmentIdx);
+        return false;
+    }
+    auto tracks = (const ClipSegmentTrack*)slot->block;
+    auto times = (float*)(slot->block + segment.timesOffset);
+    auto keyframes = (Keyframe*)(slot->block + segment.keyframesOffset);
+    uint32_t numTimes = (uint32_t)((segment.keyframesOffset - segment.timesOffset) / sizeof(float));
+    uint32_t numKeyframes = (uint32_t)((segment.size - segment.keyframesOffset) / sizeof(Keyframe));
+    for (uint32_t i = 0; i < segmented.numTrackSlots; ++i) {
+        if (tracks[i].firstKeyframe > numKeyframes || tracks[i].numKeyframes > numKeyframes - tracks[i].firstKeyframe ||
+            tracks[i].firstTime > numTimes || tracks[i].numKeyframes > numTimes - tracks[i].firstTime) {
+            printf("%s: segment %d has a corrupt track table\n", segmented.name, slot->segmentIdx);
+            return false;
+        }
+    }
+    auto& clip = slot->clip;
+    clip.name = segmented.name;
+    clip.numTracks = segmented.numTracks;
+    clip.duration = segmented.duration;
+    for (uint32_t i = 0; i < segmented.numTrackSlots; ++i) {
+        clip.tracks[i].numKeyframes = tracks[i].numKeyframes;
+        clip.tracks[i].times = tracks[i].numKeyframes != 0 ? times + tracks[i].firstTime : nullptr;
+        clip.tracks[i].keyframes = tracks[i].numKeyframes != 0 ? keyframes + tracks[i].firstKeyframe : nullptr;
+    }
+    return true;
+}
+
+static void StreamSegmentJob(void* userData)
+{
+    auto slot = static_cast<StreamedSegmentSlot*>(userData);
+    bool success = ReadSegment(slot->owner, slot);
+    slot->state.store(success ? SEGMENT_READY : SEGMENT_FAILED, std::memory_order_release);
+}
+
+static void WaitForSegment(StreamedClip* clip, StreamedSegmentSlot* slot)
+{
+    while (slot->state.load(std::memory_order_acquire) == SEGMENT_LOADING) {
+        if (clip->pool == nullptr || !RunPendingJob(clip->pool)) {
+            YieldThread();
+        }
+    }
+}
+
+// clips shorter than the window only get a slot per segment
+static uint32_t CountSlots(const StreamedClip* clip)
+{
+    return math::Min(clip->segmented.numSegments, (uint32_t)CLIP_STREAMING_WINDOW);
+}
+
+static StreamedSegmentSlot* FindSegmentSlot(StreamedClip* clip, uint32_t segmentIdx)
+{
+    for (uint32_t i = 0; i < CountSlots(clip); ++i) {
+        auto& slot = clip->slots[i];
+        if (slot.segmentIdx == (int32_t)segmentIdx && slot.state.load(std::memory_order_relaxed) != SEGMENT_EMPTY) {
+            return &slot;
+        }
+    }
+    return nullptr;
+}
+
+// loads the segment into slot, on the job pool if async and the clip has one
+static void StreamSegment(StreamedClip* clip, StreamedSegmentSlot* slot, uint32_t segmentIdx, bool async)
+{
+    slot->segmentIdx = (int32_t)segmentIdx;
+    clip->streamedBytes += clip->segmented.segments[segmentIdx].size;
+    if (async && clip->pool != nullptr) {
+        slot->state.store(SEGMENT_LOADING, std::memory_order_relaxed);
+        PushJob(clip->pool, StreamSegmentJob, slot);
+    }
+    else {
+        slot->state.store(ReadSegment(clip, slot) ? SEGMENT_READY : SEGMENT_FAILED, std::memory_order_relaxed);
+    }
+}
+
+bool OpenStreamedClip(const char* path, Skeleton* targetSkeleton, StreamedClip* outClip)
+{
+    if (!LoadBakedSegmentedClip(path, targetSkeleton, &outClip->file, &outClip->segmented)) {
+        AnimationClip* clip = new AnimationClip();
+        FileMapping bakedFile;
+        bool baked = LoadBakedAnimation(path, targetSkeleton, &bakedFile, clip);
+        if (!baked && !ImportGTAnimation(path, targetSkeleton, clip)) {
+            delete clip;
+            return false;
+        }
+        bool success = BakeSegmentedClip(path, targetSkeleton, clip);
+        if (baked) {
+            UnmapFile(&bakedFile);
+        }
+        else {
+            ReleaseAnimationClip(clip);
+        }
+        delete clip;
+        if (!success || !LoadBakedSegmentedClip(path, targetSkeleton, &outClip->file, &outClip->segmented)) {
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < CountSlots(outClip); ++i) {
+        auto& slot = outClip->slots[i];
+        slot.owner = outClip;
+        slot.block = (char*)AllocateAligned(outClip->segmented.maxSegmentSize, 16);
+        slot.clip = AnimationClip();
+        slot.segmentIdx = -1;
+        slot.state.store(SEGMENT_EMPTY, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+void CloseStreamedClip(StreamedClip* clip)
+{
+    for (uint32_t i = 0; i < CountSlots(clip); ++i) {
+        auto& slot = clip->slots[i];
+        WaitForSegment(clip, &slot);
+        FreeAligned(slot.block);
+        slot.block = nullptr;
+        slot.clip = AnimationClip();
+        slot.segmentIdx = -1;
+        slot.state.store(SEGMENT_EMPTY, std::memory_order_relaxed);
+    }
+    UnmapFile(&clip->file);
+    clip->segmented = SegmentedClip();
+}
+
+AnimationClip* StreamClipSegment(StreamedClip* clip, float time)
+{
+    auto& segmented = clip->segmented;
+    uint32_t segmentIdx = SegmentAt(&segmented, time);
+    uint32_t nextIdx = (segmentIdx + 1) % segmented.numSegments;
+    auto current = FindSegmentSlot(clip, segmentIdx);
+    if (current == nullptr) {   // the first sample or a seek the prefetch didn't see coming, stream it in right away
+        clip->numStalls++;
+        for (uint32_t i = 0; i < CountSlots(clip); ++i) {
+            WaitForSegment(clip, &clip->slots[i]);
+        }
+        for (uint32_t i = 0; i < CountSlots(clip); ++i) {     // keep the next segment if it is resident already
+            if (current == nullptr || current->segmentIdx == (int32_t)nextIdx) {
+                current = &clip->slots[i];
+            }
+        }
+        StreamSegment(clip, current, segmentIdx, false);
+    }
+    WaitForSegment(clip, current);
+    if (segmented.numSegments > 1 && FindSegmentSlot(clip, nextIdx) == nullptr) {
+        for (uint32_t i = 0; i < CountSlots(clip); ++i) {
+            auto& slot = clip->slots[i];
+            if (&slot != current && slot.state.load(std::memory_order_acquire) != SEGMENT_LOADING) {
+                StreamSegment(clip, &slot, nextIdx, true);
+                break;
+            }
+        }
+    }
+    return current->state.load(std::memory_order_acquire) == SEGMENT_READY ? &current->clip : nullptr;
+}
+
+size_t GetStreamedClipSize(const StreamedClip* clip)
+{
+    return sizeof(StreamedClip) + (size_t)clip->segmented.maxSegmentSize * CountSlots(clip);
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include "assets.h"
+#include "jobs.h"
+
+///
+/**
+    Segmented clips
+    BakeSegmentedClip cuts a clip into segments of CLIP_SEGMENT_DURATION seconds. Each segment is one block holding
+    all tracks' keyframes for its time window, plus the last key before and the first key after it, so sampling any
+    time inside the window reads nothing but that block and gives exactly what sampling the whole clip does.
+    The blocks sit in the streamed section of the image (see gtbin.h), loading the image only maps the segment
+    table. A StreamedClip keeps a window of CLIP_STREAMING_WINDOW segments resident, the one being sampled and the
+    next one, which is prefetched on the job pool while the current one plays. Resident memory is two of the
+    largest segments however long the clip runs; pages of the mapped image are clean and the OS drops them again.
+    Segments are baked next to the source as <source>.s.gtbin.
+*/
+#define CLIP_SEGMENTS_VERSION   2       // part of the baked clip's dependency hash, bump when the layout changes
+#define CLIP_SEGMENT_DURATION   1.0f    // seconds of keyframes per segment
+#define CLIP_STREAMING_WINDOW   2       // the current segment and the next one
+
+// a segment block starts with numTrackSlots of these, followed by the times of the segment's keys, once for tracks
+// that share them, and all tracks' keyframes back to back
+struct ClipSegmentTrack
+{
+    uint32_t    firstTime = 0;          // into the block's times
+    uint32_t    firstKeyframe = 0;      // into the block's keyframes
+    uint32_t    numKeyframes = 0;
+};
+
+struct ClipSegment
+{
+    uint64_t    offset = 0;             // of the block in the image's streamed section
+    uint32_t    size = 0;
+    uint32_t    timesOffset = 0;        // from the start of the block
+    uint32_t    keyframesOffset = 0;
+    uint64_t    checksum = 0;           // of the block, verified whenever it is streamed in
+};
+
+struct SegmentedClip
+{
+    char*           name = nullptr;
+    uint32_t        numTracks = 0;
+    uint32_t        numTrackSlots = 0;  // track entries per segment, the last tracked joint + 1
+    uint32_t        numSegments = 0;
+    uint32_t        maxSegmentSize = 0;
+    float           duration = 0.0f;
+    float           segmentDuration = 0.0f;
+    ClipSegment*    segments = nullptr;
+};
+
+// the clip's tracks must be remapped to targetSkeleton
+bool BakeSegmentedClip(const char* sourcePath, Skeleton* targetSkeleton, const AnimationClip* clip);
+// segments stays in outFile, the blocks are streamed from it
+bool LoadBakedSegmentedClip(const char* sourcePath, Skeleton* targetSkeleton, FileMapping* outFile, SegmentedClip* outClip);
+
+///
+enum StreamedSegmentState : uint32_t
+{
+    SEGMENT_EMPTY   = 0,
+    SEGMENT_LOADING = 1,    // a prefetch job owns the slot
+    SEGMENT_READY   = 2,
+    SEGMENT_FAILED  = 3,    // the block didn't match its checksum
+};
+
+struct StreamedClip;
+
+struct StreamedSegmentSlot
+{
+    StreamedClip*           owner = nullptr;
+    char*                   block = nullptr;    // maxSegmentSize bytes
+    AnimationClip           clip;               // tracks point into block, only valid once ready
+    int32_t                 segmentIdx = -1;
+    std::atomic<uint32_t>   state { SEGMENT_EMPTY };
+};
+
+struct StreamedClip
+{
+    SegmentedClip       segmented;
+    FileMapping         file;
+    JobPool*            pool = nullptr;         // prefetches run on it, nullptr streams on the sampling thread; set by the caller
+    StreamedSegmentSlot slots[CLIP_STREAMING_WINDOW];
+    size_t              streamedBytes = 0;      // running totals for profiling
+    uint32_t            numStalls = 0;          // segments that weren't resident when they were sampled
+};
+
+// maps the clip's segmented bake, segmenting and baking the clip first if there is no current one
+bool    OpenStreamedClip(const char* path, Skeleton* targetSkeleton, StreamedClip* outClip);
+// waits for the clip's prefetch to complete
+void    CloseStreamedClip(StreamedClip* clip);
+// makes the segment time falls into resident and starts prefetching the one after it, the returned clip samples
+// like the whole clip around time and stays valid until the next call; nullptr if the segment is corrupt
+AnimationClip*  StreamClipSegment(StreamedClip* clip, float time);
+// bytes of the resident window
+size_t  GetStreamedClipSize(const StreamedClip* clip);
@@ -9,25 +9,41 @@
 ///
 #include <stdint.h>
 #include <stdio.h>
+#include <atomic>
 #include "math.h"
+#include "platform/file.h"
+#include "platform/timer.h"
+#include "platform/thread.h"
+#include "platform/filewatch.h"
+#include "bytestream.h"
+#include "package.h"
+#include "jobs.h"
+#include "assets.h"
+#include "checksum.h"
+#include "clipcompression.h"
+#include "clipsegments.h"
+#include "clipresampling.h"
+#include "trackpool.h"
 
 //
 void* operator new[](size_t size, const char* pName, int flags, unsigned debugFlags, const char* file, int line)
 {
     return malloc(size);
 }
+// EASTL frees through plain delete[], so aligned blocks have to come from malloc as well and can't be over-aligned
 void* operator new[](size_t size, size_t alignment, size_t alignmentOffset, const char* pName, int flags, unsigned debugFlags, const char* file, int line)
 {
+    assert(alignment <= 16 && alignmentOffset == 0);
     return malloc(size);
 }
 ///
 
 struct ShaderDesc
 {
-    char*       vertexShaderCode        = nullptr;
+    const char* vertexShaderCode        = nullptr;
     uint32_t    vertexShaderCodeSize    = 0;
 
-    char*       pixelShaderCode         = nullptr;
+    const char* pixelShaderCode         = nullptr;
     uint32_t    pixelShaderCodeSize     = 0;
 };
 
@@ -57,46 +73,26 @@ bool CreateShader(ID3D11Device* device, ShaderDesc* desc, Shader* shader)
 }
 
 
-struct Vertex
+ID3D11InputLayout* GetVertexInputLayout(ID3D11Device* device, ShaderDesc* shaderDesc)
 {
-    math::Vec3  position;
-    math::Vec3  normal;
-    float       uv[2];
-    math::Vec4  tangent;
-    float       blendWeights[4];
-    uint32_t    blendIndices[4];
-
-    static ID3D11InputLayout* GetInputLayout(ID3D11Device* device, ShaderDesc* shaderDesc)
-    {
-        static ID3D11InputLayout* layout = nullptr;
-        if (!layout) {
-            D3D11_INPUT_ELEMENT_DESC elementDesc[] = {
-                { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, offsetof(Vertex, position), D3D11_INPUT_PER_VERTEX_DATA, 0 },
-                { "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, offsetof(Vertex, normal), D3D11_INPUT_PER_VERTEX_DATA, 0 },
-                { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, offsetof(Vertex, uv), D3D11_INPUT_PER_VERTEX_DATA, 0 },
-                { "TANGENT", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, offsetof(Vertex, tangent), D3D11_INPUT_PER_VERTEX_DATA, 0 },
-                { "BLENDWEIGHT", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, offsetof(Vertex, blendWeights), D3D11_INPUT_PER_VERTEX_DATA, 0 },
-                { "BLENDINDICES", 0, DXGI_FORMAT_R32G32B32A32_UINT, 0, offsetof(Vertex, blendIndices), D3D11_INPUT_PER_VERTEX_DATA, 0 },
-            };
-            auto res = device->CreateInputLayout(elementDesc, 6, shaderDesc->vertexShaderCode, shaderDesc->vertexShaderCodeSize, &layout);
-            if (!SUCCEEDED(res)) {
-                printf("Failed to create input layout\n");
-                layout = nullptr;
-            }
+    static ID3D11InputLayout* layout = nullptr;
+    if (!layout) {
+        D3D11_INPUT_ELEMENT_DESC elementDesc[] = {
+            { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, offsetof(Vertex, position), D3D11_INPUT_PER_VERTEX_DATA, 0 },
+            { "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, offsetof(Vertex, normal), D3D11_INPUT_PER_VERTEX_DATA, 0 },
+            { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, offsetof(Vertex, uv), D3D11_INPUT_PER_VERTEX_DATA, 0 },
+            { "TANGENT", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, offsetof(Vertex, tangent), D3D11_INPUT_PER_VERTEX_DATA, 0 },
+            { "BLENDWEIGHT", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, offsetof(Vertex, blendWeights), D3D11_INPUT_PER_VERTEX_DATA, 0 },
+            { "BLENDINDICES", 0, DXGI_FORMAT_R32G32B32A32_UINT, 0, offsetof(Vertex, blendIndices), D3D11_INPUT_PER_VERTEX_DATA, 0 },
+        };
+        auto res = device->CreateInputLayout(elementDesc, 6, shaderDesc->vertexShaderCode, shaderDesc->vertexShaderCodeSize, &layout);
+        if (!SUCCEEDED(res)) {
+            printf("Failed to create input layout\n");
+            layout = nullptr;
         }
-        return layout;
     }
-};
-
-using IndexType = uint32_t;
-struct MeshDesc
-{
-    Vertex*     vertices = nullptr;
-    IndexType*  indices = nullptr;
-
-    uint32_t    numVertices = 0;
-    uint32_t    numIndices = 0;
-};
+    return layout;
+}
 
 struct Mesh 
 {
@@ -104,6 +100,9 @@ struct Mesh
     ID3D11Buffer* indexBuffer = nullptr;
     
     uint32_t numElements = 0;
+    Submesh* submeshes = nullptr;       // draw ranges into indexBuffer
+    uint32_t numSubmeshes = 0;
+    Arena arena;                        // holds submeshes
 };
 
 bool CreateMesh(ID3D11Device* device, MeshDesc* desc, Mesh* mesh)
@@ -153,63 +152,31 @@ bool CreateMesh(ID3D11Device* device, MeshDesc* desc, Mesh* mesh)
         }
     }
 
+    // the desc may be released right after, so the mesh keeps a copy of the ranges, as many as the source has
+    ArenaMeasure(&mesh->arena, sizeof(Submesh) * desc->numSubmeshes, alignof(Submesh));
+    if (!ArenaCommit(&mesh->arena)) {
+        printf("Failed to allocate submeshes\n");
+        mesh->vertexBuffer->Release();
+        mesh->indexBuffer->Release();
+        *mesh = Mesh();
+        return false;
+    }
     mesh->numElements = desc->numIndices;
+    mesh->submeshes = ArenaAllocArray<Submesh>(&mesh->arena, desc->numSubmeshes);
+    memcpy(mesh->submeshes, desc->submeshes, sizeof(Submesh) * desc->numSubmeshes);
+    mesh->numSubmeshes = desc->numSubmeshes;
 
     return true;
 }
-///
 
-///
-static void* Win32LoadFileContents(const char* path, uint32_t* outFileSize)
+void ReleaseMesh(Mesh* mesh)
 {
-    HANDLE handle = CreateFileA(path, GENERIC_READ, 0, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
-    if (handle == INVALID_HANDLE_VALUE) {
-        printf("Failed to load %s\n", path);
-        return nullptr;
-    }
-    DWORD size = GetFileSize(handle, NULL);
-    void* buffer = malloc(size);
-    memset(buffer, 0x0, size);  // for text files
-    DWORD bytesRead = 0;
-    auto res = ReadFile(handle, buffer, size, &bytesRead, NULL);
-    if (res == FALSE || bytesRead != size) {
-        printf("Failed to read %s - bytes read: %lu / %lu\n", path, bytesRead, size);
-        free(buffer);
-        CloseHandle(handle);
-        return nullptr;
-    }
-    if (outFileSize) {
-        *outFileSize = (uint32_t)size;
-    }
-    CloseHandle(handle);
-    return buffer;
+    mesh->vertexBuffer->Release();
+    mesh->indexBuffer->Release();
+    ArenaRelease(&mesh->arena);
+    *mesh = Mesh();
 }
-
 ///
-struct ByteStream
-{
-    char*   buffer = nullptr;
-    size_t  bufferSize = 0;
-    size_t  offset = 0;
-
-    template <class T>
-    T Read()
-    {
-        T res;
-        auto readSize = ReadBytes(&res, sizeof(res));
-        //GT_ASSERT(readSize == sizeof(res));
-        return res;
-    }
-
-    size_t ReadBytes(void* dest, size_t numBytes)
-    {
-        numBytes = (offset + numBytes) <= bufferSize ? numBytes : bufferSize - offset;
-        if (dest == nullptr) { offset += numBytes;  return numBytes; };
-        memcpy(dest, buffer + offset, numBytes);
-        offset += numBytes;
-        return numBytes;
-    }
-};
 
 ///
 struct ObjectConstantData
@@ -224,8 +191,6 @@ struct FrameConstantData
     float cameraProjection[16];
 };
 
-#define MAX_NUM_BONES 128
-
 struct SkeletonConstantData
 {
     float boneTransform[MAX_NUM_BONES][16];
@@ -233,444 +198,529 @@ struct SkeletonConstantData
 ///
 
 
-struct Joint
+struct AnimationLayer
 {
-    float   bindpose[16];   // local space bindpose
-    float   invBindpose[16]; 
-    float   globalTransform[16];
-    float   localTransform[16];
-    int     importId;   // @HACK
-    int     parent;
+    JointTransform  transforms[MAX_NUM_BONES];
+    uint32_t        keyCursors[MAX_NUM_BONES] = {};     // per track, the key sampled last, only ever a hint (see AdvanceKeySpan)
 };
 
-struct JointTransform
-{
-    math::Vec3 translation;
-    math::Vec4 rotation;
-};
 
-struct Skeleton
+#define MAX_NUM_ANIMATION_LAYERS 32
+struct AnimationStack
 {
-    float bindpose[MAX_NUM_BONES][16];      // global space bindposes
-    float invBindpose[MAX_NUM_BONES][16];   // global space inverse bindposes
-    char* nameTable[MAX_NUM_BONES];   // contains human readable names of joints
-    Joint joints[MAX_NUM_BONES];            // actual joints
-    uint32_t numJoints;
+    Skeleton*       referenceSkeleton = nullptr;
+    AnimationLayer  layers[MAX_NUM_ANIMATION_LAYERS];
 };
 
-uint32_t TransferNode(Skeleton* source, Skeleton* target, uint32_t& writeOffset, int nodeIdx)
+
+void ComputeLocalPoses(AnimationLayer* target, Skeleton* referenceSkeleton, AnimationClip* clip, float time);
+void ComputeLocalPoses(AnimationLayer* target, Skeleton* referenceSkeleton, CompressedClip* clip, float time);
+void ComputeLocalPoses(AnimationLayer* target, Skeleton* referenceSkeleton, StreamedClip* clip, float time);
+void ComputeLocalPoses(AnimationLayer* target, Skeleton* referenceSkeleton, ResampledClip* clip, float time);
+
+
+void PlayClip(AnimationStack* stack, AnimationClip* clip, uint32_t targetLayerIdx, float t)
 {
-    if (source->joints[nodeIdx].importId == -1) {
-        for (uint32_t i = 0; i < target->numJoints; ++i) {
-            if (target->joints[i].importId == nodeIdx) { return i; }
-        }
-    }
-    if (source->joints[nodeIdx].parent != -1) {
-        source->joints[nodeIdx].parent = TransferNode(source, target, writeOffset, source->joints[nodeIdx].parent);
-    }
-    target->numJoints++;
-    target->joints[writeOffset] = source->joints[nodeIdx];
-    target->nameTable[writeOffset] = source->nameTable[nodeIdx];
-    memcpy(target->bindpose[writeOffset], source->bindpose[nodeIdx], sizeof(float) * 16);
-    memcpy(target->invBindpose[writeOffset], source->invBindpose[nodeIdx], sizeof(float) * 16);
-    writeOffset++;
-    source->joints[nodeIdx].importId = -1;
-    return writeOffset - 1;
+    auto layer = &stack->layers[targetLayerIdx];
+    ComputeLocalPoses(layer, stack->referenceSkeleton, clip, t);
 }
 
-void SortSkeleton(Skeleton* source, Skeleton* target)
+// layer transforms that ApplyLayerToSkeleton turns back into the skeleton's bind pose
+void ComputeBindPose(AnimationLayer* target, Skeleton* referenceSkeleton)
 {
-    uint32_t writeOffset = 0;
-    uint32_t readOffset = 0;
-    while (readOffset < MAX_NUM_BONES && readOffset < source->numJoints) {
-        TransferNode(source, target, writeOffset, readOffset);
-        readOffset++;
+    for (uint32_t i = 0; i < referenceSkeleton->numJoints; ++i) {
+        auto& joint = referenceSkeleton->joints[i];
+        target->transforms[i].rotation = QuatFromMatrix(joint.bindpose);
+        // ApplyLayerToSkeleton adds the bind translation back in for every joint but the root
+        target->transforms[i].translation = i == 0 ? math::Get4x4FloatMatrixColumnCM(joint.bindpose, 3).xyz : math::Vec3();
     }
 }
 
-void QuatToMatrix(const math::Vec4& quat, float* outMatrix)
+void TwoWayBlend(AnimationStack* stack, uint32_t layerAIdx, uint32_t layerBIdx, uint32_t targetLayerIdx, float a)
 {
-    auto qx = quat.x;
-    auto qy = quat.y;
-    auto qz = quat.z;
-    auto qw = quat.w;
-
-    float temp[16];
-    temp[0] = 1.0f - 2.0f*qy*qy - 2.0f*qz*qz;
-    temp[1] = 2.0f*qx*qy - 2.0f*qz*qw;
-    temp[2] = 2.0f*qx*qz + 2.0f*qy*qw;
-    temp[3] = 0.0f;
-    temp[4] = 2.0f*qx*qy + 2.0f*qz*qw;
-    temp[5] = 1.0f - 2.0f*qx*qx - 2.0f*qz*qz;
-    temp[6] = 2.0f*qy*qz - 2.0f*qx*qw;
-    temp[7] = 0.0f;
-    temp[8] = 2.0f*qx*qz - 2.0f*qy*qw;
-    temp[9] = 2.0f*qy*qz + 2.0f*qx*qw;
-    temp[10] = 1.0f - 2.0f*qx*qx - 2.0f*qy*qy;
-    temp[11] = 0.0f;
-    temp[12] = 0.0f;
-    temp[13] = 0.0f;
-    temp[14] = 0.0f;
-    temp[15] = 1.0f;
-
-    float rot[16];
-    float conv[16];
-    math::Make4x4FloatMatrixIdentity(conv);
-    //math::Make4x4FloatRotationMatrixCMLH(conv, math::Vec3(1.0f, 0.0f, 0.0f), math::DegreesToRadians(90.0f));
+    auto target = &stack->layers[targetLayerIdx];
+    auto layerA = &stack->layers[layerAIdx];
+    auto layerB = &stack->layers[layerBIdx];
 
-    math::Make4x4FloatMatrixTranspose(temp, rot);
-    math::MultiplyMatricesCM(conv, rot, outMatrix);
+    for (uint32_t i = 0; i < stack->referenceSkeleton->numJoints; ++i)
+    {
+        target->transforms[i].translation = math::Lerp(layerA->transforms[i].translation, layerB->transforms[i].translation, a);
+        target->transforms[i].rotation = math::Slerp(layerA->transforms[i].rotation, layerB->transforms[i].rotation, a);
+    }
 }
 
+///
+/**
+    Paged clips
+    OpenPagedClip only reads the clip header and remembers where each track's keyframes start in the source.
+    A track's keyframes are copied in the first time ComputeLocalPoses samples it. Once the ClipPager the clip
+    is sampled through exceeds its budget, the least recently sampled tracks of all its clips are evicted again.
+    Paging is not thread safe, a pager and its clips are sampled from one thread.
+*/
+#define MAX_PAGED_CLIPS 128
 
-bool ImportSkeletonFromMemory(ByteStream& stream, Skeleton* outSkeleton)
+struct PagedClip
 {
-    auto magicNumber = stream.Read<uint32_t>();
-    assert(magicNumber == 383405658);
-
-    auto version = stream.Read<uint8_t>();
-    assert(version == 1);
-
-    auto nameLen = stream.Read<uint16_t>();
-    stream.ReadBytes(nullptr, nameLen);   // skip the name
-
-    outSkeleton->numJoints = (uint32_t)stream.Read<uint16_t>(); 
-    
-    Skeleton tempSkeleton;
-    tempSkeleton.numJoints = outSkeleton->numJoints;
-    assert(outSkeleton->numJoints <= MAX_NUM_BONES);
-    char* buf = new char[MAX_NUM_BONES * 512];
-    memset(buf, 0x0, MAX_NUM_BONES * 512);
-    uint32_t bufOffset = 0;
-    int tempParentIndexTable[MAX_NUM_BONES];
-    for (auto i = 0; i < MAX_NUM_BONES; ++i) { tempParentIndexTable[i] = -1; }
-
-    for (uint32_t i = 0; i < outSkeleton->numJoints; ++i) {
-        // read the bone name and store it
-        auto nameLen = stream.Read<uint16_t>();
-        assert(nameLen < 512);
-        stream.ReadBytes(buf + bufOffset, nameLen);
-        tempSkeleton.nameTable[i] = buf + bufOffset;
-        bufOffset += nameLen;
-        // read the bind pose
-        auto& joint = tempSkeleton.joints[i];   
-        joint.importId = i;
-
-        /*
-        float spaceConversion[16] = {
-            1.0f, 0.0f, 0.0f, 0.0f,
-            0.0f, 0.0f, 1.0f, 0.0f,
-            0.0f, 1.0f, 0.0f, 0.0f,
-            0.0f, 0.0f, 0.0f, 1.0f,
-        };
+    AnimationClip   clip;                           // times and keyframes == nullptr while a track is not resident
+    StreamSource    source;
+    ByteStream      stream;
+    size_t          trackOffsets[MAX_NUM_BONES];    // where each track's keyframes start in stream
+    uint64_t        lastSampled[MAX_NUM_BONES];     // ClipPager::frame the track was last sampled in
+    bool            registered = false;
+};
 
-        float temp[16];
-        stream.ReadBytes(temp, sizeof(float) * 16);
-        math::MultiplyMatricesCM(spaceConversion, temp, tempSkeleton.bindpose[i]);
-        */
-        //stream.ReadBytes(tempSkeleton.bindpose[i], sizeof(float) * 16);
-        auto pos = stream.Read<math::Vec3>();
-        auto scale = stream.Read<math::Vec3>();  // ignore scale 
-        auto rot = stream.Read<math::Vec4>();
-
-        float rotMat[16];
-        float transMat[16];
-        float transScaled[16];
-        float scaleMat[16];
-        QuatToMatrix(rot, rotMat);
-        math::Make4x4FloatTranslationMatrixCM(transMat, pos);   // 
-        math::Make4x4FloatMatrixIdentity(scaleMat);
-        scaleMat[0] = scale.x;
-        scaleMat[5] = scale.y;
-        scaleMat[10] = scale.z;
-        
-        math::MultiplyMatricesCM(transMat, scaleMat, transScaled);
-        math::MultiplyMatricesCM(transScaled, rotMat, tempSkeleton.joints[i].bindpose);
-       
+struct ClipPager
+{
+    size_t      budget = 0;
+    size_t      residentBytes = 0;
+    size_t      pagedInBytes = 0;   // running totals for profiling
+    size_t      evictedBytes = 0;
+    uint64_t    frame = 1;
+    PagedClip*  clips[MAX_PAGED_CLIPS];
+    uint32_t    numClips = 0;
+};
 
-        //math::Make4x4FloatTranslationMatrixCM(tempSkeleton.joints[i].bindpose, pos);
-        auto isParent = stream.Read<uint8_t>() == 1;
-        if (isParent) {
-            joint.parent = -1;
-        }
-        else {
-            joint.parent = 0;
-        }
-        auto numChildren = stream.Read<uint16_t>();
-        uint16_t children[MAX_NUM_BONES];
-        assert(numChildren <= MAX_NUM_BONES);
-        stream.ReadBytes(children, sizeof(uint16_t) * numChildren);
-        for(uint16_t c = 0; c < numChildren; ++c) {
-            tempParentIndexTable[children[c]] = i;
-        }
+bool OpenPagedClip(const char* path, Skeleton* targetSkeleton, PagedClip* outClip)
+{
+    auto& paged = *outClip;
+    if (!OpenByteStream(path, &paged.source, &paged.stream)) {
+        return false;
     }
-    for (uint16_t i = 0; i < tempSkeleton.numJoints; ++i) {
-        tempSkeleton.joints[i].parent = tempParentIndexTable[i];
+    auto& stream = paged.stream;
+    AnimationClip& anim = paged.clip;
+    float biggestTimestamp = 0.0f;
+    if (stream.Require(sizeof(uint32_t) * 3, "header")) {
+        auto magicNumber = stream.ReadUnchecked<uint32_t>();
+        auto version = stream.ReadUnchecked<uint32_t>();
+        if (magicNumber != 0xdeadbeef) { stream.Fail(PARSE_BAD_MAGIC, "header"); }
+        else if (version != 1) { stream.Fail(PARSE_BAD_VERSION, "header"); }
     }
-    SortSkeleton(&tempSkeleton, outSkeleton);
-    outSkeleton->numJoints = tempSkeleton.numJoints;
-    for (int i = 0; i < (int)outSkeleton->numJoints; ++i) {
-        assert(outSkeleton->joints[i].parent < i);
+    if (stream.Ok()) {
+        auto nameLen = stream.ReadUnchecked<uint32_t>();
+        if (stream.Require((size_t)nameLen + sizeof(uint32_t), "name")) {
+            anim.name = (char*)malloc(nameLen + 1);
+            stream.ReadBytesUnchecked(anim.name, nameLen);
+            anim.name[nameLen] = '\0';
+            anim.numTracks = stream.ReadUnchecked<uint32_t>();
+            if (anim.numTracks > MAX_NUM_BONES) { stream.Fail(PARSE_OUT_OF_RANGE, "track count"); }
+        }
     }
-    // compute inverse bind transforms as well as global space bind and inverse bind transform for each bone
-    for (int i = 0; i < (int)outSkeleton->numJoints; ++i) {
-        auto& joint = outSkeleton->joints[i];
-        if (joint.parent == -1) {
-            math::Copy4x4FloatMatrixCM(joint.bindpose, outSkeleton->bindpose[i]);
+    for (uint32_t j = 0; j < anim.numTracks && stream.Ok(); ++j) {
+        if (!stream.Require(sizeof(uint32_t) * 2, "track header")) {
+            break;
         }
-        else {
-            math::MultiplyMatricesCM(outSkeleton->bindpose[joint.parent], joint.bindpose, outSkeleton->bindpose[i]);
+        auto importId = stream.ReadUnchecked<uint32_t>();
+        auto id = GetBoneWithImportId(targetSkeleton, importId);
+        auto numKeyframes = stream.ReadUnchecked<uint32_t>();
+        size_t trackSize = GTANIM_KEYFRAME_SIZE * numKeyframes;
+        if (id < 0) {
+            stream.Fail(PARSE_OUT_OF_RANGE, "track joint");
+            break;
+        }
+        if (!stream.Require(trackSize, "keyframes")) {
+            break;
         }
-        math::Inverse4x4FloatMatrixCM(outSkeleton->bindpose[i], outSkeleton->invBindpose[i]);
-        math::Inverse4x4FloatMatrixCM(joint.bindpose, joint.invBindpose);
+        auto& track = anim.tracks[id];
+        track.numKeyframes = numKeyframes;
+        track.times = nullptr;
+        track.keyframes = nullptr;
+        paged.trackOffsets[id] = stream.offset;
+        paged.lastSampled[id] = 0;
+        if (numKeyframes != 0) {    // keys are sorted, the last one carries the biggest timestamp
+            float lastTimestamp;
+            memcpy(&lastTimestamp, stream.buffer + stream.offset + trackSize - GTANIM_KEYFRAME_SIZE, sizeof(float));
+            if (lastTimestamp > biggestTimestamp) { biggestTimestamp = lastTimestamp; }
+        }
+        stream.SkipUnchecked(trackSize);
     }
-
+    if (!stream.Ok()) {
+        ReportParseError(path, stream);
+        free(anim.name);
+        anim = AnimationClip();
+        CloseByteStream(&paged.source, &stream);
+        return false;
+    }
+    anim.duration = biggestTimestamp;
     return true;
 }
 
-bool ImportSkeletonFromSGA(const char* path, Skeleton* outSkeleton)
+static void EvictPagedTrack(ClipPager* pager, PagedClip* paged, uint32_t trackIdx)
 {
-    uint32_t fileSize;
-    ByteStream stream;
-    stream.buffer = (char*)Win32LoadFileContents(path, &fileSize);
-    stream.bufferSize = (size_t)(fileSize);
-    stream.offset = 0;
-
-    return ImportSkeletonFromMemory(stream, outSkeleton);
+    auto& track = paged->clip.tracks[trackIdx];
+    size_t trackSize = (sizeof(float) + sizeof(Keyframe)) * track.numKeyframes;
+    delete[] track.times;
+    delete[] track.keyframes;
+    track.times = nullptr;
+    track.keyframes = nullptr;
+    pager->residentBytes -= trackSize;
+    pager->evictedBytes += trackSize;
 }
 
-
-bool ImportGTSkeleton(const char* path, Skeleton* outSkeleton)
+// evicts least recently sampled tracks until bytesNeeded fit, tracks sampled in the current frame are kept
+static void MakeRoomInPager(ClipPager* pager, size_t bytesNeeded)
 {
-    uint32_t fileSize;
-    ByteStream stream;
-    stream.buffer = (char*)Win32LoadFileContents(path, &fileSize);
-    stream.bufferSize = (size_t)(fileSize);
-    stream.offset = 0;
-
-    auto magicNumber = stream.Read<uint32_t>();
-    assert(magicNumber == 0xdeadbeef);
-
-    auto version = stream.Read<uint32_t>();
-    assert(version == 1);
+    while (pager->residentBytes + bytesNeeded > pager->budget) {
+        PagedClip* victim = nullptr;
+        uint32_t victimTrack = 0;
+        uint64_t oldest = pager->frame;
+        for (uint32_t c = 0; c < pager->numClips; ++c) {
+            auto paged = pager->clips[c];
+            for (uint32_t i = 0; i < MAX_NUM_BONES; ++i) {
+                if (paged->clip.tracks[i].keyframes != nullptr && paged->lastSampled[i] < oldest) {
+                    victim = paged;
+                    victimTrack = i;
+                    oldest = paged->lastSampled[i];
+                }
+            }
+        }
+        if (victim == nullptr) {    // everything resident is in use, run over budget for this frame
+            return;
+        }
+        EvictPagedTrack(pager, victim, victimTrack);
+    }
+}
 
-    Skeleton tempSkeleton;
-    char* buf = new char[MAX_NUM_BONES * 512];
-    memset(buf, 0x0, MAX_NUM_BONES * 512);
-    uint32_t bufOffset = 0;
+void ClosePagedClip(ClipPager* pager, PagedClip* paged)
+{
+    for (uint32_t i = 0; i < MAX_NUM_BONES; ++i) {
+        if (paged->clip.tracks[i].keyframes != nullptr) {
+            EvictPagedTrack(pager, paged, i);
+        }
+    }
+    for (uint32_t c = 0; c < pager->numClips; ++c) {
+        if (pager->clips[c] == paged) {
+            pager->clips[c] = pager->clips[--pager->numClips];
+            break;
+        }
+    }
+    free(paged->clip.name);
+    CloseByteStream(&paged->source, &paged->stream);
+    paged->clip = AnimationClip();
+    paged->registered = false;
+}
 
-    tempSkeleton.numJoints = stream.Read<uint32_t>();
-    for (uint32_t i = 0; i < tempSkeleton.numJoints; ++i) {
-        uint32_t nameLen = stream.Read<uint32_t>();
-        stream.ReadBytes(buf + bufOffset, nameLen);
-        tempSkeleton.nameTable[i] = buf + bufOffset;
-        bufOffset += nameLen + 1;
+// starts a new frame, tracks sampled before it become candidates for eviction
+void AdvanceClipPager(ClipPager* pager)
+{
+    pager->frame++;
+}
 
-        float bindpose[16];
-        stream.ReadBytes(bindpose, sizeof(float) * 16);
-        math::Copy4x4FloatMatrixCM(bindpose, tempSkeleton.bindpose[i]);
-        
-        tempSkeleton.joints[i].importId = i;
-        tempSkeleton.joints[i].parent = stream.Read<int32_t>();
-    }
-    
-    SortSkeleton(&tempSkeleton, outSkeleton);
-    for (int i = 0; i < (int)outSkeleton->numJoints; ++i) {
-        assert(outSkeleton->joints[i].parent < i);
+void ComputeLocalPoses(AnimationLayer* target, Skeleton* referenceSkeleton, ClipPager* pager, PagedClip* paged, float time)
+{
+    if (!paged->registered) {
+        assert(pager->numClips < MAX_PAGED_CLIPS);
+        pager->clips[pager->numClips++] = paged;
+        paged->registered = true;
     }
-    // compute inverse bind transforms as well as global space bind and inverse bind transform for each bone, make joint transforms local to parent
-    for (int i = 0; i < (int)outSkeleton->numJoints; ++i) {
-        auto& joint = outSkeleton->joints[i];
-        if (joint.parent == -1) {
-            math::Copy4x4FloatMatrixCM(outSkeleton->bindpose[i], joint.bindpose);
+    for (uint32_t jointIdx = 0; jointIdx < referenceSkeleton->numJoints; ++jointIdx) {
+        auto& track = paged->clip.tracks[jointIdx];
+        if (track.numKeyframes == 0) {
+            continue;
         }
-        else {
-            math::MultiplyMatricesCM(outSkeleton->invBindpose[joint.parent], outSkeleton->bindpose[i], joint.bindpose);
+        paged->lastSampled[jointIdx] = pager->frame;
+        if (track.keyframes == nullptr) {    // paged tracks own their times, they come and go one track at a time
+            size_t trackSize = (sizeof(float) + sizeof(Keyframe)) * track.numKeyframes;
+            MakeRoomInPager(pager, trackSize);
+            track.times = new float[track.numKeyframes];
+            track.keyframes = new Keyframe[track.numKeyframes];
+            const char* keys = paged->stream.buffer + paged->trackOffsets[jointIdx];
+            for (uint32_t k = 0; k < track.numKeyframes; ++k) {
+                memcpy(&track.times[k], keys + k * GTANIM_KEYFRAME_SIZE, sizeof(float));
+                memcpy(&track.keyframes[k], keys + k * GTANIM_KEYFRAME_SIZE + sizeof(float), sizeof(Keyframe));
+            }
+            pager->residentBytes += trackSize;
+            pager->pagedInBytes += trackSize;
         }
-        math::Inverse4x4FloatMatrixCM(outSkeleton->bindpose[i], outSkeleton->invBindpose[i]);
-        math::Inverse4x4FloatMatrixCM(joint.bindpose, joint.invBindpose);
-
     }
-
-    return true;
+    ComputeLocalPoses(target, referenceSkeleton, &paged->clip, time);
 }
-///
 
-struct Keyframe
+///
+/**
+    Asynchronous clip loading
+    LoadClipAsync returns right away and decodes the clip on the job pool. The clip is published by storing
+    CLIP_LOAD_READY into its handle once it has been written completely, so readers must check IsClipReady
+    (or block in WaitForClip) before they touch it.
+*/
+enum ClipLoadState : uint32_t
 {
-    float           timeStamp;
-    math::Vec3      position;
-    math::Vec4      rotation;
+    CLIP_LOAD_PENDING   = 0,
+    CLIP_LOAD_READY     = 1,
+    CLIP_LOAD_FAILED    = 2,
 };
 
-struct BoneTrack
+// how clips are held in memory, an app loads all of its clips the same way
+enum ClipStorageKind : uint32_t
 {
-    uint32_t    numKeyframes = 0;
-    Keyframe*   keyframes = nullptr;
+    CLIP_STORAGE_WHOLE      = 0,    // AnimationClip, every keyframe resident
+    CLIP_STORAGE_PAGED      = 1,    // PagedClip, keyframes are paged in through a ClipPager when sampled
+    CLIP_STORAGE_COMPRESSED = 2,    // CompressedClip, see clipcompression.h
+    CLIP_STORAGE_STREAMED   = 3,    // StreamedClip, segments stream in when sampled, see clipsegments.h
+    CLIP_STORAGE_RESAMPLED  = 4,    // ResampledClip, see clipresampling.h
 };
 
-struct AnimationClip
+// a clip of the kind it is tagged with, or none if object is nullptr; only the accessor for kind may be used on it
+struct ClipStorage
 {
-    char*           name  = "";
-    uint32_t        numTracks = 0;
-    BoneTrack       tracks[MAX_NUM_BONES];
-    float           duration = 0.0f;
+    ClipStorageKind kind = CLIP_STORAGE_WHOLE;
+    void*           object = nullptr;
 };
 
-
-
-struct AnimationLayer
+static AnimationClip* GetWholeClip(ClipStorage storage)
 {
-    JointTransform  transforms[MAX_NUM_BONES];
-};
+    assert(storage.kind == CLIP_STORAGE_WHOLE);
+    return static_cast<AnimationClip*>(storage.object);
+}
 
+static PagedClip* GetPagedClip(ClipStorage storage)
+{
+    assert(storage.kind == CLIP_STORAGE_PAGED);
+    return static_cast<PagedClip*>(storage.object);
+}
 
-#define MAX_NUM_ANIMATION_LAYERS 32
-struct AnimationStack
+static CompressedClip* GetCompressedClip(ClipStorage storage)
 {
-    Skeleton*       referenceSkeleton = nullptr;
-    AnimationLayer  layers[MAX_NUM_ANIMATION_LAYERS];
-};
+    assert(storage.kind == CLIP_STORAGE_COMPRESSED);
+    return static_cast<CompressedClip*>(storage.object);
+}
 
+static StreamedClip* GetStreamedClip(ClipStorage storage)
+{
+    assert(storage.kind == CLIP_STORAGE_STREAMED);
+    return static_cast<StreamedClip*>(storage.object);
+}
 
-void ComputeLocalPoses(AnimationLayer* target, Skeleton* referenceSkeleton, AnimationClip* clip, float time);
+static ResampledClip* GetResampledClip(ClipStorage storage)
+{
+    assert(storage.kind == CLIP_STORAGE_RESAMPLED);
+    return static_cast<ResampledClip*>(storage.object);
+}
 
+// an empty clip of kind, freed with DeleteClipStorage
+static ClipStorage NewClipStorage(ClipStorageKind kind)
+{
+    ClipStorage storage;
+    storage.kind = kind;
+    switch (kind) {
+    case CLIP_STORAGE_WHOLE:        storage.object = new AnimationClip(); break;
+    case CLIP_STORAGE_PAGED:        storage.object = new PagedClip(); break;
+    case CLIP_STORAGE_COMPRESSED:   storage.object = new CompressedClip(); break;
+    case CLIP_STORAGE_STREAMED:     storage.object = new StreamedClip(); break;
+    case CLIP_STORAGE_RESAMPLED:    storage.object = new ResampledClip(); break;
+    }
+    return storage;
+}
 
-void PlayClip(AnimationStack* stack, AnimationClip* clip, uint32_t targetLayerIdx, float t)
+// only frees the storage, whatever the clip holds has to be released first
+static void DeleteClipStorage(ClipStorage* storage)
 {
-    auto layer = &stack->layers[targetLayerIdx];
-    ComputeLocalPoses(layer, stack->referenceSkeleton, clip, t);
+    switch (storage->kind) {
+    case CLIP_STORAGE_WHOLE:        delete GetWholeClip(*storage); break;
+    case CLIP_STORAGE_PAGED:        delete GetPagedClip(*storage); break;
+    case CLIP_STORAGE_COMPRESSED:   delete GetCompressedClip(*storage); break;
+    case CLIP_STORAGE_STREAMED:     delete GetStreamedClip(*storage); break;
+    case CLIP_STORAGE_RESAMPLED:    delete GetResampledClip(*storage); break;
+    }
+    storage->object = nullptr;
 }
 
-void TwoWayBlend(AnimationStack* stack, uint32_t layerAIdx, uint32_t layerBIdx, uint32_t targetLayerIdx, float a)
+// loads the clip at path into storage, from its bake mapped into bakedFile for the kinds that have one, otherwise or
+// without bakedFile it's imported from the source
+static bool LoadClipStorage(ClipStorage storage, const char* path, Skeleton* targetSkeleton, FileMapping* bakedFile)
 {
-    auto target = &stack->layers[targetLayerIdx];
-    auto layerA = &stack->layers[layerAIdx];
-    auto layerB = &stack->layers[layerBIdx];
+    switch (storage.kind) {
+    case CLIP_STORAGE_WHOLE:
+        return (bakedFile != nullptr && LoadBakedAnimation(path, targetSkeleton, bakedFile, GetWholeClip(storage)))
+            || ImportGTAnimation(path, targetSkeleton, GetWholeClip(storage));
+    case CLIP_STORAGE_PAGED:
+        return OpenPagedClip(path, targetSkeleton, GetPagedClip(storage));
+    case CLIP_STORAGE_COMPRESSED:
+        return (bakedFile != nullptr && LoadBakedCompressedClip(path, targetSkeleton, bakedFile, GetCompressedClip(storage)))
+            || ImportCompressedClip(path, targetSkeleton, GetCompressedClip(storage));
+    case CLIP_STORAGE_STREAMED:
+        return OpenStreamedClip(path, targetSkeleton, GetStreamedClip(storage));
+    case CLIP_STORAGE_RESAMPLED:
+        return (bakedFile != nullptr && LoadBakedResampledClip(path, targetSkeleton, bakedFile, GetResampledClip(storage)))
+            || ImportResampledClip(path, targetSkeleton, GetResampledClip(storage));
+    }
+    return false;
+}
 
-    for (uint32_t i = 0; i < stack->referenceSkeleton->numJoints; ++i)
-    {
-        target->transforms[i].translation = math::Lerp(layerA->transforms[i].translation, layerB->transforms[i].translation, a);
-        target->transforms[i].rotation = math::Slerp(layerA->transforms[i].rotation, layerB->transforms[i].rotation, a);
+// for clips imported without a bake that were never played, paged ones then hold no keyframes and aren't registered
+// with a pager; frees the storage too
+static void ReleaseUnusedClipStorage(ClipStorage* storage)
+{
+    switch (storage->kind) {
+    case CLIP_STORAGE_WHOLE:
+        ReleaseAnimationClip(GetWholeClip(*storage));
+        break;
+    case CLIP_STORAGE_PAGED: {
+        auto paged = GetPagedClip(*storage);
+        free(paged->clip.name);
+        CloseByteStream(&paged->source, &paged->stream);
+        break;
+    }
+    case CLIP_STORAGE_COMPRESSED:
+        ReleaseCompressedClip(GetCompressedClip(*storage));
+        break;
+    case CLIP_STORAGE_STREAMED:
+        CloseStreamedClip(GetStreamedClip(*storage));
+        break;
+    case CLIP_STORAGE_RESAMPLED:
+        ReleaseResampledClip(GetResampledClip(*storage));
+        break;
     }
+    DeleteClipStorage(storage);
 }
 
-///
-int GetBoneWithName(Skeleton* skeleton, const char* name)
+// the clip must have been loaded
+static const char* GetClipName(ClipStorage storage)
 {
-    for (uint32_t i = 0; i < skeleton->numJoints && i < MAX_NUM_BONES; ++i) {
-        if (strcmp(skeleton->nameTable[i], name) == 0) {
-            return (int)i;
-        }
+    switch (storage.kind) {
+    case CLIP_STORAGE_WHOLE:        return GetWholeClip(storage)->name;
+    case CLIP_STORAGE_PAGED:        return GetPagedClip(storage)->clip.name;
+    case CLIP_STORAGE_COMPRESSED:   return GetCompressedClip(storage)->name;
+    case CLIP_STORAGE_STREAMED:     return GetStreamedClip(storage)->segmented.name;
+    case CLIP_STORAGE_RESAMPLED:    return GetResampledClip(storage)->name;
     }
-    return -1;
+    return nullptr;
 }
 
-int GetBoneWithImportId(Skeleton* skeleton, int importId)
+// the clip must have been loaded
+static float GetClipDuration(ClipStorage storage)
 {
-    for (uint32_t i = 0; i < skeleton->numJoints && i < MAX_NUM_BONES; ++i) {
-        if (skeleton->joints[i].importId == importId) {
-            return (int)i;
-        }
+    switch (storage.kind) {
+    case CLIP_STORAGE_WHOLE:        return GetWholeClip(storage)->duration;
+    case CLIP_STORAGE_PAGED:        return GetPagedClip(storage)->clip.duration;
+    case CLIP_STORAGE_COMPRESSED:   return GetCompressedClip(storage)->duration;
+    case CLIP_STORAGE_STREAMED:     return GetStreamedClip(storage)->segmented.duration;
+    case CLIP_STORAGE_RESAMPLED:    return GetResampledClip(storage)->duration;
     }
-    return -1;
+    return 0.0f;
 }
-///
-bool ImportAnimationFromSGA(const char* path, Skeleton* targetSkeleton, AnimationClip* outAnimations, uint32_t* outNumAnimations)
+
+struct ClipHandle
 {
-    return false;
-    //uint32_t fileSize;
-    //ByteStream stream;
-    //stream.buffer = (char*)Win32LoadFileContents(path, &fileSize);
-    //stream.bufferSize = (size_t)(fileSize);
-    //stream.offset = 0;
-
-    //{
-    //    Skeleton tempSkeleton;
-    //    if (!ImportSkeletonFromMemory(stream, &tempSkeleton)) {
-    //        assert(false);
-    //        return false;
-    //    }
-    //}
-
-    //*outNumAnimations = (uint32_t)stream.Read<uint16_t>();
-    //if (outAnimations != nullptr) {
-    //    for (uint32_t i = 0; i < *outNumAnimations; ++i) {
-    //        Animation& anim = outAnimations[i];
-    //        auto nameLen = stream.Read<uint16_t>();
-    //        anim.name = (char*)malloc(nameLen);
-    //        stream.ReadBytes(anim.name, nameLen);
-    //        auto numAffectedBones = stream.Read<uint16_t>();
-    //       
-    //        float biggestTimestamp = 0.0f;
-    //        for (uint16_t j = 0; j < numAffectedBones; ++j) {
-    //            auto importId = stream.Read<uint16_t>();
-    //            auto id = GetBoneWithImportId(targetSkeleton, importId);
-    //            auto& track = anim.tracks[id];
-    //            track.numKeyframes = stream.Read<uint32_t>();
-    //            track.keyframes = new KeyFrame[track.numKeyframes];
-    //            for (uint32_t k = 0; k < track.numKeyframes; ++k) {
-    //                auto& frame = track.keyframes[k];
-    //                frame.timeStamp = stream.Read<float>();
-    //                if (frame.timeStamp > biggestTimestamp) { biggestTimestamp = frame.timeStamp; }
-    //                frame.jointTransform.position = stream.Read<math::Vec3>();  
-    //                frame.jointTransform.scale = stream.Read<math::Vec3>();     // 
-    //                frame.jointTransform.rotation = stream.Read<math::Vec4>();  // rotation as a 4-component quaternion
-    //            }
-    //        }
-    //        anim.duration = biggestTimestamp;
-    //    }
-    //}
-    //return true;
+    const char*             path = nullptr;
+    Skeleton*               targetSkeleton = nullptr;
+    ClipStorage             storage;                // written by the worker, owned by the caller
+    FileMapping*            bakedFile = nullptr;    // backing storage if the clip is loaded from a .gtbin
+    ClipPager*              pager = nullptr;        // pages the keyframes of paged clips
+    TrackPool*              tracks = nullptr;       // set if the clip's tracks are shared through it
+    std::atomic<uint32_t>   state { CLIP_LOAD_PENDING };
+};
+
+// whole and compressed clips can share their tracks, see trackpool.h
+static bool CanShareClipTracks(ClipStorageKind kind)
+{
+    return kind == CLIP_STORAGE_WHOLE || kind == CLIP_STORAGE_COMPRESSED;
 }
 
+static void MoveClipStorageToTrackPool(TrackPool* pool, ClipStorage storage, FileMapping* bakedFile)
+{
+    if (storage.kind == CLIP_STORAGE_WHOLE) {
+        MoveClipToTrackPool(pool, GetWholeClip(storage), bakedFile);
+    }
+    else {
+        MoveCompressedClipToTrackPool(pool, GetCompressedClip(storage), bakedFile);
+    }
+}
 
-//
-bool ImportGTAnimation(const char* path, Skeleton* targetSkeleton, AnimationClip* outAnimation)
+static void ReleaseClipStorageTracks(TrackPool* pool, ClipStorage storage)
 {
-    uint32_t fileSize;
-    ByteStream stream;
-    stream.buffer = (char*)Win32LoadFileContents(path, &fileSize);
-    stream.bufferSize = (size_t)(fileSize);
-    stream.offset = 0;
+    if (storage.kind == CLIP_STORAGE_WHOLE) {
+        ReleaseClipTracks(pool, GetWholeClip(storage));
+    }
+    else {
+        ReleaseCompressedClipTracks(pool, GetCompressedClip(storage));
+    }
+}
 
-    auto magicNumber = stream.Read<uint32_t>();
-    assert(magicNumber == 0xdeadbeef);
+static void LoadClipJob(void* userData)
+{
+    auto handle = static_cast<ClipHandle*>(userData);
+    bool loaded = LoadClipStorage(handle->storage, handle->path, handle->targetSkeleton, handle->bakedFile);
+    if (loaded && handle->tracks != nullptr) {
+        MoveClipStorageToTrackPool(handle->tracks, handle->storage, handle->bakedFile);
+    }
+    if (loaded) {
+        printf("loaded anim: %s\n", GetClipName(handle->storage));
+    }
+    else {
+        printf("failed to load animation from %s\n", handle->path);
+    }
+    handle->state.store(loaded ? CLIP_LOAD_READY : CLIP_LOAD_FAILED, std::memory_order_release);
+}
 
-    auto version = stream.Read<uint32_t>();
-    assert(version == 1);
+// path, skeleton, the clip's storage and the baked file storage must stay valid until the load has completed; clips
+// of kinds with a bake are loaded from it if there is one (see LoadClipStorage)
+// paged clips page their keyframes in through pager when sampled, streamed ones stream their segments and prefetch the
+// next one on pool; with sharedTracks whole and compressed clips share their tracks through it (see trackpool.h) and the
+// baked file is unmapped again once they are
+void LoadClipAsync(JobPool* pool, ClipHandle* handle, const char* path, Skeleton* targetSkeleton, ClipStorage storage, FileMapping* outBakedFile,
+    ClipPager* pager = nullptr, TrackPool* sharedTracks = nullptr)
+{
+    assert((storage.kind == CLIP_STORAGE_PAGED) == (pager != nullptr));
+    assert(sharedTracks == nullptr || CanShareClipTracks(storage.kind));
+    handle->path = path;
+    handle->targetSkeleton = targetSkeleton;
+    handle->storage = storage;
+    handle->bakedFile = outBakedFile;
+    handle->pager = pager;
+    handle->tracks = sharedTracks;
+    if (storage.kind == CLIP_STORAGE_STREAMED) {
+        GetStreamedClip(storage)->pool = pool;
+    }
+    handle->state.store(CLIP_LOAD_PENDING, std::memory_order_relaxed);
+    PushJob(pool, LoadClipJob, handle);
+}
 
+bool IsClipReady(ClipHandle* handle)
+{
+    return handle->state.load(std::memory_order_acquire) == CLIP_LOAD_READY;
+}
 
-    AnimationClip& anim = *outAnimation;
-    auto nameLen = stream.Read<uint32_t>();
-    anim.name = (char*)malloc(nameLen + 1);
-    memset(anim.name, 0x0, nameLen + 1);
-    stream.ReadBytes(anim.name, nameLen);
-    float biggestTimestamp = 0.0f;
-    
-    anim.numTracks = stream.Read<uint32_t>();
-    for (uint32_t j = 0; j < anim.numTracks; ++j) {
-        auto importId = stream.Read<uint32_t>();
-        auto id = GetBoneWithImportId(targetSkeleton, importId);
-        {   // translation
-            auto& track = anim.tracks[id];
-            track.numKeyframes = stream.Read<uint32_t>();
-            //assert(track.numKeyframes != 0);
-            track.keyframes = new Keyframe[track.numKeyframes];
-            //printf("Bone: %s\n", targetSkeleton->nameTable[id]);
-            for (uint32_t k = 0; k < track.numKeyframes; ++k) {
-                auto& frame = track.keyframes[k];
-                frame.timeStamp = stream.Read<float>();
-                if (frame.timeStamp > biggestTimestamp) { biggestTimestamp = frame.timeStamp; }
-                frame.position = stream.Read<math::Vec3>();
-                frame.rotation = stream.Read<math::Vec4>();
-            }
+// blocks until the load has completed, running queued jobs meanwhile; returns false if the load failed
+bool WaitForClip(JobPool* pool, ClipHandle* handle)
+{
+    while (handle->state.load(std::memory_order_acquire) == CLIP_LOAD_PENDING) {
+        if (!RunPendingJob(pool)) {
+            YieldThread();
         }
     }
-    
-    anim.duration = biggestTimestamp;
-     
-    return true;
+    return IsClipReady(handle);
+}
+
+float GetClipDuration(ClipHandle* handle)
+{
+    return IsClipReady(handle) ? GetClipDuration(handle->storage) : 0.0f;
+}
+
+// plays the clip once it has been published and holds the bind pose until then
+void PlayClip(AnimationStack* stack, ClipHandle* handle, uint32_t targetLayerIdx, float t)
+{
+    auto layer = &stack->layers[targetLayerIdx];
+    if (!IsClipReady(handle)) {
+        ComputeBindPose(layer, stack->referenceSkeleton);
+        return;
+    }
+    switch (handle->storage.kind) {
+    case CLIP_STORAGE_WHOLE:
+        PlayClip(stack, GetWholeClip(handle->storage), targetLayerIdx, t);
+        break;
+    case CLIP_STORAGE_PAGED:
+        ComputeLocalPoses(layer, stack->referenceSkeleton, handle->pager, GetPagedClip(handle->storage), t);
+        break;
+    case CLIP_STORAGE_COMPRESSED:
+        ComputeLocalPoses(layer, stack->referenceSkeleton, GetCompressedClip(handle->storage), t);
+        break;
+    case CLIP_STORAGE_STREAMED:
+        ComputeLocalPoses(layer, stack->referenceSkeleton, GetStreamedClip(handle->storage), t);
+        break;
+    case CLIP_STORAGE_RESAMPLED:
+        ComputeLocalPoses(layer, stack->referenceSkeleton, GetResampledClip(handle->storage), t);
+        break;
+    }
 }
 
 ///
@@ -691,41 +741,74 @@ void ResetLocalTransforms(Skeleton* skeleton)
 }
 
 
+// tracks sharing their times with an earlier one reuse its key search, there are only a few distinct arrays per clip;
+// searches resume from the layer's cursors, so playing forward costs the same anywhere in a clip of any length
+#define KEY_SEARCH_CACHE_SIZE 4
+
 void ComputeLocalPoses(AnimationLayer* target, Skeleton* referenceSkeleton, AnimationClip* clip, float time)
 {
-    auto ComputeLocalJointPose = [](uint32_t jointIdx, AnimationClip* clip, float time, math::Vec3* outTranslation, math::Vec4* outRotation) -> void
-    {
-        assert(outTranslation != nullptr && outRotation != nullptr);
-        if (clip->tracks[jointIdx].numKeyframes != 0)
-        {
-            Keyframe* prevKeyframe = clip->tracks[jointIdx].keyframes;
-            Keyframe* nextKeyframe = clip->tracks[jointIdx].keyframes;
-            for (uint32_t k = 0; k < clip->tracks[jointIdx].numKeyframes; ++k) {
-                nextKeyframe = clip->tracks[jointIdx].keyframes + k;
-                if (nextKeyframe->timeStamp > time) {
-                    break;
-                }
-                prevKeyframe = clip->tracks[jointIdx].keyframes + k;
-            }
-            if (prevKeyframe != nextKeyframe) {
-                float alpha = (time - prevKeyframe->timeStamp) / (nextKeyframe->timeStamp - prevKeyframe->timeStamp);
-                *outTranslation = math::Lerp(prevKeyframe->position, nextKeyframe->position, alpha);
-                *outRotation = math::Slerp(prevKeyframe->rotation, nextKeyframe->rotation, alpha);
-            }
-            else {
-                *outTranslation = prevKeyframe->position;
-                *outRotation = prevKeyframe->rotation;
-            }
-            //translation = prevKeyframe->value;
-            //translation = math::Vec3();
-        } 
-    };
-    //
-    for (uint32_t jointIdx = 0; jointIdx < referenceSkeleton->numJoints; ++jointIdx)
-    {
-        ComputeLocalJointPose(jointIdx, clip, time, &target->transforms[jointIdx].translation, &target->transforms[jointIdx].rotation);
+    const float* searchedTimes[KEY_SEARCH_CACHE_SIZE] = {};
+    KeySpan searchedSpans[KEY_SEARCH_CACHE_SIZE];
+    uint32_t nextSearch = 0;
+    for (uint32_t jointIdx = 0; jointIdx < referenceSkeleton->numJoints; ++jointIdx) {
+        auto& track = clip->tracks[jointIdx];
+        if (track.numKeyframes == 0) {
+            continue;
+        }
+        uint32_t search = 0;
+        while (search < KEY_SEARCH_CACHE_SIZE && searchedTimes[search] != track.times) {
+            search++;
+        }
+        if (search == KEY_SEARCH_CACHE_SIZE) {
+            search = nextSearch;
+            nextSearch = (nextSearch + 1) % KEY_SEARCH_CACHE_SIZE;
+            searchedTimes[search] = track.times;
+            searchedSpans[search] = AdvanceKeySpan(track.times, track.numKeyframes, time, &target->keyCursors[jointIdx]);
+        }
+        auto& span = searchedSpans[search];
+        target->keyCursors[jointIdx] = span.prev;
+        auto& prev = track.keyframes[span.prev];
+        auto& next = track.keyframes[span.next];
+        auto& transform = target->transforms[jointIdx];
+        if (span.prev != span.next) {
+            transform.translation = math::Lerp(prev.position, next.position, span.alpha);
+            transform.rotation = math::Slerp(prev.rotation, next.rotation, span.alpha);
+        }
+        else {
+            transform.translation = prev.position;
+            transform.rotation = prev.rotation;
+        }
+    }
+}
+
+// decodes the two keys around time straight from the quantized tracks, nothing is decompressed up front
+void ComputeLocalPoses(AnimationLayer* target, Skeleton* referenceSkeleton, CompressedClip* clip, float time)
+{
+    float frame = time * clip->frameRate;
+    for (uint32_t jointIdx = 0; jointIdx < referenceSkeleton->numJoints; ++jointIdx) {
+        auto& track = clip->tracks[jointIdx];
+        if (track.numKeyframes != 0) {
+            SampleCompressedTrack(&track, frame, &target->transforms[jointIdx].translation, &target->transforms[jointIdx].rotation);
+        }
+    }
+}
+
+// samples the resident segment around time, a segment that fails its checksum holds the bind pose
+void ComputeLocalPoses(AnimationLayer* target, Skeleton* referenceSkeleton, StreamedClip* clip, float time)
+{
+    AnimationClip* segment = StreamClipSegment(clip, time);
+    if (segment != nullptr) {
+        ComputeLocalPoses(target, referenceSkeleton, segment, time);
+    }
+    else {
+        ComputeBindPose(target, referenceSkeleton);
     }
-    //
+}
+
+// blends the two frames around time for all joints at once
+void ComputeLocalPoses(AnimationLayer* target, Skeleton* referenceSkeleton, ResampledClip* clip, float time)
+{
+    SampleResampledClip(clip, time, target->transforms);
 }
 
 void ApplyLayerToSkeleton(Skeleton* skeleton, AnimationLayer* layer)
@@ -777,230 +860,552 @@ void GetSkinningTransforms(Skeleton* skeleton, SkeletonConstantData* outBuffer)
 }
 
 ///
-struct AppData
-{   
-    ShaderDesc shaderDesc;
+/**
+    Hot reload
+    A watch thread waits for files written to the asset directory and re-imports the mesh, skeleton and clips that
+    changed into a HotReloadBatch, which it publishes through an atomic pointer. AppUpdate takes the batch at the start
+    of a frame and swaps it in, neither side ever waits for the other.
+    A changed skeleton re-imports every clip, the clips have to be remapped to its joint order.
+    Importers read the mounted package before loose files, so hot reload is only started without one.
+*/
+#define HOT_RELOAD_DIRECTORY    "assets"
+#define MAX_HOT_RELOAD_CLIPS    128
+#define MAX_HOT_RELOAD_CHANGES  64
 
-    Skeleton    testSkeleton;
-    Mesh        testMesh;
-    Shader      shader;
+// of the sources the importers read, the bakes they write next to them are never reloaded
+static const char* hotReloadExtensions[] = { ".gtmesh", ".gtskel", ".gtanimclip" };
 
-    AnimationClip   testAnim[128];
-    AnimationStack  animStack;
+struct HotReloadBatch
+{
+    bool            hasMesh = false;
+    Mesh            mesh;
+    Skeleton*       skeleton = nullptr;
+    ClipStorage     clips[MAX_HOT_RELOAD_CLIPS];        // of the app's kind, no clip for the ones that didn't change
+};
 
-    ID3D11Buffer* frameConstantBuffer;
-    ID3D11Buffer* objectConstantBuffer;
-    ID3D11Buffer* skeletonConstantBuffer;
+struct HotReload
+{
+    FileWatch           watch;
+    Thread              thread;
+    std::atomic<bool>   quit { false };
+
+    ID3D11Device*       device = nullptr;   // free threaded, the watch thread creates reloaded meshes itself
+    const char*         meshPath = nullptr;
+    const char*         skeletonPath = nullptr;
+    const char* const*  clipPaths = nullptr;
+    uint32_t            numClips = 0;
+    ClipStorageKind     clipStorage = CLIP_STORAGE_WHOLE;   // how the app holds its clips, reloaded ones are held the same way
+    Skeleton*           skeleton = nullptr;     // the watch thread's copy of the skeleton clips are imported against
+
+    std::atomic<HotReloadBatch*> pending { nullptr };
+};
 
-    FrameConstantData frameData;
-    ObjectConstantData objectData;
-    SkeletonConstantData skeletonData;
+static void ReleaseHotReloadBatch(HotReloadBatch* batch)
+{
+    if (batch->hasMesh) {
+        ReleaseMesh(&batch->mesh);
+    }
+    delete batch->skeleton;
+    for (uint32_t i = 0; i < MAX_HOT_RELOAD_CLIPS; ++i) {
+        if (batch->clips[i].object != nullptr) {
+            ReleaseUnusedClipStorage(&batch->clips[i]);
+        }
+    }
+    delete batch;
+}
 
+// re-imports whatever the changes touched into batch, replacing older results for the same asset, or every asset if
+// the watch overflowed; returns false if none of the changes was to an asset in use
+static bool ReloadChangedAssets(HotReload* reload, FileChange* changes, uint32_t numChanges, bool overflow, HotReloadBatch* batch)
+{
+    bool meshChanged = overflow;
+    bool skeletonChanged = overflow;
+    bool clipChanged[MAX_HOT_RELOAD_CLIPS] = {};
+    for (uint32_t i = 0; i < reload->numClips; ++i) { clipChanged[i] = overflow; }
+    for (uint32_t c = 0; c < numChanges; ++c) {
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%s", HOT_RELOAD_DIRECTORY, changes[c].name);
+        meshChanged |= strcmp(path, reload->meshPath) == 0;
+        skeletonChanged |= strcmp(path, reload->skeletonPath) == 0;
+        for (uint32_t i = 0; i < reload->numClips; ++i) {
+            clipChanged[i] |= strcmp(path, reload->clipPaths[i]) == 0;
+        }
+    }
 
-} g_data;
+    bool anyChanged = meshChanged || skeletonChanged;
+    for (uint32_t i = 0; i < reload->numClips; ++i) { anyChanged |= clipChanged[i]; }
+    if (!anyChanged) {
+        return false;
+    }
+
+    if (meshChanged) {
+        MeshDesc meshDesc;
+        Mesh mesh;
+        if (ImportGTMesh(reload->meshPath, &meshDesc) && CreateMesh(reload->device, &meshDesc, &mesh)) {
+            if (batch->hasMesh) {
+                ReleaseMesh(&batch->mesh);
+            }
+            batch->mesh = mesh;
+            batch->hasMesh = true;
+            printf("Reloaded %s\n", reload->meshPath);
+        }
+        ReleaseMeshDesc(&meshDesc);
+    }
+    if (skeletonChanged) {
+        Skeleton* skeleton = new Skeleton();
+        if (ImportGTSkeleton(reload->skeletonPath, skeleton)) {
+            memcpy(reload->skeleton, skeleton, sizeof(Skeleton));
+            delete batch->skeleton;
+            batch->skeleton = skeleton;
+            for (uint32_t i = 0; i < reload->numClips; ++i) { clipChanged[i] = true; }
+            printf("Reloaded %s\n", reload->skeletonPath);
+        }
+        else {
+            delete skeleton;
+        }
+    }
+    for (uint32_t i = 0; i < reload->numClips; ++i) {
+        if (!clipChanged[i]) {
+            continue;
+        }
+        ClipStorage clip = NewClipStorage(reload->clipStorage);
+        if (LoadClipStorage(clip, reload->clipPaths[i], reload->skeleton, nullptr)) {
+            if (batch->clips[i].object != nullptr) {
+                ReleaseUnusedClipStorage(&batch->clips[i]);
+            }
+            batch->clips[i] = clip;
+            printf("Reloaded %s\n", reload->clipPaths[i]);
+        }
+        else {
+            DeleteClipStorage(&clip);
+        }
+    }
+    return true;
+}
 
+static void HotReloadThread(void* userData)
+{
+    auto reload = static_cast<HotReload*>(userData);
+    FileChange changes[MAX_HOT_RELOAD_CHANGES];
+    HotReloadBatch* batch = nullptr;
+    bool batchReady = false;
+    while (!reload->quit.load(std::memory_order_relaxed)) {
+        bool overflow = false;
+        uint32_t numChanges = WaitForFileChanges(&reload->watch, 100, changes, MAX_HOT_RELOAD_CHANGES, &overflow);
+        // exporters and editors tend to write a file in several steps, wait for the directory to settle
+        // once changes overflow everything is reloaded anyway
+        while (numChanges != 0 && !overflow) {
+            uint32_t numMore = WaitForFileChanges(&reload->watch, 50, changes + numChanges, MAX_HOT_RELOAD_CHANGES - numChanges, &overflow);
+            if (numMore == 0) { break; }
+            numChanges += numMore;
+        }
+        if (numChanges != 0 || overflow) {
+            if (batch == nullptr) { batch = new HotReloadBatch(); }
+            batchReady |= ReloadChangedAssets(reload, changes, numChanges, overflow, batch);
+        }
+        // a batch the app hasn't taken yet blocks publishing, keep collecting into ours and try again next round
+        HotReloadBatch* expected = nullptr;
+        if (batchReady && reload->pending.compare_exchange_strong(expected, batch, std::memory_order_release)) {
+            batch = nullptr;
+            batchReady = false;
+        }
+    }
+    if (batch != nullptr) {
+        ReleaseHotReloadBatch(batch);
+    }
+}
 
-bool ImportGTMesh(const char* path, Mesh* outMesh, ID3D11Device* device)
+bool StartHotReload(HotReload* reload, ID3D11Device* device, const char* meshPath, const char* skeletonPath, Skeleton* skeleton,
+    const char* const* clipPaths, uint32_t numClips, ClipStorageKind clipStorage)
+{
+    assert(numClips <= MAX_HOT_RELOAD_CLIPS);
+    if (!StartFileWatch(HOT_RELOAD_DIRECTORY, hotReloadExtensions, ARRAYSIZE(hotReloadExtensions), &reload->watch)) {
+        return false;
+    }
+    reload->device = device;
+    reload->meshPath = meshPath;
+    reload->skeletonPath = skeletonPath;
+    reload->clipPaths = clipPaths;
+    reload->numClips = numClips;
+    reload->clipStorage = clipStorage;
+    reload->skeleton = new Skeleton();
+    memcpy(reload->skeleton, skeleton, sizeof(Skeleton));
+    reload->quit.store(false, std::memory_order_relaxed);
+    if (!StartThread(&reload->thread, HotReloadThread, reload)) {
+        StopFileWatch(&reload->watch);
+        delete reload->skeleton;
+        reload->skeleton = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void StopHotReload(HotReload* reload)
 {
-    uint32_t fileSize;
-    ByteStream stream;
-    stream.buffer = (char*)Win32LoadFileContents(path, &fileSize);
-    stream.bufferSize = (size_t)(fileSize);
-    stream.offset = 0;
+    if (reload->skeleton == nullptr) {
+        return;
+    }
+    reload->quit.store(true, std::memory_order_relaxed);
+    JoinThread(&reload->thread);
+    StopFileWatch(&reload->watch);
+    if (auto batch = reload->pending.exchange(nullptr, std::memory_order_acquire)) {
+        ReleaseHotReloadBatch(batch);
+    }
+    delete reload->skeleton;
+    reload->skeleton = nullptr;
+}
 
-    auto magicNumber = stream.Read<uint32_t>();
-    assert(magicNumber == 0xdeadbeef);
+// returns the latest batch of reloaded assets, or nullptr, the caller owns it from here on
+HotReloadBatch* TakeHotReloadBatch(HotReload* reload)
+{
+    return reload->pending.exchange(nullptr, std::memory_order_acquire);
+}
 
-    auto version = stream.Read<uint32_t>();
-    assert(version == 1);
+///
+/**
+    Clip cache
+    Owns the clips of a library that doesn't have to be in memory all at once. Clips are registered by path up front
+    and only loaded once they are acquired, the handle AcquireCachedClip returns stays valid until the matching release.
+    Once a frame AdvanceClipCache evicts the least recently released clips until the resident ones fit the budget again.
+    Held clips are never evicted, a cache whose clips are all in use runs over budget instead.
+    Clips that failed to load are dropped once nobody holds them and loaded again by the next acquire, so a source that
+    was fixed meanwhile is picked up.
+    Paged clips only charge their track index here, their keyframes are budgeted by the pager.
+    Compressed and resampled clips are charged like whole ones, for their own size, streamed clips for their segment
+    window.
+    Whole clips can share their tracks with the library's other clips through the cache's track pool (see
+    trackpool.h). They are still charged for every keyframe they reference, so the budget holds however clips are
+    evicted, and what sharing saves shows in the pool instead.
+*/
+#define MAX_CACHED_CLIPS 128
 
-    MeshDesc meshDesc;
-    meshDesc.numVertices = stream.Read<uint32_t>();
-    meshDesc.vertices = new Vertex[meshDesc.numVertices];
-    for (uint32_t i = 0; i < meshDesc.numVertices; ++i) {
-        auto& vert = meshDesc.vertices[i];
-
-        vert.position = stream.Read<math::Vec3>();
-        vert.normal = stream.Read<math::Vec3>();
-        stream.ReadBytes(vert.uv, sizeof(float) * 2);
-        stream.ReadBytes(nullptr, sizeof(float) * 2);   // @NOTE ignore second UV set
-        vert.tangent = stream.Read<math::Vec4>();
-        stream.ReadBytes(vert.blendWeights, sizeof(float) * 4);
-        stream.ReadBytes(vert.blendIndices, sizeof(uint32_t) * 4);
-    }
-
-    auto indexSize = stream.Read<uint32_t>();
-    auto numSubmeshes = stream.Read<uint32_t>();
-    uint32_t totalNumIndices = 0;
-
-    MeshDesc* submeshDesc = new MeshDesc[numSubmeshes];
-    for (uint32_t i = 0; i < numSubmeshes; ++i) {
-        auto& desc = submeshDesc[i];
-        desc.numIndices = stream.Read<uint32_t>();
-        desc.indices = new IndexType[desc.numIndices];
-        for (uint32_t idx = 0; idx < desc.numIndices; ++idx) {
-            if (indexSize == 2) {
-                desc.indices[idx] = (IndexType)stream.Read<uint16_t>();
-            }
-            else {
-                desc.indices[idx] = (IndexType)stream.Read<uint32_t>();
-            }
+struct CachedClip
+{
+    const char*     path = nullptr;
+    ClipHandle      handle;             // holds no clip unless it's resident
+    FileMapping     bakedFile;
+    uint32_t        refCount = 0;
+    uint64_t        lastUsed = 0;       // frame the clip was last acquired or released in
+    size_t          bytes = 0;          // charged once the load has completed
+};
+
+struct ClipCache
+{
+    size_t      budget = 0;
+    size_t      residentBytes = 0;
+    size_t      loadedBytes = 0;        // running totals
+    size_t      evictedBytes = 0;
+    uint32_t    numEvictions = 0;
+    uint64_t    frame = 1;
+
+    JobPool*        pool = nullptr;
+    Skeleton*       targetSkeleton = nullptr;
+    ClipStorageKind storage = CLIP_STORAGE_WHOLE;   // how clips are loaded
+    ClipPager*      pager = nullptr;        // pages the keyframes of paged clips
+    bool            shareTracks = false;    // whole or compressed clips share identical tracks through tracks
+    TrackPool       tracks;
+
+    CachedClip  entries[MAX_CACHED_CLIPS];
+    uint32_t    numEntries = 0;
+};
+
+// paged clips need a pager, only whole and compressed clips can share their tracks
+void InitClipCache(ClipCache* cache, JobPool* pool, Skeleton* targetSkeleton, ClipStorageKind storage, ClipPager* pager, size_t budget, bool shareTracks)
+{
+    assert((storage == CLIP_STORAGE_PAGED) == (pager != nullptr));
+    assert(!shareTracks || CanShareClipTracks(storage));
+    cache->pool = pool;
+    cache->targetSkeleton = targetSkeleton;
+    cache->storage = storage;
+    cache->pager = pager;
+    cache->budget = budget;
+    cache->shareTracks = shareTracks;
+    InitTrackPool(&cache->tracks);
+}
+
+// returns the id the clip is acquired with, path has to stay valid as long as the cache
+uint32_t AddCachedClip(ClipCache* cache, const char* path)
+{
+    assert(cache->numEntries < MAX_CACHED_CLIPS);
+    cache->entries[cache->numEntries].path = path;
+    return cache->numEntries++;
+}
+
+static bool IsCachedClipResident(CachedClip* entry)
+{
+    return entry->handle.storage.object != nullptr;
+}
+
+// baked clips are charged for their whole mapping, imported ones for the arena holding their keyframes and name,
+// shared ones for their name and the keyframes they reference
+static size_t GetCachedClipSize(CachedClip* entry)
+{
+    auto storage = entry->handle.storage;
+    bool ready = IsClipReady(&entry->handle);
+    size_t baked = entry->bakedFile.data != nullptr ? entry->bakedFile.size : 0;
+    switch (storage.kind) {
+    case CLIP_STORAGE_WHOLE:
+        if (baked == 0 && ready) {
+            auto clip = GetWholeClip(storage);
+            return sizeof(AnimationClip) + clip->arena.size + (entry->handle.tracks != nullptr ? GetClipTrackBytes(clip) : 0);
+        }
+        return sizeof(AnimationClip) + baked;
+    case CLIP_STORAGE_PAGED:
+        return sizeof(PagedClip);
+    case CLIP_STORAGE_COMPRESSED:
+        if (baked == 0 && ready) {
+            auto clip = GetCompressedClip(storage);
+            return sizeof(CompressedClip) + clip->arena.size + (entry->handle.tracks != nullptr ? GetCompressedClipTrackBytes(clip) : 0);
+        }
+        return sizeof(CompressedClip) + baked;
+    case CLIP_STORAGE_STREAMED:
+        return ready ? GetStreamedClipSize(GetStreamedClip(storage)) : sizeof(StreamedClip);
+    case CLIP_STORAGE_RESAMPLED:
+        return sizeof(ResampledClip) + (baked == 0 && ready ? GetResampledClip(storage)->arena.size : baked);
+    }
+    return 0;
+}
+
+// the clip's load must have completed
+static void UnloadCachedClip(ClipCache* cache, CachedClip* entry)
+{
+    bool ready = IsClipReady(&entry->handle);
+    bool baked = entry->bakedFile.data != nullptr;
+    auto& storage = entry->handle.storage;
+    if (ready && entry->handle.tracks != nullptr) {
+        ReleaseClipStorageTracks(entry->handle.tracks, storage);
+    }
+    switch (storage.kind) {
+    case CLIP_STORAGE_WHOLE:
+        if (!baked && ready) {
+            ReleaseAnimationClip(GetWholeClip(storage));
+        }
+        break;
+    case CLIP_STORAGE_PAGED:
+        if (ready) {
+            ClosePagedClip(cache->pager, GetPagedClip(storage));
+        }
+        break;
+    case CLIP_STORAGE_COMPRESSED:
+        if (!baked && ready) {
+            ReleaseCompressedClip(GetCompressedClip(storage));
+        }
+        break;
+    case CLIP_STORAGE_STREAMED:
+        if (ready) {
+            CloseStreamedClip(GetStreamedClip(storage));
         }
-        totalNumIndices += desc.numIndices;
+        break;
+    case CLIP_STORAGE_RESAMPLED:
+        if (!baked && ready) {
+            ReleaseResampledClip(GetResampledClip(storage));
+        }
+        break;
     }
-    meshDesc.numIndices = totalNumIndices;
-    meshDesc.indices = new IndexType[totalNumIndices];
-    IndexType* writePtr = meshDesc.indices;
-    for (uint32_t i = 0; i < numSubmeshes; ++i) {
-        memcpy(writePtr, submeshDesc[i].indices, submeshDesc[i].numIndices * sizeof(IndexType));
-        delete[] submeshDesc[i].indices;
-        writePtr += submeshDesc[i].numIndices;
+    if (baked) {
+        UnmapFile(&entry->bakedFile);
     }
-    delete[] submeshDesc;
+    DeleteClipStorage(&storage);
+    cache->residentBytes -= entry->bytes;
+    entry->bytes = 0;
+}
 
-    auto success = CreateMesh(device, &meshDesc, outMesh);
-    delete[] meshDesc.vertices;
-    delete[] meshDesc.indices;
-    return success;
+// the handle plays the bind pose until the load is published
+static void LoadCachedClip(ClipCache* cache, CachedClip* entry)
+{
+    LoadClipAsync(cache->pool, &entry->handle, entry->path, cache->targetSkeleton, NewClipStorage(cache->storage), &entry->bakedFile, cache->pager,
+        cache->shareTracks ? &cache->tracks : nullptr);
 }
 
+static bool HasCachedClipFailed(CachedClip* entry)
+{
+    return IsCachedClipResident(entry) && entry->handle.state.load(std::memory_order_acquire) == CLIP_LOAD_FAILED;
+}
 
-bool ImportSGM(const char* path, Mesh* outMesh, ID3D11Device* device)
+// starts loading the clip if it isn't resident, or again if its last load failed
+ClipHandle* AcquireCachedClip(ClipCache* cache, uint32_t id)
 {
-    uint32_t fileSize;
-    ByteStream stream;
-    stream.buffer = (char*)Win32LoadFileContents(path, &fileSize);
-    stream.bufferSize = (size_t)(fileSize);
-    stream.offset = 0;
+    assert(id < cache->numEntries);
+    auto entry = &cache->entries[id];
+    if (HasCachedClipFailed(entry)) {
+        UnloadCachedClip(cache, entry);
+    }
+    if (!IsCachedClipResident(entry)) {
+        LoadCachedClip(cache, entry);
+    }
+    entry->refCount++;
+    entry->lastUsed = cache->frame;
+    return &entry->handle;
+}
 
-    uint32_t numVerticesTotal = 0;
-    uint32_t numIndicesTotal = 0;
+void ReleaseCachedClip(ClipCache* cache, uint32_t id)
+{
+    assert(id < cache->numEntries && cache->entries[id].refCount > 0);
+    auto entry = &cache->entries[id];
+    entry->refCount--;
+    entry->lastUsed = cache->frame;
+    if (entry->refCount == 0 && HasCachedClipFailed(entry)) {
+        UnloadCachedClip(cache, entry);
+    }
+}
 
-    // skip magic number, version number and material information
-    auto magicNumber = stream.Read<uint32_t>();    // magic 
-    assert(magicNumber == 352658064);
-   
-    auto version = stream.Read<uint8_t>();     // version
-    assert(version == 3);
-
-    auto numMaterials = stream.Read<uint8_t>();     // num materials
-    for (uint8_t i = 0; i < numMaterials; ++i) {
-        stream.Read<uint8_t>();     // material ID
-        auto numUVSets = stream.Read<uint8_t>();   
-        for (uint8_t k = 0; k < numUVSets; ++k) {
-            auto numTextures = stream.Read<uint8_t>();
-            for (uint8_t j = 0; j < numTextures; ++j) {
-                stream.Read<uint8_t>();     // texture type hint
-                auto l = stream.Read<uint16_t>();    // filename length
-                char buf[512] = "";
-                stream.ReadBytes(buf, l);    // filename
-                assert(l < 512);
-            }
+// charges clips whose load completed since the last frame, then evicts unused clips until the budget is met
+void AdvanceClipCache(ClipCache* cache)
+{
+    cache->frame++;
+    for (uint32_t i = 0; i < cache->numEntries; ++i) {
+        auto entry = &cache->entries[i];
+        if (IsCachedClipResident(entry) && entry->bytes == 0 && entry->handle.state.load(std::memory_order_acquire) != CLIP_LOAD_PENDING) {
+            entry->bytes = GetCachedClipSize(entry);
+            cache->residentBytes += entry->bytes;
+            cache->loadedBytes += entry->bytes;
         }
-        auto numColors = stream.Read<uint8_t>();
-        for (uint8_t j = 0; j < numColors; ++j) {
-            stream.Read<uint8_t>();     // color type hint
-            math::Vec4 col;
-            stream.ReadBytes(&col.elements[0], sizeof(float) * 4);   // color
-        }
-    }
-    // start reading mesh data
-    auto numSubmeshes = stream.Read<uint8_t>();
-    MeshDesc* submeshDesc = new MeshDesc[numSubmeshes];
-    for (uint8_t i = 0; i < numSubmeshes; ++i) {
-        auto& meshResource = submeshDesc[i];
-        stream.Read<uint8_t>();     // submesh ID
-        stream.Read<uint8_t>();     // material ID
-        meshResource.numVertices = stream.Read<uint32_t>();
-        numVerticesTotal += meshResource.numVertices;
-        
-        size_t totalVertexSize = sizeof(math::Vec3) * 2;
-
-        auto numUVSets = stream.Read<uint8_t>();
-        totalVertexSize += sizeof(float) * 2 * numUVSets;
-        assert(numUVSets == 1);
-        auto numColorChannels = stream.Read<uint8_t>();
-        totalVertexSize += sizeof(math::Vec4) * numColorChannels;
-        assert(numColorChannels == 0);
-
-        auto hasTangents = stream.Read<uint8_t>();
-        totalVertexSize += hasTangents ? sizeof(math::Vec4) : 0;
-        assert(hasTangents == 1);
-
-        auto hasBones = stream.Read<uint8_t>();
-        totalVertexSize += hasBones ? sizeof(float) * 4 * 2 : 0;
-        assert(hasBones == 1);
-
-        assert(sizeof(Vertex) == totalVertexSize);
-
-        meshResource.vertices = new Vertex[meshResource.numVertices];
-        for (uint32_t vtx = 0; vtx < meshResource.numVertices; ++vtx) {     // explicit loop because we convert bone weights
-            auto& vert = meshResource.vertices[vtx];
-
-            vert.position = stream.Read<math::Vec3>();
-            vert.normal = stream.Read<math::Vec3>();
-            stream.ReadBytes(vert.uv, sizeof(float) * 2);
-            vert.tangent = stream.Read<math::Vec4>();   
-            stream.ReadBytes(vert.blendWeights, sizeof(float) * 4);
-            for (auto w = 0; w < 4; ++w) {
-                float indexAsFloat = stream.Read<float>();
-                vert.blendIndices[w] = (uint32_t)(indexAsFloat);
+    }
+    while (cache->residentBytes > cache->budget) {
+        CachedClip* victim = nullptr;
+        for (uint32_t i = 0; i < cache->numEntries; ++i) {
+            auto entry = &cache->entries[i];
+            if (entry->bytes != 0 && entry->refCount == 0 && (victim == nullptr || entry->lastUsed < victim->lastUsed)) {
+                victim = entry;
             }
         }
-        
-        meshResource.numIndices = stream.Read<uint32_t>();
-        numIndicesTotal += meshResource.numIndices;
-        meshResource.indices = new IndexType[meshResource.numIndices];
-        auto indexSize = stream.Read<uint8_t>();
-        if (indexSize == 4) {
-            stream.ReadBytes(meshResource.indices, sizeof(IndexType) * meshResource.numIndices);
-        }
-        else {
-            for (uint32_t idx = 0; idx < meshResource.numIndices; ++idx) {
-                auto smallIndex = stream.Read<uint16_t>();
-                meshResource.indices[idx] = (uint32_t)(smallIndex);
-            }
+        if (victim == nullptr) {
+            return;
         }
+        cache->evictedBytes += victim->bytes;
+        cache->numEvictions++;
+        UnloadCachedClip(cache, victim);
     }
-    // Merge submeshes
-    MeshDesc meshDesc;
-    meshDesc.numVertices = numVerticesTotal;
-    meshDesc.numIndices = numIndicesTotal;
-
-    meshDesc.vertices = new Vertex[numVerticesTotal];
-    meshDesc.indices = new IndexType[numIndicesTotal];
+}
 
-    Vertex* writeVertexPtr = meshDesc.vertices;
-    IndexType* writeIndexPtr = meshDesc.indices;
-    IndexType indexOffset = 0;
+// swaps a reloaded clip of the cache's kind in for a resident one, clips that aren't resident pick the change up when
+// they are loaded again; the cache takes the clip over either way
+void ReplaceCachedClip(ClipCache* cache, uint32_t id, ClipStorage clip)
+{
+    assert(clip.kind == cache->storage && clip.object != nullptr);
+    auto entry = &cache->entries[id];
+    if (!IsCachedClipResident(entry)) {
+        ReleaseUnusedClipStorage(&clip);
+        return;
+    }
+    WaitForClip(cache->pool, &entry->handle);   // only waits if the load is still in flight
+    UnloadCachedClip(cache, entry);
+    if (clip.kind == CLIP_STORAGE_STREAMED) {
+        GetStreamedClip(clip)->pool = cache->pool;
+    }
+    if (cache->shareTracks) {
+        MoveClipStorageToTrackPool(&cache->tracks, clip, nullptr);
+    }
+    entry->handle.storage = clip;
+    entry->handle.pager = cache->pager;
+    entry->handle.tracks = cache->shareTracks ? &cache->tracks : nullptr;
+    entry->handle.state.store(CLIP_LOAD_READY, std::memory_order_release);
+    entry->bytes = GetCachedClipSize(entry);
+    cache->residentBytes += entry->bytes;
+    cache->loadedBytes += entry->bytes;
+}
 
-    for (auto i = 0u; i < numSubmeshes; ++i) {
-        auto& submesh = submeshDesc[i];
-        memcpy(writeVertexPtr, submesh.vertices, sizeof(Vertex) * submesh.numVertices);
-        writeVertexPtr += submesh.numVertices;
-        memcpy(writeIndexPtr, submesh.indices, sizeof(IndexType) * submesh.numIndices);
-        for (auto j = 0u; j < submesh.numIndices; ++j) {
-            writeIndexPtr[j] += indexOffset;
+// unloads every resident clip keep doesn't mark, they were loaded for a target skeleton that is about to change;
+// the job pool must have completed every load, held clips are loaded again by ReloadHeldCachedClips
+void DropCachedClips(ClipCache* cache, const bool* keep)
+{
+    for (uint32_t i = 0; i < cache->numEntries; ++i) {
+        if (!keep[i] && IsCachedClipResident(&cache->entries[i])) {
+            UnloadCachedClip(cache, &cache->entries[i]);
         }
-        writeIndexPtr += submesh.numIndices;
-        indexOffset += submesh.numVertices;
     }
+}
 
-    //
-    for (auto i = 0u; i < meshDesc.numVertices; ++i) {
+// loads the held clips DropCachedClips unloaded again, once the new target skeleton is in place
+void ReloadHeldCachedClips(ClipCache* cache)
+{
+    for (uint32_t i = 0; i < cache->numEntries; ++i) {
+        auto entry = &cache->entries[i];
+        if (entry->refCount > 0 && !IsCachedClipResident(entry)) {
+            LoadCachedClip(cache, entry);
+        }
+    }
+}
 
-        auto weightSum = 0.f;
-        for (auto j = 0; j < 4; ++j) {
-            weightSum += meshDesc.vertices[i].blendWeights[j];
+// the job pool must have completed every load
+void ShutdownClipCache(ClipCache* cache)
+{
+    for (uint32_t i = 0; i < cache->numEntries; ++i) {
+        if (IsCachedClipResident(&cache->entries[i])) {
+            UnloadCachedClip(cache, &cache->entries[i]);
         }
-        assert(math::Abs(1.0f - weightSum) <= 0.00001f);
     }
+    ShutdownTrackPool(&cache->tracks);
+}
 
-    auto res = CreateMesh(device, &meshDesc, outMesh);
-    delete[] submeshDesc;
-    return res;
+///
+#define NUM_CLIP_SLOTS 4
 
-    return true;
+struct AppData
+{   
+    ShaderDesc  shaderDesc;
+    FileMapping vertexShaderFile;
+    FileMapping pixelShaderFile;
+
+    JobPool     jobPool;
+    ClipCache   clipCache;              // ids are the indices into animFiles
+    ClipPager   clipPager;
+    HotReload   hotReload;
+
+    uint32_t    slotClips[NUM_CLIP_SLOTS];      // clips played by the idle, crouch, walk and run layers
+    ClipHandle* slotHandles[NUM_CLIP_SLOTS];
+
+    Skeleton    testSkeleton;
+    Mesh        testMesh;
+    Shader      shader;
+
+    AnimationStack  animStack;
+
+    ID3D11Buffer* frameConstantBuffer;
+    ID3D11Buffer* objectConstantBuffer;
+    ID3D11Buffer* skeletonConstantBuffer;
+
+    FrameConstantData frameData;
+    ObjectConstantData objectData;
+    SkeletonConstantData skeletonData;
+
+
+} g_data;
+
+///
+// creates the mesh straight from the vertex and index data baked by ImportGTMesh
+bool LoadBakedMesh(const char* sourcePath, Mesh* outMesh, ID3D11Device* device)
+{
+    FileMapping baked;
+    MeshDesc meshDesc;
+    if (!LoadBakedMesh(sourcePath, &baked, &meshDesc)) {
+        return false;
+    }
+    auto success = CreateMesh(device, &meshDesc, outMesh);
+    UnmapFile(&baked);
+    return success;
+}
+
+bool ImportGTMesh(const char* path, Mesh* outMesh, ID3D11Device* device)
+{
+    MeshDesc meshDesc;
+    if (!ImportGTMesh(path, &meshDesc)) {
+        return false;
+    }
+    auto success = CreateMesh(device, &meshDesc, outMesh);
+    ReleaseMeshDesc(&meshDesc);
+    return success;
+}
+
+bool ImportSGM(const char* path, Mesh* outMesh, ID3D11Device* device)
+{
+    MeshDesc meshDesc;
+    if (!ImportSGM(path, &meshDesc)) {
+        return false;
+    }
+    auto success = CreateMesh(device, &meshDesc, outMesh);
+    ReleaseMeshDesc(&meshDesc);
+    return success;
 }
 
 
@@ -1014,6 +1419,51 @@ const char* animFiles[] = { "assets/knight_idle.gtanimclip", "assets/knight_crou
                             //"assets/knight_dance.gtanimclip" };
 //const char* animFiles[] = { "assets/akai_idle.gtanimclip", "assets/akai_walking.gtanimclip" };
 const int numAnims = ARRAYSIZE(animFiles);
+#define ASSET_PACKAGE_PATH "assets/assets.gtpak"    // built by gtcook -p
+#define CLIP_PAGING_BUDGET (4 * 1024 * 1024)   // bytes of resident keyframes, 0 loads clips whole
+#define CLIP_COMPRESSION 1                      // loads clips quantized (see clipcompression.h) instead of paging them
+#define CLIP_STREAMING 0                        // streams clips in segments (see clipsegments.h) instead of either
+#define CLIP_RESAMPLING 0                       // samples clips resampled to fixed frames (see clipresampling.h) unless streaming
+#define CLIP_STORAGE_USED (CLIP_STREAMING ? CLIP_STORAGE_STREAMED : CLIP_RESAMPLING ? CLIP_STORAGE_RESAMPLED : CLIP_COMPRESSION ? CLIP_STORAGE_COMPRESSED : \
+    CLIP_PAGING_BUDGET > 0 ? CLIP_STORAGE_PAGED : CLIP_STORAGE_WHOLE)
+#define CLIP_TRACK_SHARING 1                    // clips loaded whole or compressed share identical tracks (see trackpool.h)
+#define CLIP_TRACK_SHARING_USED (CLIP_TRACK_SHARING && (CLIP_STORAGE_USED == CLIP_STORAGE_WHOLE || CLIP_STORAGE_USED == CLIP_STORAGE_COMPRESSED))
+#define CLIP_CACHE_BUDGET (2 * 1024 * 1024)    // bytes of resident clips, clips nobody plays are evicted beyond it
+const char* meshFile = "assets/knight.gtmesh";
+const char* skeletonFile = "assets/knight.gtskel";
+
+// swaps in whatever the hot reload thread finished since the last frame
+static void ApplyHotReload()
+{
+    auto batch = TakeHotReloadBatch(&g_data.hotReload);
+    if (batch == nullptr) {
+        return;
+    }
+    if (batch->hasMesh) {
+        ReleaseMesh(&g_data.testMesh);
+        g_data.testMesh = batch->mesh;
+    }
+    // loads and prefetches read the skeleton the cache targets, none may be in flight while it changes
+    if (batch->skeleton != nullptr) {
+        WaitForJobs(&g_data.jobPool);
+    }
+    bool replaced[numAnims] = {};
+    for (uint32_t i = 0; i < (uint32_t)numAnims; ++i) {
+        if (batch->clips[i].object != nullptr) {
+            ReplaceCachedClip(&g_data.clipCache, i, batch->clips[i]);
+            replaced[i] = true;
+        }
+    }
+    // clips the batch didn't bring, because their reimport failed, still match the old skeleton's layout
+    if (batch->skeleton != nullptr) {
+        DropCachedClips(&g_data.clipCache, replaced);
+        memcpy(&g_data.testSkeleton, batch->skeleton, sizeof(Skeleton));
+        ResetLocalTransforms(&g_data.testSkeleton);
+        ReloadHeldCachedClips(&g_data.clipCache);
+    }
+    delete batch->skeleton;
+    delete batch;   // everything else it held belongs to g_data now
+}
 ///
 void AppInit(HWND hWnd, ID3D11Device* device, ID3D11DeviceContext* deviceContext)
 {
@@ -1025,8 +1475,23 @@ void AppInit(HWND hWnd, ID3D11Device* device, ID3D11DeviceContext* deviceContext
     static const char* pShaderPath = "bin/Release/DefaultShading.cso";
 #endif
 
-    g_data.shaderDesc.vertexShaderCode = (char*)Win32LoadFileContents(vShaderPath, &g_data.shaderDesc.vertexShaderCodeSize);
-    g_data.shaderDesc.pixelShaderCode = (char*)Win32LoadFileContents(pShaderPath, &g_data.shaderDesc.pixelShaderCodeSize);
+    SetChecksumMode(CHECKSUM_VERIFY_TIMED);   // cheap enough to keep timing, the Skeleton window shows the cost
+    {   // assets are read from the package when one was built, loose files are the fallback
+        FileInfo info;
+        if (QueryFileInfo(ASSET_PACKAGE_PATH, &info) && OpenPackage(ASSET_PACKAGE_PATH, &g_package)) {
+            printf("Mounted %s (%u files)\n", ASSET_PACKAGE_PATH, g_package.header->numEntries);
+        }
+    }
+
+    // shader bytecode stays mapped, the input layout is created from it lazily
+    if (!MapFile(vShaderPath, &g_data.vertexShaderFile) || !MapFile(pShaderPath, &g_data.pixelShaderFile)) {
+        printf("Failed to load shader bytecode\n");
+        return;
+    }
+    g_data.shaderDesc.vertexShaderCode = g_data.vertexShaderFile.data;
+    g_data.shaderDesc.vertexShaderCodeSize = (uint32_t)g_data.vertexShaderFile.size;
+    g_data.shaderDesc.pixelShaderCode = g_data.pixelShaderFile.data;
+    g_data.shaderDesc.pixelShaderCodeSize = (uint32_t)g_data.pixelShaderFile.size;
     if (!CreateShader(device, &g_data.shaderDesc, &g_data.shader)) {
         printf("Failed to create shader\n");
         return;
@@ -1061,30 +1526,34 @@ void AppInit(HWND hWnd, ID3D11Device* device, ID3D11DeviceContext* deviceContext
        printf("failed to load test mesh from %s\n", "assets/character.gtmesh");
         return;
     }*/
-    if(!ImportGTMesh("assets/knight.gtmesh", &g_data.testMesh, device)) {
+    if(!LoadBakedMesh(meshFile, &g_data.testMesh, device) && !ImportGTMesh(meshFile, &g_data.testMesh, device)) {
         printf("failed to load test mesh from %s\n", "assets/character.gtmesh");
         return;
     }
     printf("Created test mesh\n");
 
-    if (!ImportGTSkeleton("assets/knight.gtskel", &g_data.testSkeleton)) {
+    if (!LoadBakedSkeleton(skeletonFile, &g_data.testSkeleton) && !ImportGTSkeleton(skeletonFile, &g_data.testSkeleton)) {
         printf("failed to load test skeleton from %s\n", "assets/character.sga");
         return;
     }
     ResetLocalTransforms(&g_data.testSkeleton);
     printf("Created test skeleton\n");
 
-    uint32_t numAnimations = 0;
-    uint32_t currentImportAnimation = 0;
-    
+    // clips stream in on the job pool, layers hold the bind pose until their clip is published
+    InitJobPool(&g_data.jobPool);
+    g_data.clipPager.budget = CLIP_PAGING_BUDGET;
+    InitClipCache(&g_data.clipCache, &g_data.jobPool, &g_data.testSkeleton, CLIP_STORAGE_USED, CLIP_STORAGE_USED == CLIP_STORAGE_PAGED ? &g_data.clipPager : nullptr,
+        CLIP_CACHE_BUDGET, CLIP_TRACK_SHARING_USED);
     for (uint32_t i = 0; i < numAnims; ++i) {
-        if (!ImportGTAnimation(animFiles[i], &g_data.testSkeleton, &g_data.testAnim[currentImportAnimation])) {
-            printf("failed to load animation from %s\n", animFiles[i]);
-            return;
+        AddCachedClip(&g_data.clipCache, animFiles[i]);
+    }
+    for (uint32_t i = 0; i < NUM_CLIP_SLOTS; ++i) {     // idle, crouch idle, walk, run
+        g_data.slotClips[i] = i;
+        g_data.slotHandles[i] = AcquireCachedClip(&g_data.clipCache, i);
+    }
 
-        }
-        printf("loaded anim: %s\n", g_data.testAnim[currentImportAnimation].name);
-        currentImportAnimation++;
+    if (g_package.header == nullptr && !StartHotReload(&g_data.hotReload, device, meshFile, skeletonFile, &g_data.testSkeleton, animFiles, numAnims, CLIP_STORAGE_USED)) {
+        printf("Hot reload is unavailable\n");
     }
 
     // initialize animation stack
@@ -1184,6 +1653,9 @@ void AppUpdate(HWND hWnd, ID3D11Device* device, ID3D11DeviceContext* deviceConte
     math::MultiplyMatricesCM(g_data.frameData.projection, g_data.frameData.camera, g_data.frameData.cameraProjection);
 
     math::Make4x4FloatMatrixIdentity(g_data.objectData.transform);
+    ApplyHotReload();
+    AdvanceClipCache(&g_data.clipCache);
+    AdvanceClipPager(&g_data.clipPager);
     ///
     static float animSpeedMod = 1.0f;
     static bool animate = true;
@@ -1218,26 +1690,26 @@ void AppUpdate(HWND hWnd, ID3D11Device* device, ID3D11DeviceContext* deviceConte
     }
     idleAnimProgress += speed;
 
-    float idleDur = math::Lerp(g_data.testAnim[0].duration, g_data.testAnim[1].duration, crouching);
-    float walkDur = math::Lerp(g_data.testAnim[2].duration, g_data.testAnim[3].duration, running);
+    float idleDur = math::Lerp(GetClipDuration(g_data.slotHandles[0]), GetClipDuration(g_data.slotHandles[1]), crouching);
+    float walkDur = math::Lerp(GetClipDuration(g_data.slotHandles[2]), GetClipDuration(g_data.slotHandles[3]), running);
 
     if (idleAnimProgress > idleDur) { idleAnimProgress -= idleDur; }
     if (walkAnimProgress > walkDur) { walkAnimProgress -= walkDur; }
 
     {   // idle 
-        PlayClip(&g_data.animStack, &g_data.testAnim[0], idleLayer, idleAnimProgress);
+        PlayClip(&g_data.animStack, g_data.slotHandles[0], idleLayer, idleAnimProgress);
     }
     {   // crouch 
-        PlayClip(&g_data.animStack, &g_data.testAnim[1], crouchLayer, idleAnimProgress);
+        PlayClip(&g_data.animStack, g_data.slotHandles[1], crouchLayer, idleAnimProgress);
     }
     {   // non locomotion pose layer
         TwoWayBlend(&g_data.animStack, idleLayer, crouchLayer, nonLocomotionLayer, crouching);
     }
     {   // walk 
-        PlayClip(&g_data.animStack, &g_data.testAnim[2], walkLayer, walkAnimProgress);
+        PlayClip(&g_data.animStack, g_data.slotHandles[2], walkLayer, walkAnimProgress);
     }
     {   // run
-        PlayClip(&g_data.animStack, &g_data.testAnim[3], runLayer, walkAnimProgress);
+        PlayClip(&g_data.animStack, g_data.slotHandles[3], runLayer, walkAnimProgress);
     }
     {   // locomotion pose layer
         TwoWayBlend(&g_data.animStack, walkLayer, runLayer, locomotionLayer, running);
@@ -1329,6 +1801,43 @@ void AppUpdate(HWND hWnd, ID3D11Device* device, ID3D11DeviceContext* deviceConte
         ImGui::Checkbox("Transform Hierarchy", &transformHierarchy);
         ImGui::Checkbox("Animate", &animate);
         ImGui::SliderFloat("Playback Speed Modifier", &animSpeedMod, -1.0f, 1.0f);
+        ImGui::Text("Resident keyframes: %.1f / %.1f KB, evicted %.1f KB", g_data.clipPager.residentBytes / 1024.0f, g_data.clipPager.budget / 1024.0f, g_data.clipPager.evictedBytes / 1024.0f);
+        ImGui::Text("Resident clips: %.1f / %.1f KB, evicted %.1f KB in %u clips", g_data.clipCache.residentBytes / 1024.0f, g_data.clipCache.budget / 1024.0f, g_data.clipCache.evictedBytes / 1024.0f, g_data.clipCache.numEvictions);
+        if (CLIP_STORAGE_USED == CLIP_STORAGE_STREAMED) {
+            size_t streamedBytes = 0;
+            uint32_t numStalls = 0;
+            for (uint32_t i = 0; i < g_data.clipCache.numEntries; ++i) {
+                auto entry = &g_data.clipCache.entries[i];
+                if (entry->handle.storage.object != nullptr && IsClipReady(&entry->handle)) {
+                    streamedBytes += GetStreamedClip(entry->handle.storage)->streamedBytes;
+                    numStalls += GetStreamedClip(entry->handle.storage)->numStalls;
+                }
+            }
+            ImGui::Text("Streamed segments: %.1f KB, %u stalls", streamedBytes / 1024.0f, numStalls);
+        }
+        if (CLIP_TRACK_SHARING_USED) {
+            auto& tracks = g_data.clipCache.tracks;
+            LockMutex(&tracks.mutex);   // loads share tracks on the workers
+            uint32_t numArrays = tracks.numArrays;
+            size_t storedBytes = tracks.storedBytes;
+            size_t savedBytes = tracks.referencedBytes - tracks.storedBytes;
+            UnlockMutex(&tracks.mutex);
+            ImGui::Text("Shared tracks: %u arrays, %.1f KB, %.1f KB saved", numArrays, storedBytes / 1024.0f, savedBytes / 1024.0f);
+        }
+        ChecksumStats checksumStats;
+        GetChecksumStats(&checksumStats);
+        ImGui::Text("Checksums: %.1f MB in %.2f ms, %llu sections, %llu rejected", checksumStats.numBytes / (1024.0f * 1024.0f), checksumStats.seconds * 1000.0,
+            (unsigned long long)checksumStats.numSections, (unsigned long long)checksumStats.numFailures);
+
+        static const char* slotNames[NUM_CLIP_SLOTS] = { "Idle", "Crouch", "Walk", "Run" };
+        for (uint32_t i = 0; i < NUM_CLIP_SLOTS; ++i) {
+            int selected = (int)g_data.slotClips[i];
+            if (ImGui::Combo(slotNames[i], &selected, animFiles, numAnims) && (uint32_t)selected != g_data.slotClips[i]) {
+                ReleaseCachedClip(&g_data.clipCache, g_data.slotClips[i]);
+                g_data.slotClips[i] = (uint32_t)selected;
+                g_data.slotHandles[i] = AcquireCachedClip(&g_data.clipCache, g_data.slotClips[i]);
+            }
+        }
 
         //if (ImGui::BeginCombo("Animation Clip", animClip->name)) {
         //    for (uint32_t i = 0; i < numAnims; ++i) {
@@ -1350,7 +1859,7 @@ void AppUpdate(HWND hWnd, ID3D11Device* device, ID3D11DeviceContext* deviceConte
         for (auto i = 0u; i < g_data.testSkeleton.numJoints; ++i) { isDisplayed[i] = false; }
         for (auto i = 0u; i < g_data.testSkeleton.numJoints; ++i) {
             ImGui::PushID(i);
-            if (ImGui::Selectable(g_data.testSkeleton.nameTable[i], selectedJoint == i)) {
+            if (ImGui::Selectable(GetJointName(&g_data.testSkeleton, i), selectedJoint == i)) {
                 selectedJoint = i;
             }
             ImGui::PopID();
@@ -1420,9 +1929,9 @@ void AppUpdate(HWND hWnd, ID3D11Device* device, ID3D11DeviceContext* deviceConte
 
             
             ImGui::SetCursorScreenPos(ImVec2(labelPos.x - 2.5f, labelPos.y - 2.5f));
-            ImGui::InvisibleButton(g_data.testSkeleton.nameTable[i], ImVec2(8.5f, 8.5f));
+            ImGui::InvisibleButton(GetJointName(&g_data.testSkeleton, i), ImVec2(8.5f, 8.5f));
             if (ImGui::IsItemHoveredRect() || selectedJoint == i) {
-                drawList->AddText(labelPos, ImColor(1.0f, 1.0f, 1.0f), g_data.testSkeleton.nameTable[i]);
+                drawList->AddText(labelPos, ImColor(1.0f, 1.0f, 1.0f), GetJointName(&g_data.testSkeleton, i));
             }
             
             auto parent = g_data.testSkeleton.joints[i].parent;
@@ -1486,7 +1995,7 @@ void AppRender(HWND hWnd, ID3D11Device* device, ID3D11DeviceContext* deviceConte
         uint32_t offset = 0;
         deviceContext->IASetVertexBuffers(0, 1, &g_data.testMesh.vertexBuffer, &stride, &offset);
         deviceContext->IASetIndexBuffer(g_data.testMesh.indexBuffer, DXGI_FORMAT_R32_UINT, 0);
-        deviceContext->IASetInputLayout(Vertex::GetInputLayout(device, &g_data.shaderDesc));
+        deviceContext->IASetInputLayout(GetVertexInputLayout(device, &g_data.shaderDesc));
         deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
         deviceContext->VSSetShader(g_data.shader.vertexShader, nullptr, 0);
@@ -1499,7 +2008,10 @@ void AppRender(HWND hWnd, ID3D11Device* device, ID3D11DeviceContext* deviceConte
         };
         deviceContext->VSSetConstantBuffers(0, 3, cbuffers);
 
-        deviceContext->DrawIndexed(g_data.testMesh.numElements, 0, 0);
+        for (uint32_t i = 0; i < g_data.testMesh.numSubmeshes; ++i) {
+            auto& submesh = g_data.testMesh.submeshes[i];
+            deviceContext->DrawIndexed(submesh.numIndices, submesh.firstIndex, 0);
+        }
 
     }
 }
@@ -1507,5 +2019,10 @@ void AppRender(HWND hWnd, ID3D11Device* device, ID3D11DeviceContext* deviceConte
 ///
 void AppShutdown()
 {
-    
+    StopHotReload(&g_data.hotReload);
+    ShutdownJobPool(&g_data.jobPool);   // clip loads may still write into the cached clips
+    ShutdownClipCache(&g_data.clipCache);
+    UnmapFile(&g_data.vertexShaderFile);
+    UnmapFile(&g_data.pixelShaderFile);
+    ClosePackage(&g_package);
 }
\ No newline at end of file
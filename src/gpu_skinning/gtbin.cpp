@@ -0,0 +1,225 @@
+#include "gtbin.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "checksum.h"
+
+static void GTBinReserve(char** data, size_t* capacity, size_t size)
+{
+    if (size <= *capacity) { return; }
+    size_t newCapacity = *capacity ? *capacity : 4096;
+    while (newCapacity < size) { newCapacity *= 2; }
+    *data = (char*)realloc(*data, newCapacity);
+    *capacity = newCapacity;
+}
+
+static void GTBinChecksumHeader(GTBinHeader* header)
+{
+    header->headerChecksum = ComputeChecksum(header, offsetof(GTBinHeader, headerChecksum));
+}
+
+void GTBinBegin(GTBinWriter* writer)
+{
+    *writer = GTBinWriter();
+    GTBinAlloc(writer, sizeof(GTBinHeader), 16);
+}
+
+size_t GTBinAlloc(GTBinWriter* writer, size_t size, size_t alignment)
+{
+    size_t offset = (writer->size + alignment - 1) & ~(alignment - 1);
+    GTBinReserve(&writer->data, &writer->capacity, offset + size);
+    memset(writer->data + writer->size, 0x0, offset + size - writer->size);
+    writer->size = offset + size;
+    return offset;
+}
+
+size_t GTBinWrite(GTBinWriter* writer, const void* data, size_t size, size_t alignment)
+{
+    size_t offset = GTBinAlloc(writer, size, alignment);
+    if (size > 0) {
+        memcpy(writer->data + offset, data, size);
+    }
+    return offset;
+}
+
+size_t GTBinWriteStreamed(GTBinWriter* writer, const void* data, size_t size, size_t alignment)
+{
+    size_t offset = (writer->streamedSize + alignment - 1) & ~(alignment - 1);
+    GTBinReserve(&writer->streamed, &writer->streamedCapacity, offset + size);
+    memset(writer->streamed + writer->streamedSize, 0x0, offset - writer->streamedSize);
+    if (size > 0) {
+        memcpy(writer->streamed + offset, data, size);
+    }
+    writer->streamedSize = offset + size;
+    return offset;
+}
+
+void* GTBinAt(GTBinWriter* writer, size_t offset)
+{
+    return writer->data + offset;
+}
+
+void GTBinPointer(GTBinWriter* writer, size_t slotOffset, size_t targetOffset)
+{
+    uintptr_t value = (uintptr_t)targetOffset;
+    memcpy(writer->data + slotOffset, &value, sizeof(value));
+    if (writer->numFixups == writer->fixupCapacity) {
+        writer->fixupCapacity = writer->fixupCapacity ? writer->fixupCapacity * 2 : 256;
+        writer->fixups = (uint64_t*)realloc(writer->fixups, writer->fixupCapacity * sizeof(uint64_t));
+    }
+    writer->fixups[writer->numFixups++] = (uint64_t)slotOffset;
+}
+
+bool GTBinFinish(GTBinWriter* writer, const char* path, uint32_t type, const GTBinSource& source, size_t rootOffset)
+{
+    size_t fixupOffset = GTBinWrite(writer, writer->fixups, writer->numFixups * sizeof(uint64_t), 8);
+    size_t streamedOffset = writer->size;
+    if (writer->streamedSize != 0) {    // blocks keep the alignment they were written with up to 16
+        streamedOffset = GTBinWrite(writer, writer->streamed, writer->streamedSize, 16);
+    }
+
+    GTBinHeader header;
+    header.magic = GTBIN_MAGIC;
+    header.version = GTBIN_VERSION;
+    header.type = type;
+    header.pointerSize = sizeof(void*);
+    header.source = source;
+    header.rootOffset = rootOffset;
+    header.fixupOffset = fixupOffset;
+    header.numFixups = writer->numFixups;
+    header.streamedOffset = streamedOffset;
+    header.flags = GTBIN_FLAG_CHECKSUMS;
+    header.reserved = 0;
+    header.payloadChecksum = ComputeChecksum(writer->data + sizeof(header), fixupOffset - sizeof(header));
+    header.fixupChecksum = ComputeChecksum(writer->data + fixupOffset, streamedOffset - fixupOffset);
+    GTBinChecksumHeader(&header);
+    memcpy(writer->data, &header, sizeof(header));
+
+    bool res = WriteFileContents(path, writer->data, writer->size);
+    GTBinDiscard(writer);
+    return res;
+}
+
+void GTBinDiscard(GTBinWriter* writer)
+{
+    free(writer->data);
+    free(writer->fixups);
+    free(writer->streamed);
+    *writer = GTBinWriter();
+}
+
+bool GTBinLoad(const char* path, uint32_t type, size_t rootSize, const GTBinSource& source, FileMapping* outMapping, void** outRoot)
+{
+    {   // don't bother mapping images that are missing or stale
+        FileInfo info;
+        if (!QueryFileInfo(path, &info) || info.size < sizeof(GTBinHeader)) {
+            return false;
+        }
+    }
+    if (!MapFile(path, outMapping, FILE_MAPPING_COPY_ON_WRITE)) {
+        return false;
+    }
+    char* base = (char*)outMapping->data;
+    GTBinHeader header;
+    memcpy(&header, base, sizeof(header));
+
+    bool valid = header.magic == GTBIN_MAGIC && header.version == GTBIN_VERSION && header.type == type
+        && header.pointerSize == sizeof(void*)
+        && header.source.size == source.size && header.source.modifiedTime == source.modifiedTime
+        && header.source.dependencyHash == source.dependencyHash
+        && header.fixupOffset >= sizeof(header) && header.fixupOffset <= outMapping->size
+        && header.rootOffset >= sizeof(header) && header.rootOffset <= header.fixupOffset
+        && rootSize <= header.fixupOffset - header.rootOffset
+        && header.streamedOffset >= header.fixupOffset && header.streamedOffset <= outMapping->size
+        && header.numFixups <= (header.streamedOffset - header.fixupOffset) / sizeof(uint64_t);
+    if (!valid) {
+        UnmapFile(outMapping);
+        return false;
+    }
+    // the flag sits in the header it vouches for, an image without it is as suspect as one that fails its checksums
+    bool intact = (header.flags & GTBIN_FLAG_CHECKSUMS)
+        && VerifyChecksum(base, offsetof(GTBinHeader, headerChecksum), header.headerChecksum)
+        && VerifyChecksum(base + sizeof(header), header.fixupOffset - sizeof(header), header.payloadChecksum)
+        && VerifyChecksum(base + header.fixupOffset, header.streamedOffset - header.fixupOffset, header.fixupChecksum);
+    if (!intact) {
+        printf("%s: checksum mismatch, rejecting the image\n", path);
+        UnmapFile(outMapping);
+        return false;
+    }
+
+    const uint64_t* fixups = (const uint64_t*)(base + header.fixupOffset);
+    for (uint64_t i = 0; i < header.numFixups; ++i) {
+        uint64_t slot = fixups[i];
+        if (slot > header.streamedOffset - sizeof(uintptr_t)) {
+            printf("%s: corrupt fixup table\n", path);
+            UnmapFile(outMapping);
+            return false;
+        }
+        uintptr_t* pointer = (uintptr_t*)(base + slot);
+        *pointer += (uintptr_t)base;
+    }
+    *outRoot = base + header.rootOffset;
+    return true;
+}
+
+const char* GTBinStreamed(const FileMapping* mapping)
+{
+    GTBinHeader header;
+    memcpy(&header, mapping->data, sizeof(header));
+    return mapping->data + header.streamedOffset;
+}
+
+bool GTBinRestamp(const char* path, const char* sourcePath)
+{
+    FileInfo info;
+    FileMapping mapping;
+    if (!QueryFileInfo(sourcePath, &info) || !MapFile(path, &mapping)) {
+        return false;
+    }
+    if (mapping.size < sizeof(GTBinHeader)) {
+        UnmapFile(&mapping);
+        return false;
+    }
+    GTBinHeader header;
+    memcpy(&header, mapping.data, sizeof(header));
+    if (!(header.flags & GTBIN_FLAG_CHECKSUMS) || !VerifyChecksum(mapping.data, offsetof(GTBinHeader, headerChecksum), header.headerChecksum)) {
+        UnmapFile(&mapping);
+        return false;   // restamping would make a corrupt header look valid
+    }
+    if (header.source.size == info.size && header.source.modifiedTime == info.modifiedTime) {
+        UnmapFile(&mapping);
+        return true;
+    }
+    header.source.size = info.size;
+    header.source.modifiedTime = info.modifiedTime;
+    GTBinChecksumHeader(&header);
+    char* data = (char*)malloc(mapping.size);
+    memcpy(data, mapping.data, mapping.size);
+    memcpy(data, &header, sizeof(header));
+    size_t size = mapping.size;
+    UnmapFile(&mapping);   // win32 can't replace a file that is still mapped
+    bool res = WriteFileContents(path, data, size);
+    free(data);
+    return res;
+}
+
+bool GTBinPathFor(const char* sourcePath, char* outPath, size_t outPathSize, const char* variant)
+{
+    if (variant != nullptr) {
+        return snprintf(outPath, outPathSize, "%s.%s.gtbin", sourcePath, variant) < (int)outPathSize;
+    }
+    return snprintf(outPath, outPathSize, "%s.gtbin", sourcePath) < (int)outPathSize;
+}
+
+bool GTBinSourceFor(const char* sourcePath, uint64_t dependencyHash, GTBinSource* outSource)
+{
+    FileInfo info;
+    if (!QueryFileInfo(sourcePath, &info)) {
+        return false;
+    }
+    outSource->size = info.size;
+    outSource->modifiedTime = info.modifiedTime;
+    outSource->dependencyHash = dependencyHash;
+    return true;
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "platform/file.h"
+
+///
+/**
+    .gtbin - baked runtime data
+    The file is a memory image of the runtime structures (Skeleton, AnimationClip, MeshDesc). Pointers inside it
+    are stored as byte offsets from the start of the file and listed in a fixup table, so loading is a
+    copy-on-write mapping plus a single pass that adds the mapping's base address to every listed slot.
+
+    Layout: GTBinHeader | payload, root object first | fixup table (uint64_t offsets of pointer slots) | streamed
+    Every image is flagged GTBIN_FLAG_CHECKSUMS and carries a checksum per section (header, payload, fixup table),
+    GTBinLoad verifies them before touching any pointer (see checksum.h) and rejects corrupt images like stale ones;
+    images without the flag are rejected too, a flipped flag bit must not turn the checks off.
+    The streamed section holds blocks that are read on demand instead of on load, e.g. clip segments. GTBinLoad
+    neither verifies nor touches it, so its pages are only faulted in once a block is read; blocks hold no pointers
+    and whoever writes them keeps checksums of their own in the payload.
+*/
+#define GTBIN_MAGIC     0x4e425447  // 'GTBN'
+#define GTBIN_VERSION   9
+
+enum GTBinFlags : uint32_t
+{
+    GTBIN_FLAG_CHECKSUMS    = 1 << 0,
+};
+
+enum GTBinType : uint32_t
+{
+    GTBIN_SKELETON          = 1,
+    GTBIN_ANIMATION_CLIP    = 2,
+    GTBIN_MESH              = 3,
+    GTBIN_COMPRESSED_CLIP   = 4,
+    GTBIN_SEGMENTED_CLIP    = 5,
+    GTBIN_RESAMPLED_CLIP    = 6,
+};
+
+// identifies what a baked image was built from, a mismatch on load means the bake is stale
+struct GTBinSource
+{
+    uint64_t    size            = 0;
+    uint64_t    modifiedTime    = 0;
+    uint64_t    dependencyHash  = 0;    // e.g. the joint order of the skeleton a clip's tracks were remapped to
+};
+
+struct GTBinHeader
+{
+    uint32_t    magic;
+    uint32_t    version;
+    uint32_t    type;
+    uint32_t    pointerSize;    // images are only valid for the pointer width they were baked with
+    GTBinSource source;
+    uint64_t    rootOffset;
+    uint64_t    fixupOffset;
+    uint64_t    numFixups;
+    uint64_t    streamedOffset;     // start of the streamed section, the file size if there is none
+    uint32_t    flags;
+    uint32_t    reserved;
+    uint64_t    headerChecksum;     // of the header up to here
+    uint64_t    payloadChecksum;    // sizeof(GTBinHeader) up to fixupOffset
+    uint64_t    fixupChecksum;      // fixupOffset up to streamedOffset
+};
+
+struct GTBinWriter
+{
+    char*       data = nullptr;
+    size_t      size = 0;
+    size_t      capacity = 0;
+
+    uint64_t*   fixups = nullptr;
+    size_t      numFixups = 0;
+    size_t      fixupCapacity = 0;
+
+    char*       streamed = nullptr;
+    size_t      streamedSize = 0;
+    size_t      streamedCapacity = 0;
+};
+
+void    GTBinBegin(GTBinWriter* writer);
+// returns the file offset of a zeroed block, pointers returned by GTBinAt are invalidated by the next allocation
+size_t  GTBinAlloc(GTBinWriter* writer, size_t size, size_t alignment);
+size_t  GTBinWrite(GTBinWriter* writer, const void* data, size_t size, size_t alignment);
+void*   GTBinAt(GTBinWriter* writer, size_t offset);
+// appends a block to the streamed section, returns its offset from the start of the section
+size_t  GTBinWriteStreamed(GTBinWriter* writer, const void* data, size_t size, size_t alignment);
+// stores targetOffset in the pointer slot at slotOffset and records the slot for fixup
+void    GTBinPointer(GTBinWriter* writer, size_t slotOffset, size_t targetOffset);
+// writes the image to path and releases the writer
+bool    GTBinFinish(GTBinWriter* writer, const char* path, uint32_t type, const GTBinSource& source, size_t rootOffset);
+void    GTBinDiscard(GTBinWriter* writer);
+
+// maps path copy-on-write, validates it against type and source and applies the fixups, the rootSize bytes of the
+// root object have to fit in the payload; on success the root lives in outMapping until it is released with UnmapFile
+bool    GTBinLoad(const char* path, uint32_t type, size_t rootSize, const GTBinSource& source, FileMapping* outMapping, void** outRoot);
+// the streamed section of an image loaded by GTBinLoad
+const char* GTBinStreamed(const FileMapping* mapping);
+
+// rewrites the size and modification time an image was baked from, for sources touched without changing their contents;
+// fails for images whose header doesn't pass its checksum
+bool    GTBinRestamp(const char* path, const char* sourcePath);
+
+// <sourcePath>.gtbin, or <sourcePath>.<variant>.gtbin for sources baked into more than one image
+bool    GTBinPathFor(const char* sourcePath, char* outPath, size_t outPathSize, const char* variant = nullptr);
+bool    GTBinSourceFor(const char* sourcePath, uint64_t dependencyHash, GTBinSource* outSource);
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+///
+static uint64_t HashFNV1a64(const void* data, size_t size, uint64_t seed = 0xcbf29ce484222325ull)
+{
+    const uint8_t* bytes = (const uint8_t*)data;
+    uint64_t hash = seed;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+///
+/**
+    XXH64, for hashing whole files. Consumes 32 bytes per iteration in four independent lanes,
+    several times the throughput of HashFNV1a64 on large inputs.
+*/
+#define XXH64_PRIME1 0x9e3779b185ebca87ull
+#define XXH64_PRIME2 0xc2b2ae3d27d4eb4full
+#define XXH64_PRIME3 0x165667b19e3779f9ull
+#define XXH64_PRIME4 0x85ebca77c2b2ae63ull
+#define XXH64_PRIME5 0x27d4eb2f165667c5ull
+
+static uint64_t XXH64Rotl(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static uint64_t XXH64Round(uint64_t acc, uint64_t input)
+{
+    acc += input * XXH64_PRIME2;
+    acc = XXH64Rotl(acc, 31);
+    return acc * XXH64_PRIME1;
+}
+
+static uint64_t XXH64MergeRound(uint64_t acc, uint64_t lane)
+{
+    acc ^= XXH64Round(0, lane);
+    return acc * XXH64_PRIME1 + XXH64_PRIME4;
+}
+
+static uint64_t HashXXH64(const void* data, size_t size, uint64_t seed = 0)
+{
+    const uint8_t* p = (const uint8_t*)data;
+    const uint8_t* end = p + size;
+    auto Read64 = [](const uint8_t* ptr) -> uint64_t { uint64_t v; memcpy(&v, ptr, sizeof(v)); return v; };
+    auto Read32 = [](const uint8_t* ptr) -> uint32_t { uint32_t v; memcpy(&v, ptr, sizeof(v)); return v; };
+
+    uint64_t hash;
+    if (size >= 32) {
+        uint64_t v1 = seed + XXH64_PRIME1 + XXH64_PRIME2;
+        uint64_t v2 = seed + XXH64_PRIME2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - XXH64_PRIME1;
+        const uint8_t* limit = end - 32;
+        do {
+            v1 = XXH64Round(v1, Read64(p + 0));
+            v2 = XXH64Round(v2, Read64(p + 8));
+            v3 = XXH64Round(v3, Read64(p + 16));
+            v4 = XXH64Round(v4, Read64(p + 24));
+            p += 32;
+        } while (p <= limit);
+        hash = XXH64Rotl(v1, 1) + XXH64Rotl(v2, 7) + XXH64Rotl(v3, 12) + XXH64Rotl(v4, 18);
+        hash = XXH64MergeRound(hash, v1);
+        hash = XXH64MergeRound(hash, v2);
+        hash = XXH64MergeRound(hash, v3);
+        hash = XXH64MergeRound(hash, v4);
+    }
+    else {
+        hash = seed + XXH64_PRIME5;
+    }
+    hash += (uint64_t)size;
+
+    for (; p + 8 <= end; p += 8) {
+        hash ^= XXH64Round(0, Read64(p));
+        hash = XXH64Rotl(hash, 27) * XXH64_PRIME1 + XXH64_PRIME4;
+    }
+    if (p + 4 <= end) {
+        hash ^= (uint64_t)Read32(p) * XXH64_PRIME1;
+        hash = XXH64Rotl(hash, 23) * XXH64_PRIME2 + XXH64_PRIME3;
+        p += 4;
+    }
+    for (; p < end; ++p) {
+        hash ^= (*p) * XXH64_PRIME5;
+        hash = XXH64Rotl(hash, 11) * XXH64_PRIME1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= XXH64_PRIME2;
+    hash ^= hash >> 29;
+    hash *= XXH64_PRIME3;
+    hash ^= hash >> 32;
+    return hash;
+}
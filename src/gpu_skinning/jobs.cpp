@@ -0,0 +1,123 @@
+#include "jobs.h"
+
+static bool PopJob(JobPool* pool, Job* outJob)
+{
+    if (pool->count == 0) {
+        return false;
+    }
+    *outJob = pool->queue[pool->head];
+    pool->head = (pool->head + 1) % JOB_QUEUE_CAPACITY;
+    pool->count--;
+    pool->numRunning++;
+    return true;
+}
+
+static void FinishJob(JobPool* pool)
+{
+    LockMutex(&pool->mutex);
+    pool->numRunning--;
+    if (pool->count == 0 && pool->numRunning == 0) {
+        BroadcastCondition(&pool->jobsDone);
+    }
+    UnlockMutex(&pool->mutex);
+}
+
+static void WorkerMain(void* userData)
+{
+    auto pool = (JobPool*)userData;
+    for (;;) {
+        Job job;
+        LockMutex(&pool->mutex);
+        while (!PopJob(pool, &job)) {
+            if (pool->quit) {
+                UnlockMutex(&pool->mutex);
+                return;
+            }
+            WaitCondition(&pool->jobAvailable, &pool->mutex);
+        }
+        UnlockMutex(&pool->mutex);
+        job.func(job.userData);
+        FinishJob(pool);
+    }
+}
+
+bool InitJobPool(JobPool* pool, uint32_t numWorkers)
+{
+    if (numWorkers == 0) {
+        auto hardwareThreads = GetNumHardwareThreads();
+        numWorkers = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+    }
+    numWorkers = numWorkers < MAX_JOB_WORKERS ? numWorkers : MAX_JOB_WORKERS;
+
+    InitMutex(&pool->mutex);
+    InitCondition(&pool->jobAvailable);
+    InitCondition(&pool->jobsDone);
+    pool->head = 0;
+    pool->count = 0;
+    pool->numRunning = 0;
+    pool->quit = false;
+    pool->numWorkers = 0;
+    for (uint32_t i = 0; i < numWorkers; ++i) {
+        if (!StartThread(&pool->workers[i], WorkerMain, pool)) {
+            break;
+        }
+        pool->numWorkers++;
+    }
+    return pool->numWorkers > 0;
+}
+
+void ShutdownJobPool(JobPool* pool)
+{
+    LockMutex(&pool->mutex);
+    pool->quit = true;
+    BroadcastCondition(&pool->jobAvailable);
+    UnlockMutex(&pool->mutex);
+    for (uint32_t i = 0; i < pool->numWorkers; ++i) {
+        JoinThread(&pool->workers[i]);
+    }
+    while (RunPendingJob(pool)) {}  // a pool without workers may still hold jobs
+    pool->numWorkers = 0;
+    DestroyCondition(&pool->jobsDone);
+    DestroyCondition(&pool->jobAvailable);
+    DestroyMutex(&pool->mutex);
+}
+
+void PushJob(JobPool* pool, JobFunc func, void* userData)
+{
+    LockMutex(&pool->mutex);
+    if (pool->numWorkers == 0 || pool->count == JOB_QUEUE_CAPACITY) {
+        UnlockMutex(&pool->mutex);
+        func(userData);
+        return;
+    }
+    auto tail = (pool->head + pool->count) % JOB_QUEUE_CAPACITY;
+    pool->queue[tail].func = func;
+    pool->queue[tail].userData = userData;
+    pool->count++;
+    SignalCondition(&pool->jobAvailable);
+    UnlockMutex(&pool->mutex);
+}
+
+bool RunPendingJob(JobPool* pool)
+{
+    Job job;
+    LockMutex(&pool->mutex);
+    bool popped = PopJob(pool, &job);
+    UnlockMutex(&pool->mutex);
+    if (!popped) {
+        return false;
+    }
+    job.func(job.userData);
+    FinishJob(pool);
+    return true;
+}
+
+void WaitForJobs(JobPool* pool)
+{
+    while (RunPendingJob(pool)) {}
+    LockMutex(&pool->mutex);
+    while (pool->count != 0 || pool->numRunning != 0) {
+        WaitCondition(&pool->jobsDone, &pool->mutex);
+    }
+    UnlockMutex(&pool->mutex);
+}
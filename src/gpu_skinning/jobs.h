@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdint.h>
+#include "platform/thread.h"
+
+///
+/**
+    Fixed size worker pool running fire-and-forget jobs in FIFO order.
+    Jobs that don't fit into the queue, or are pushed to a pool without workers, run inline on the caller.
+*/
+typedef void (*JobFunc)(void* userData);
+
+#define MAX_JOB_WORKERS     64
+#define JOB_QUEUE_CAPACITY  1024
+
+struct Job
+{
+    JobFunc func;
+    void*   userData;
+};
+
+struct JobPool
+{
+    Thread              workers[MAX_JOB_WORKERS];
+    uint32_t            numWorkers = 0;
+
+    Mutex               mutex;
+    ConditionVariable   jobAvailable;
+    ConditionVariable   jobsDone;
+
+    Job                 queue[JOB_QUEUE_CAPACITY];
+    uint32_t            head = 0;
+    uint32_t            count = 0;
+    uint32_t            numRunning = 0;
+    bool                quit = false;
+};
+
+// numWorkers == 0 picks one worker per hardware thread minus the calling thread
+bool InitJobPool(JobPool* pool, uint32_t numWorkers = 0);
+// runs all queued jobs to completion before joining the workers
+void ShutdownJobPool(JobPool* pool);
+
+void PushJob(JobPool* pool, JobFunc func, void* userData);
+// runs one queued job on the calling thread, returns false if the queue was empty
+bool RunPendingJob(JobPool* pool);
+// blocks until the queue is empty and no job is running, helping out with queued jobs meanwhile
+void WaitForJobs(JobPool* pool);
@@ -0,0 +1,138 @@
+#include "lz.h"
+
+#include <string.h>
+#include <assert.h>
+
+#define LZ_MIN_MATCH    4
+#define LZ_MAX_OFFSET   0xffff
+#define LZ_HASH_BITS    14
+
+static uint32_t LZRead32(const uint8_t* p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static uint32_t LZHash(uint32_t v)
+{
+    return (v * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+static uint8_t* LZWriteLength(uint8_t* op, size_t length)
+{
+    while (length >= 255) {
+        *op++ = 255;
+        length -= 255;
+    }
+    *op++ = (uint8_t)length;
+    return op;
+}
+
+static uint8_t* LZWriteSequence(uint8_t* op, const uint8_t* literals, size_t numLiterals, size_t offset, size_t matchLength)
+{
+    size_t matchCode = matchLength ? matchLength - LZ_MIN_MATCH : 0;
+    *op++ = (uint8_t)(((numLiterals < 15 ? numLiterals : 15) << 4) | (matchCode < 15 ? matchCode : 15));
+    if (numLiterals >= 15) {
+        op = LZWriteLength(op, numLiterals - 15);
+    }
+    memcpy(op, literals, numLiterals);
+    op += numLiterals;
+    if (matchLength) {
+        *op++ = (uint8_t)(offset & 0xff);
+        *op++ = (uint8_t)(offset >> 8);
+        if (matchCode >= 15) {
+            op = LZWriteLength(op, matchCode - 15);
+        }
+    }
+    return op;
+}
+
+size_t LZCompressBound(size_t srcSize)
+{
+    return srcSize + srcSize / 255 + 16;
+}
+
+size_t LZCompress(const void* srcData, size_t srcSize, void* dstData, size_t dstCapacity)
+{
+    assert(dstCapacity >= LZCompressBound(srcSize));
+    const uint8_t* src = (const uint8_t*)srcData;
+    uint8_t* op = (uint8_t*)dstData;
+
+    uint32_t table[1 << LZ_HASH_BITS];  // position + 1 of the last occurrence, 0 if none
+    memset(table, 0x0, sizeof(table));
+
+    size_t ip = 0;
+    size_t anchor = 0;
+    while (ip + LZ_MIN_MATCH <= srcSize) {
+        uint32_t sequence = LZRead32(src + ip);
+        uint32_t h = LZHash(sequence);
+        size_t candidate = table[h];
+        table[h] = (uint32_t)(ip + 1);
+        if (candidate == 0 || ip - (candidate - 1) > LZ_MAX_OFFSET || LZRead32(src + candidate - 1) != sequence) {
+            ip++;
+            continue;
+        }
+        candidate--;
+        size_t length = LZ_MIN_MATCH;
+        while (ip + length < srcSize && src[candidate + length] == src[ip + length]) {
+            length++;
+        }
+        op = LZWriteSequence(op, src + anchor, ip - anchor, ip - candidate, length);
+        ip += length;
+        anchor = ip;
+    }
+    op = LZWriteSequence(op, src + anchor, srcSize - anchor, 0, 0);
+    return (size_t)(op - (uint8_t*)dstData);
+}
+
+static bool LZReadLength(const uint8_t*& ip, const uint8_t* end, size_t* length)
+{
+    uint8_t b;
+    do {
+        if (ip == end) { return false; }
+        b = *ip++;
+        *length += b;
+    } while (b == 255);
+    return true;
+}
+
+bool LZDecompress(const void* srcData, size_t srcSize, void* dstData, size_t dstSize)
+{
+    const uint8_t* ip = (const uint8_t*)srcData;
+    const uint8_t* end = ip + srcSize;
+    uint8_t* dst = (uint8_t*)dstData;
+    size_t op = 0;
+
+    while (ip < end) {
+        uint8_t token = *ip++;
+        size_t numLiterals = token >> 4;
+        if (numLiterals == 15 && !LZReadLength(ip, end, &numLiterals)) { return false; }
+        if (numLiterals > (size_t)(end - ip) || numLiterals > dstSize - op) { return false; }
+        memcpy(dst + op, ip, numLiterals);
+        ip += numLiterals;
+        op += numLiterals;
+        if (ip == end) {    // last sequence
+            break;
+        }
+
+        if (end - ip < 2) { return false; }
+        size_t offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+        ip += 2;
+        size_t length = token & 0xf;
+        if (length == 15 && !LZReadLength(ip, end, &length)) { return false; }
+        length += LZ_MIN_MATCH;
+        if (offset == 0 || offset > op || length > dstSize - op) { return false; }
+        const uint8_t* match = dst + op - offset;
+        if (offset >= length) {
+            memcpy(dst + op, match, length);
+        }
+        else {  // overlapping match repeats the last offset bytes
+            for (size_t i = 0; i < length; ++i) {
+                dst[op + i] = match[i];
+            }
+        }
+        op += length;
+    }
+    return op == dstSize;
+}
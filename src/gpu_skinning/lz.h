@@ -0,0 +1,19 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+///
+/**
+    Small byte oriented LZ77 codec for asset chunks.
+    A block is a sequence of
+        token (literal length << 4 | match length - 4), [literal length extension], literals,
+        match offset (u16 le), [match length extension]
+    where lengths of 15 in the token are extended by a run of bytes that are summed up until one is below 255.
+    The last sequence of a block carries literals only. Offsets are limited to 64 KB, so blocks compress independently.
+*/
+size_t LZCompressBound(size_t srcSize);
+// dstCapacity must be at least LZCompressBound(srcSize), returns the compressed size
+size_t LZCompress(const void* src, size_t srcSize, void* dst, size_t dstCapacity);
+// returns false unless src decodes to exactly dstSize bytes, never reads or writes out of bounds
+bool LZDecompress(const void* src, size_t srcSize, void* dst, size_t dstSize);
@@ -153,7 +153,7 @@ namespace math
         };
 
         Vec4() : x(0.0f), y(0.0f), z(0.0f), w(0.0f) {};
-        Vec4(const Vec3& xyz_, float w_) : xyz(xyz_), w(w_) {}
+        Vec4(const Vec3& xyz_, float w_) : x(xyz_.x), y(xyz_.y), z(xyz_.z), w(w_) {}    // xyz and w live in different members of the union, only one of them may be initialized
         Vec4(float x_, float y_, float z_, float w_)
             : x(x_), y(y_), z(z_), w(w_) {}
 
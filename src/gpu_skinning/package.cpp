@@ -0,0 +1,283 @@
+#include "package.h"
+#include "lz.h"
+#include "hash.h"
+#include "checksum.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+uint64_t HashPackagePath(const char* path)
+{
+    uint64_t hash = HashFNV1a64(nullptr, 0);
+    for (const char* c = path; *c != '\0'; ++c) {
+        char normalized = *c == '\\' ? '/' : *c;
+        hash = HashFNV1a64(&normalized, 1, hash);
+    }
+    return hash;
+}
+
+// a is read from the package and may run up to aSize bytes without a terminator, b is zero terminated
+static bool PackagePathsEqual(const char* a, size_t aSize, const char* b)
+{
+    for (size_t i = 0; i < aSize; ++i, ++b) {
+        char ca = a[i] == '\\' ? '/' : a[i];
+        char cb = *b == '\\' ? '/' : *b;
+        if (ca != cb) { return false; }
+        if (ca == '\0') { return true; }
+    }
+    return false;
+}
+
+///
+struct PackageBuffer
+{
+    char*   data = nullptr;
+    size_t  size = 0;
+    size_t  capacity = 0;
+};
+
+static char* PackageBufferAppend(PackageBuffer* buffer, const void* data, size_t size)
+{
+    if (buffer->size + size > buffer->capacity) {
+        size_t capacity = buffer->capacity ? buffer->capacity : 64 * 1024;
+        while (capacity < buffer->size + size) { capacity *= 2; }
+        buffer->data = (char*)realloc(buffer->data, capacity);
+        buffer->capacity = capacity;
+    }
+    char* dest = buffer->data + buffer->size;
+    if (data != nullptr) {
+        memcpy(dest, data, size);
+    }
+    buffer->size += size;
+    return dest;
+}
+
+bool WritePackage(const char* packagePath, const char* const* files, uint32_t numFiles)
+{
+    PackageEntry* entries = (PackageEntry*)malloc(sizeof(PackageEntry) * (numFiles ? numFiles : 1));
+    PackageBuffer chunks;
+    PackageBuffer strings;
+    PackageBuffer data;
+    char* scratch = (char*)malloc(LZCompressBound(PACKAGE_CHUNK_SIZE));
+    bool success = true;
+
+    for (uint32_t i = 0; i < numFiles && success; ++i) {
+        FileMapping file;
+        if (!MapFile(files[i], &file)) {
+            success = false;
+            break;
+        }
+        auto& entry = entries[i];
+        entry.pathHash = HashPackagePath(files[i]);
+        entry.pathOffset = (uint32_t)strings.size;
+        entry.firstChunk = (uint32_t)(chunks.size / sizeof(PackageChunk));
+        entry.size = file.size;
+        PackageBufferAppend(&strings, files[i], strlen(files[i]) + 1);
+
+        for (size_t offset = 0; offset < file.size; offset += PACKAGE_CHUNK_SIZE) {
+            size_t rawSize = file.size - offset < PACKAGE_CHUNK_SIZE ? file.size - offset : PACKAGE_CHUNK_SIZE;
+            size_t compressedSize = LZCompress(file.data + offset, rawSize, scratch, LZCompressBound(PACKAGE_CHUNK_SIZE));
+
+            PackageChunk chunk;
+            chunk.offset = data.size;
+            chunk.rawSize = (uint32_t)rawSize;
+            if (compressedSize < rawSize) {
+                chunk.compressedSize = (uint32_t)compressedSize;
+                chunk.checksum = ComputeChecksum(scratch, compressedSize);
+                PackageBufferAppend(&data, scratch, compressedSize);
+            }
+            else {
+                chunk.compressedSize = (uint32_t)rawSize;
+                chunk.checksum = ComputeChecksum(file.data + offset, rawSize);
+                PackageBufferAppend(&data, file.data + offset, rawSize);
+            }
+            PackageBufferAppend(&chunks, &chunk, sizeof(chunk));
+        }
+        UnmapFile(&file);
+    }
+
+    if (success) {
+        qsort(entries, numFiles, sizeof(PackageEntry), [](const void* a, const void* b) -> int {
+            auto ha = static_cast<const PackageEntry*>(a)->pathHash;
+            auto hb = static_cast<const PackageEntry*>(b)->pathHash;
+            return ha < hb ? -1 : (ha > hb ? 1 : 0);
+        });
+        for (uint32_t i = 1; i < numFiles; ++i) {
+            if (entries[i].pathHash == entries[i - 1].pathHash) {
+                printf("%s: duplicate or colliding path %s\n", packagePath, strings.data + entries[i].pathOffset);
+                success = false;
+            }
+        }
+    }
+
+    if (success) {
+        PackageHeader header;
+        header.magic = PACKAGE_MAGIC;
+        header.version = PACKAGE_VERSION;
+        header.numEntries = numFiles;
+        header.numChunks = (uint32_t)(chunks.size / sizeof(PackageChunk));
+        header.entryOffset = sizeof(PackageHeader);
+        header.chunkOffset = header.entryOffset + sizeof(PackageEntry) * numFiles;
+        header.stringOffset = header.chunkOffset + chunks.size;
+        header.dataOffset = header.stringOffset + strings.size;
+
+        PackageBuffer out;
+        PackageBufferAppend(&out, &header, sizeof(header));
+        PackageBufferAppend(&out, entries, sizeof(PackageEntry) * numFiles);
+        PackageBufferAppend(&out, chunks.data, chunks.size);
+        PackageBufferAppend(&out, strings.data, strings.size);
+        header.tableChecksum = ComputeChecksum(out.data + header.entryOffset, header.dataOffset - header.entryOffset);
+        header.headerChecksum = ComputeChecksum(&header, offsetof(PackageHeader, headerChecksum));
+        memcpy(out.data, &header, sizeof(header));
+        PackageBufferAppend(&out, data.data, data.size);
+        success = WriteFileContents(packagePath, out.data, out.size);
+        free(out.data);
+    }
+
+    free(entries);
+    free(chunks.data);
+    free(strings.data);
+    free(data.data);
+    free(scratch);
+    return success;
+}
+
+///
+bool OpenPackage(const char* path, Package* outPackage)
+{
+    *outPackage = Package();
+    if (!MapFile(path, &outPackage->file)) {
+        return false;
+    }
+    auto& file = outPackage->file;
+    auto header = (const PackageHeader*)file.data;
+    bool valid = file.size >= sizeof(PackageHeader)
+        && header->magic == PACKAGE_MAGIC && header->version == PACKAGE_VERSION
+        && VerifyChecksum(header, offsetof(PackageHeader, headerChecksum), header->headerChecksum)
+        && header->entryOffset >= sizeof(PackageHeader)
+        && header->entryOffset + sizeof(PackageEntry) * (uint64_t)header->numEntries <= header->chunkOffset
+        && header->chunkOffset + sizeof(PackageChunk) * (uint64_t)header->numChunks <= header->stringOffset
+        && header->stringOffset <= header->dataOffset
+        && header->dataOffset <= file.size
+        && VerifyChecksum(file.data + header->entryOffset, header->dataOffset - header->entryOffset, header->tableChecksum);
+    if (!valid) {
+        printf("%s is not a valid package\n", path);
+        UnmapFile(&file);
+        return false;
+    }
+    outPackage->header = header;
+    outPackage->entries = (const PackageEntry*)(file.data + header->entryOffset);
+    outPackage->chunks = (const PackageChunk*)(file.data + header->chunkOffset);
+    outPackage->strings = file.data + header->stringOffset;
+    outPackage->chunkData = file.data + header->dataOffset;
+    return true;
+}
+
+void ClosePackage(Package* package)
+{
+    UnmapFile(&package->file);
+    *package = Package();
+}
+
+const PackageEntry* FindPackageEntry(const Package* package, const char* path)
+{
+    if (package->header == nullptr) {
+        return nullptr;
+    }
+    uint64_t hash = HashPackagePath(path);
+    uint32_t lo = 0;
+    uint32_t hi = package->header->numEntries;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (package->entries[mid].pathHash < hash) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    if (lo == package->header->numEntries || package->entries[lo].pathHash != hash) {
+        return nullptr;
+    }
+    auto entry = &package->entries[lo];
+    uint64_t stringTableSize = package->header->dataOffset - package->header->stringOffset;
+    if (entry->pathOffset >= stringTableSize
+        || !PackagePathsEqual(package->strings + entry->pathOffset, stringTableSize - entry->pathOffset, path)) {
+        return nullptr;
+    }
+    return entry;
+}
+
+// true if the chunks from the entry's first one on add up to exactly its size, which bounds it by the chunk table
+static bool PackageEntryChunksValid(const Package* package, const PackageEntry* entry)
+{
+    uint64_t size = 0;
+    for (uint32_t c = entry->firstChunk; size < entry->size; ++c) {
+        if (c >= package->header->numChunks || package->chunks[c].rawSize == 0 || package->chunks[c].rawSize > PACKAGE_CHUNK_SIZE) {
+            return false;
+        }
+        size += package->chunks[c].rawSize;
+    }
+    return size == entry->size;
+}
+
+bool ReadPackageEntry(const Package* package, const PackageEntry* entry, void* dest)
+{
+    char* out = (char*)dest;
+    uint64_t dataSize = package->file.size - package->header->dataOffset;
+    uint64_t written = 0;
+    for (uint32_t c = entry->firstChunk; written < entry->size; ++c) {
+        if (c >= package->header->numChunks) {
+            return false;
+        }
+        auto& chunk = package->chunks[c];
+        if (chunk.offset + chunk.compressedSize > dataSize || chunk.rawSize > entry->size - written) {
+            return false;
+        }
+        const char* src = package->chunkData + chunk.offset;
+        if (!VerifyChecksum(src, chunk.compressedSize, chunk.checksum)) {
+            return false;
+        }
+        if (chunk.compressedSize == chunk.rawSize) {
+            memcpy(out + written, src, chunk.rawSize);
+        }
+        else if (!LZDecompress(src, chunk.compressedSize, out + written, chunk.rawSize)) {
+            return false;
+        }
+        written += chunk.rawSize;
+    }
+    return true;
+}
+
+bool OpenPackageStream(const Package* package, const char* path, ByteStream* outStream)
+{
+    auto entry = FindPackageEntry(package, path);
+    if (entry == nullptr) {
+        return false;
+    }
+    if (!PackageEntryChunksValid(package, entry)) {
+        printf("Corrupt package entry for %s\n", path);
+        return false;
+    }
+    char* buffer = (char*)malloc(entry->size ? (size_t)entry->size : 1);
+    if (buffer == nullptr) {
+        printf("%s: out of memory unpacking %.1f MB\n", path, entry->size / (1024.0 * 1024.0));
+        return false;
+    }
+    if (!ReadPackageEntry(package, entry, buffer)) {
+        printf("Corrupt package data for %s\n", path);
+        free(buffer);
+        return false;
+    }
+    outStream->buffer = buffer;
+    outStream->bufferSize = entry->size;
+    outStream->offset = 0;
+    return true;
+}
+
+void ReleasePackageStream(ByteStream* stream)
+{
+    free((void*)stream->buffer);
+    *stream = ByteStream();
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "platform/file.h"
+#include "bytestream.h"
+
+///
+/**
+    .gtpak - asset package
+    Many asset files in a single archive. Every file is split into 64 KB chunks that are LZ compressed
+    independently (see lz.h), chunks that do not shrink are stored as is. Every chunk carries a checksum of its stored
+    bytes, verified before the chunk is decompressed (see checksum.h). The header and the tables (entries, chunks and
+    path strings) carry checksums of their own, verified by OpenPackage before any entry is looked at.
+
+    Layout: PackageHeader | PackageEntry[numEntries], sorted by pathHash | PackageChunk[numChunks] | path strings | chunk data
+*/
+#define PACKAGE_MAGIC       0x4b505447  // 'GTPK'
+#define PACKAGE_VERSION     3
+#define PACKAGE_CHUNK_SIZE  (64 * 1024)
+
+struct PackageHeader
+{
+    uint32_t    magic;
+    uint32_t    version;
+    uint32_t    numEntries;
+    uint32_t    numChunks;
+    uint64_t    entryOffset;
+    uint64_t    chunkOffset;
+    uint64_t    stringOffset;
+    uint64_t    dataOffset;
+    uint64_t    tableChecksum;      // entryOffset up to dataOffset
+    uint64_t    headerChecksum;     // of the header up to here
+};
+
+struct PackageEntry
+{
+    uint64_t    pathHash;       // HashPackagePath of the path the file was added with
+    uint32_t    pathOffset;     // into the string table, zero terminated
+    uint32_t    firstChunk;
+    uint64_t    size;           // uncompressed size
+};
+
+struct PackageChunk
+{
+    uint64_t    offset;         // relative to dataOffset
+    uint32_t    compressedSize; // == rawSize if the chunk is stored uncompressed
+    uint32_t    rawSize;
+    uint64_t    checksum;       // of the compressedSize stored bytes
+};
+
+struct Package
+{
+    FileMapping             file;
+    const PackageHeader*    header = nullptr;
+    const PackageEntry*     entries = nullptr;
+    const PackageChunk*     chunks = nullptr;
+    const char*             strings = nullptr;
+    const char*             chunkData = nullptr;
+};
+
+// case sensitive, '\' and '/' are treated as the same separator
+uint64_t HashPackagePath(const char* path);
+
+bool WritePackage(const char* packagePath, const char* const* files, uint32_t numFiles);
+
+bool OpenPackage(const char* path, Package* outPackage);
+void ClosePackage(Package* package);
+
+const PackageEntry* FindPackageEntry(const Package* package, const char* path);
+// dest must hold entry->size bytes, fails for entries whose chunks don't add up to it
+bool ReadPackageEntry(const Package* package, const PackageEntry* entry, void* dest);
+// decompresses the file into a heap block and points outStream at it, release with ReleasePackageStream
+bool OpenPackageStream(const Package* package, const char* path, ByteStream* outStream);
+void ReleasePackageStream(ByteStream* stream);
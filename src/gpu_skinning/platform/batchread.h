@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+///
+/**
+    Reads whole batches of files into buffers the caller allocated up front (size them with QueryFileInfo).
+    On Linux the reads go through io_uring, keeping up to queueDepth of them in flight, so a batch of small files
+    costs a handful of syscalls instead of one blocking read each. Where io_uring is unavailable (old kernels,
+    seccomp filters) and on Windows every file is read with blocking reads instead.
+    A BatchReader may only be used from one thread at a time.
+*/
+#define BATCH_READ_DEFAULT_QUEUE_DEPTH 64
+
+enum BatchReadFlags : uint32_t
+{
+    BATCH_READ_DEFAULT  = 0,
+    BATCH_READ_BLOCKING = 1 << 0,   // skip the async backend, e.g. to compare against it
+};
+
+struct FileRead
+{
+    const char* path        = nullptr;
+    void*       buffer      = nullptr;
+    size_t      size        = 0;        // bytes to read from the start of the file, buffer must hold them
+    size_t      bytesRead   = 0;
+    bool        success     = false;    // all size bytes arrived
+};
+
+struct BatchReader
+{
+    uint32_t    queueDepth  = 0;
+    bool        async       = false;    // reads are queued with the kernel, false if we fell back to blocking reads
+    void*       handle      = nullptr;
+};
+
+bool InitBatchReader(BatchReader* outReader, uint32_t queueDepth = BATCH_READ_DEFAULT_QUEUE_DEPTH, uint32_t flags = BATCH_READ_DEFAULT);
+void ShutdownBatchReader(BatchReader* reader);
+// returns true if every read succeeded, failed ones are reported and have success == false
+bool ReadFileBatch(BatchReader* reader, FileRead* reads, uint32_t numReads);
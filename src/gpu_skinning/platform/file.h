@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+///
+/**
+    Read-only view of a file's contents, backed by the OS page cache.
+    The pages are faulted in on first access, so there is no up-front copy and no zero fill.
+    Every successful MapFile must be paired with an UnmapFile.
+*/
+struct FileMapping
+{
+    const char* data    = nullptr;
+    size_t      size    = 0;
+    void*       handle  = nullptr;  // platform specific mapping object, nullptr for empty files
+};
+
+enum FileMappingFlags : uint32_t
+{
+    FILE_MAPPING_READ_ONLY      = 0,
+    FILE_MAPPING_COPY_ON_WRITE  = 1 << 0,   // pages are writable, writes go to private copies and never reach the file
+};
+
+struct FileInfo
+{
+    uint64_t    size            = 0;
+    uint64_t    modifiedTime    = 0;    // opaque platform timestamp, only meaningful for comparisons
+};
+
+bool MapFile(const char* path, FileMapping* outMapping, uint32_t flags = FILE_MAPPING_READ_ONLY);
+void UnmapFile(FileMapping* mapping);
+
+bool QueryFileInfo(const char* path, FileInfo* outInfo);
+// writes to a temporary file first and renames it over path, so readers never observe a partial file
+bool WriteFileContents(const char* path, const void* data, size_t size);
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+///
+/**
+    Watches a single directory (not its subdirectories) for files that were written or moved into it.
+    Writers going through WriteFileContents show up once their rename lands, never half written.
+    Only files ending in one of the watch's extensions are reported, so files nobody reloads, like bakes, don't take up
+    room in the caller's change list.
+    A FileWatch may only be waited on from one thread at a time.
+*/
+#define FILE_CHANGE_MAX_NAME 256
+
+struct FileChange
+{
+    char name[FILE_CHANGE_MAX_NAME];    // relative to the watched directory
+};
+
+struct FileWatch
+{
+    void*               handle = nullptr;
+    const char* const*  extensions = nullptr;   // of the files reported, every file is if nullptr
+    uint32_t            numExtensions = 0;
+};
+
+// extensions have to stay valid as long as the watch
+bool        StartFileWatch(const char* directory, const char* const* extensions, uint32_t numExtensions, FileWatch* outWatch);
+void        StopFileWatch(FileWatch* watch);
+// waits up to timeoutMs for changes and returns how many were written to outChanges, 0 on timeout
+// the same file can be reported more than once; when more than maxChanges files changed, or the platform lost track of
+// changes, *outOverflow is set and the caller has to assume that every watched file changed
+uint32_t    WaitForFileChanges(FileWatch* watch, uint32_t timeoutMs, FileChange* outChanges, uint32_t maxChanges, bool* outOverflow);
+
+inline bool IsWatchedFile(const FileWatch* watch, const char* name, size_t nameLen)
+{
+    if (watch->extensions == nullptr) {
+        return true;
+    }
+    for (uint32_t i = 0; i < watch->numExtensions; ++i) {
+        size_t extLen = strlen(watch->extensions[i]);
+        if (nameLen >= extLen && memcmp(name + nameLen - extLen, watch->extensions[i], extLen) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
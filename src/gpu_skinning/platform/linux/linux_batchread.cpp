@@ -0,0 +1,304 @@
+#include "../batchread.h"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdio.h>
+#include <linux/io_uring.h>
+
+///
+/**
+    io_uring without liburing: the rings are mapped by hand and driven through the raw syscalls.
+    Each queued read occupies a slot holding its file descriptor, slot indices travel as user_data.
+    Files are opened when their read is queued, so no more than queueDepth descriptors are open at once.
+*/
+struct ReadSlot
+{
+    int         fd = -1;
+    uint32_t    readIdx = 0;
+};
+
+struct Uring
+{
+    int                 fd = -1;
+    uint32_t            numEntries = 0;
+
+    uint32_t*           sqHead = nullptr;
+    uint32_t*           sqTail = nullptr;
+    uint32_t*           sqMask = nullptr;
+    uint32_t*           sqArray = nullptr;
+    io_uring_sqe*       sqes = nullptr;
+
+    uint32_t*           cqHead = nullptr;
+    uint32_t*           cqTail = nullptr;
+    uint32_t*           cqMask = nullptr;
+    io_uring_cqe*       cqes = nullptr;
+
+    void*               sqRing = nullptr;
+    size_t              sqRingSize = 0;
+    void*               cqRing = nullptr;   // same as sqRing with IORING_FEAT_SINGLE_MMAP
+    size_t              cqRingSize = 0;
+    size_t              sqesSize = 0;
+
+    ReadSlot*           slots = nullptr;
+    uint32_t*           freeSlots = nullptr;
+    uint32_t            numFreeSlots = 0;
+};
+
+static void UnmapUring(Uring* ring)
+{
+    if (ring->sqes != nullptr) { munmap(ring->sqes, ring->sqesSize); }
+    if (ring->cqRing != nullptr && ring->cqRing != ring->sqRing) { munmap(ring->cqRing, ring->cqRingSize); }
+    if (ring->sqRing != nullptr) { munmap(ring->sqRing, ring->sqRingSize); }
+    if (ring->fd != -1) { close(ring->fd); }
+}
+
+static bool SetupUring(Uring* ring, uint32_t queueDepth)
+{
+    io_uring_params params;
+    memset(&params, 0x0, sizeof(params));
+    ring->fd = (int)syscall(__NR_io_uring_setup, queueDepth, &params);
+    if (ring->fd < 0) {
+        ring->fd = -1;
+        return false;
+    }
+    ring->numEntries = params.sq_entries;
+    ring->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    ring->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMap) {
+        ring->sqRingSize = ring->cqRingSize > ring->sqRingSize ? ring->cqRingSize : ring->sqRingSize;
+        ring->cqRingSize = ring->sqRingSize;
+    }
+    void* sqRing = mmap(nullptr, ring->sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    if (sqRing == MAP_FAILED) {
+        UnmapUring(ring);
+        return false;
+    }
+    ring->sqRing = sqRing;
+    void* cqRing = sqRing;
+    if (!singleMap) {
+        cqRing = mmap(nullptr, ring->cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+        if (cqRing == MAP_FAILED) {
+            UnmapUring(ring);
+            return false;
+        }
+    }
+    ring->cqRing = cqRing;
+    ring->sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = mmap(nullptr, ring->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        UnmapUring(ring);
+        return false;
+    }
+    ring->sqes = (io_uring_sqe*)sqes;
+
+    char* sq = (char*)sqRing;
+    ring->sqHead = (uint32_t*)(sq + params.sq_off.head);
+    ring->sqTail = (uint32_t*)(sq + params.sq_off.tail);
+    ring->sqMask = (uint32_t*)(sq + params.sq_off.ring_mask);
+    ring->sqArray = (uint32_t*)(sq + params.sq_off.array);
+    char* cq = (char*)cqRing;
+    ring->cqHead = (uint32_t*)(cq + params.cq_off.head);
+    ring->cqTail = (uint32_t*)(cq + params.cq_off.tail);
+    ring->cqMask = (uint32_t*)(cq + params.cq_off.ring_mask);
+    ring->cqes = (io_uring_cqe*)(cq + params.cq_off.cqes);
+    return true;
+}
+
+bool InitBatchReader(BatchReader* outReader, uint32_t queueDepth, uint32_t flags)
+{
+    *outReader = BatchReader();
+    outReader->queueDepth = queueDepth != 0 ? queueDepth : 1;
+    if (flags & BATCH_READ_BLOCKING) {
+        return true;
+    }
+    Uring* ring = new Uring();
+    if (!SetupUring(ring, outReader->queueDepth)) {
+        printf("io_uring unavailable (%s), falling back to blocking reads\n", strerror(errno));
+        delete ring;
+        return true;
+    }
+    // the kernel may round the depth up, more slots than we asked for are of no harm
+    outReader->queueDepth = ring->numEntries;
+    ring->slots = new ReadSlot[ring->numEntries];
+    ring->freeSlots = new uint32_t[ring->numEntries];
+    for (uint32_t i = 0; i < ring->numEntries; ++i) {
+        ring->freeSlots[i] = ring->numEntries - 1 - i;
+    }
+    ring->numFreeSlots = ring->numEntries;
+    outReader->async = true;
+    outReader->handle = ring;
+    return true;
+}
+
+void ShutdownBatchReader(BatchReader* reader)
+{
+    auto ring = static_cast<Uring*>(reader->handle);
+    if (ring != nullptr) {
+        UnmapUring(ring);
+        delete[] ring->slots;
+        delete[] ring->freeSlots;
+        delete ring;
+    }
+    *reader = BatchReader();
+}
+
+static int OpenForRead(FileRead* read)
+{
+    int fd = open(read->path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        printf("Failed to open %s\n", read->path);
+    }
+    return fd;
+}
+
+// reads the rest of the file with blocking reads
+static bool ReadBlocking(int fd, FileRead* read)
+{
+    while (read->bytesRead < read->size) {
+        ssize_t res = pread(fd, (char*)read->buffer + read->bytesRead, read->size - read->bytesRead, (off_t)read->bytesRead);
+        if (res < 0 && errno == EINTR) {
+            continue;
+        }
+        if (res <= 0) {
+            printf("Failed to read %s\n", read->path);
+            return false;
+        }
+        read->bytesRead += (size_t)res;
+    }
+    return true;
+}
+
+static bool ReadFileBatchBlocking(FileRead* reads, uint32_t numReads)
+{
+    bool success = true;
+    for (uint32_t i = 0; i < numReads; ++i) {
+        auto& read = reads[i];
+        read.bytesRead = 0;
+        read.success = false;
+        int fd = OpenForRead(&read);
+        if (fd == -1) {
+            success = false;
+            continue;
+        }
+        read.success = ReadBlocking(fd, &read);
+        success &= read.success;
+        close(fd);
+    }
+    return success;
+}
+
+// queues the rest of the slot's read, the caller submits
+static void QueueRead(Uring* ring, uint32_t slotIdx, FileRead* read)
+{
+    uint32_t tail = *ring->sqTail;
+    uint32_t idx = tail & *ring->sqMask;
+    io_uring_sqe* sqe = &ring->sqes[idx];
+    memset(sqe, 0x0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = ring->slots[slotIdx].fd;
+    sqe->addr = (uint64_t)(uintptr_t)((char*)read->buffer + read->bytesRead);
+    sqe->len = (uint32_t)(read->size - read->bytesRead < 0x7ffff000 ? read->size - read->bytesRead : 0x7ffff000);   // read(2)'s cap
+    sqe->off = read->bytesRead;
+    sqe->user_data = slotIdx;
+    ring->sqArray[idx] = idx;
+    __atomic_store_n(ring->sqTail, tail + 1, __ATOMIC_RELEASE);
+}
+
+static void FinishRead(Uring* ring, uint32_t slotIdx, FileRead* read, bool success)
+{
+    read->success = success;
+    close(ring->slots[slotIdx].fd);
+    ring->slots[slotIdx].fd = -1;
+    ring->freeSlots[ring->numFreeSlots++] = slotIdx;
+}
+
+bool ReadFileBatch(BatchReader* reader, FileRead* reads, uint32_t numReads)
+{
+    auto ring = static_cast<Uring*>(reader->handle);
+    if (ring == nullptr) {
+        return ReadFileBatchBlocking(reads, numReads);
+    }
+
+    bool success = true;
+    uint32_t nextRead = 0;
+    uint32_t numQueued = 0;     // not yet handed to the kernel
+    uint32_t numInFlight = 0;   // queued or submitted, at most one per slot
+    while (nextRead < numReads || numInFlight > 0) {
+        while (nextRead < numReads && ring->numFreeSlots > 0) {
+            auto& read = reads[nextRead];
+            read.bytesRead = 0;
+            read.success = false;
+            int fd = OpenForRead(&read);
+            if (fd == -1) {
+                success = false;
+            }
+            else if (read.size == 0) {
+                read.success = true;
+                close(fd);
+            }
+            else {
+                uint32_t slotIdx = ring->freeSlots[--ring->numFreeSlots];
+                ring->slots[slotIdx].fd = fd;
+                ring->slots[slotIdx].readIdx = nextRead;
+                QueueRead(ring, slotIdx, &read);
+                numQueued++;
+                numInFlight++;
+            }
+            nextRead++;
+        }
+        if (numInFlight == 0) {
+            continue;
+        }
+
+        // submits everything queued and waits for at least one completion in the same call
+        int submitted = (int)syscall(__NR_io_uring_enter, ring->fd, numQueued, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+        if (submitted < 0) {
+            if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+                continue;
+            }
+            printf("io_uring_enter failed: %s\n", strerror(errno));
+            return false;   // the ring is in an unknown state, leave the descriptors to the process
+        }
+        numQueued -= (uint32_t)submitted;
+
+        uint32_t head = *ring->cqHead;
+        uint32_t tail = __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE);
+        for (; head != tail; ++head) {
+            io_uring_cqe* cqe = &ring->cqes[head & *ring->cqMask];
+            uint32_t slotIdx = (uint32_t)cqe->user_data;
+            auto& read = reads[ring->slots[slotIdx].readIdx];
+            int res = cqe->res;
+            if (res == -EINTR || res == -EAGAIN) {
+                QueueRead(ring, slotIdx, &read);
+                numQueued++;
+                continue;
+            }
+            numInFlight--;
+            if (res == -EINVAL) {   // kernels before 5.6 lack IORING_OP_READ
+                FinishRead(ring, slotIdx, &read, ReadBlocking(ring->slots[slotIdx].fd, &read));
+            }
+            else if (res <= 0) {    // errors, or the file is shorter than the caller said
+                printf("Failed to read %s\n", read.path);
+                FinishRead(ring, slotIdx, &read, false);
+            }
+            else {
+                read.bytesRead += (size_t)res;
+                if (read.bytesRead < read.size) {   // short read, queue the rest
+                    QueueRead(ring, slotIdx, &read);
+                    numQueued++;
+                    numInFlight++;
+                    continue;
+                }
+                FinishRead(ring, slotIdx, &read, true);
+            }
+            success &= read.success;
+        }
+        __atomic_store_n(ring->cqHead, head, __ATOMIC_RELEASE);
+    }
+    return success;
+}
@@ -0,0 +1,101 @@
+#include "../file.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+
+bool MapFile(const char* path, FileMapping* outMapping, uint32_t flags)
+{
+    *outMapping = FileMapping();
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        printf("Failed to open %s\n", path);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        printf("Failed to query size of %s\n", path);
+        close(fd);
+        return false;
+    }
+    if (st.st_size == 0) {  // mmap refuses zero length mappings
+        close(fd);
+        return true;
+    }
+
+    int protection = (flags & FILE_MAPPING_COPY_ON_WRITE) ? PROT_READ | PROT_WRITE : PROT_READ;
+    void* view = mmap(nullptr, (size_t)st.st_size, protection, MAP_PRIVATE, fd, 0);
+    close(fd);  // the mapping keeps its own reference to the file
+    if (view == MAP_FAILED) {
+        printf("Failed to map %s\n", path);
+        return false;
+    }
+    madvise(view, (size_t)st.st_size, MADV_SEQUENTIAL);   // importers parse front to back
+
+    outMapping->data = (const char*)view;
+    outMapping->size = (size_t)st.st_size;
+    outMapping->handle = view;
+    return true;
+}
+
+void UnmapFile(FileMapping* mapping)
+{
+    if (mapping->handle != nullptr) {
+        munmap(mapping->handle, mapping->size);
+    }
+    *mapping = FileMapping();
+}
+
+bool QueryFileInfo(const char* path, FileInfo* outInfo)
+{
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        return false;
+    }
+    outInfo->size = (uint64_t)st.st_size;
+    outInfo->modifiedTime = (uint64_t)st.st_mtim.tv_sec * 1000000000ull + (uint64_t)st.st_mtim.tv_nsec;
+    return true;
+}
+
+bool WriteFileContents(const char* path, const void* data, size_t size)
+{
+    // unique per writer, threads and processes writing the same path don't share the temporary file
+    char tempPath[4096];
+    if (snprintf(tempPath, sizeof(tempPath), "%s.tmp.XXXXXX", path) >= (int)sizeof(tempPath)) {
+        printf("Path too long: %s\n", path);
+        return false;
+    }
+    int fd = mkstemp(tempPath);
+    if (fd == -1) {
+        printf("Failed to create %s\n", tempPath);
+        return false;
+    }
+    fchmod(fd, 0644);   // mkstemp creates files only the owner can read
+    const char* src = (const char*)data;
+    while (size > 0) {
+        ssize_t written = write(fd, src, size);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            printf("Failed to write %s\n", tempPath);
+            close(fd);
+            unlink(tempPath);
+            return false;
+        }
+        src += written;
+        size -= (size_t)written;
+    }
+    close(fd);
+    if (rename(tempPath, path) != 0) {
+        printf("Failed to replace %s\n", path);
+        unlink(tempPath);
+        return false;
+    }
+    return true;
+}
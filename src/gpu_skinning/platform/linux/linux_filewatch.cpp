@@ -0,0 +1,81 @@
+#include "../filewatch.h"
+
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+
+// handle stores the inotify descriptor + 1, so a valid descriptor 0 doesn't read as nullptr
+static int WatchFd(FileWatch* watch)
+{
+    return (int)(intptr_t)watch->handle - 1;
+}
+
+bool StartFileWatch(const char* directory, const char* const* extensions, uint32_t numExtensions, FileWatch* outWatch)
+{
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd == -1) {
+        printf("Failed to create file watch: %s\n", strerror(errno));
+        return false;
+    }
+    // close_write catches files rewritten in place, moved_to the ones renamed over
+    if (inotify_add_watch(fd, directory, IN_CLOSE_WRITE | IN_MOVED_TO) == -1) {
+        printf("Failed to watch %s: %s\n", directory, strerror(errno));
+        close(fd);
+        return false;
+    }
+    outWatch->handle = (void*)(intptr_t)(fd + 1);
+    outWatch->extensions = extensions;
+    outWatch->numExtensions = numExtensions;
+    return true;
+}
+
+void StopFileWatch(FileWatch* watch)
+{
+    if (watch->handle != nullptr) {
+        close(WatchFd(watch));
+    }
+    watch->handle = nullptr;
+}
+
+uint32_t WaitForFileChanges(FileWatch* watch, uint32_t timeoutMs, FileChange* outChanges, uint32_t maxChanges, bool* outOverflow)
+{
+    pollfd pfd;
+    pfd.fd = WatchFd(watch);
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    if (poll(&pfd, 1, (int)timeoutMs) <= 0) {
+        return 0;
+    }
+
+    uint32_t numChanges = 0;
+    alignas(inotify_event) char buffer[4096];
+    for (;;) {
+        ssize_t bytesRead = read(pfd.fd, buffer, sizeof(buffer));
+        if (bytesRead <= 0) {   // EAGAIN once the queue is drained
+            break;
+        }
+        for (ssize_t offset = 0; offset < bytesRead;) {
+            auto event = (const inotify_event*)(buffer + offset);
+            offset += sizeof(inotify_event) + event->len;
+            if (event->mask & IN_Q_OVERFLOW) {  // the kernel's queue filled up and dropped events
+                *outOverflow = true;
+                continue;
+            }
+            if (event->len == 0 || (event->mask & IN_ISDIR) || !IsWatchedFile(watch, event->name, strlen(event->name))) {
+                continue;
+            }
+            if (numChanges == maxChanges) {
+                *outOverflow = true;
+                continue;
+            }
+            auto& change = outChanges[numChanges++];
+            strncpy(change.name, event->name, FILE_CHANGE_MAX_NAME - 1);
+            change.name[FILE_CHANGE_MAX_NAME - 1] = '\0';
+        }
+    }
+    return numChanges;
+}
@@ -0,0 +1,20 @@
+#include "../memory.h"
+
+#include <stdlib.h>
+
+void* AllocateAligned(size_t size, size_t alignment)
+{
+    void* block = nullptr;
+    if (alignment < sizeof(void*)) {
+        alignment = sizeof(void*);
+    }
+    if (posix_memalign(&block, alignment, size) != 0) {
+        return nullptr;
+    }
+    return block;
+}
+
+void FreeAligned(void* block)
+{
+    free(block);
+}
@@ -0,0 +1,102 @@
+#include "../thread.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <stdlib.h>
+
+static_assert(sizeof(pthread_mutex_t) <= sizeof(Mutex::storage), "Mutex storage too small");
+static_assert(sizeof(pthread_cond_t) <= sizeof(ConditionVariable::storage), "ConditionVariable storage too small");
+
+struct ThreadStart
+{
+    ThreadProc  proc;
+    void*       userData;
+};
+
+static void* ThreadTrampoline(void* param)
+{
+    ThreadStart start = *(ThreadStart*)param;
+    free(param);
+    start.proc(start.userData);
+    return nullptr;
+}
+
+bool StartThread(Thread* outThread, ThreadProc proc, void* userData)
+{
+    auto start = (ThreadStart*)malloc(sizeof(ThreadStart));
+    start->proc = proc;
+    start->userData = userData;
+    auto handle = (pthread_t*)malloc(sizeof(pthread_t));
+    if (pthread_create(handle, nullptr, ThreadTrampoline, start) != 0) {
+        free(start);
+        free(handle);
+        return false;
+    }
+    outThread->handle = handle;
+    return true;
+}
+
+void JoinThread(Thread* thread)
+{
+    if (thread->handle == nullptr) { return; }
+    pthread_join(*(pthread_t*)thread->handle, nullptr);
+    free(thread->handle);
+    thread->handle = nullptr;
+}
+
+void YieldThread()
+{
+    sched_yield();
+}
+
+uint32_t GetNumHardwareThreads()
+{
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (uint32_t)count : 1;
+}
+
+void InitMutex(Mutex* mutex)
+{
+    pthread_mutex_init((pthread_mutex_t*)mutex->storage, nullptr);
+}
+
+void DestroyMutex(Mutex* mutex)
+{
+    pthread_mutex_destroy((pthread_mutex_t*)mutex->storage);
+}
+
+void LockMutex(Mutex* mutex)
+{
+    pthread_mutex_lock((pthread_mutex_t*)mutex->storage);
+}
+
+void UnlockMutex(Mutex* mutex)
+{
+    pthread_mutex_unlock((pthread_mutex_t*)mutex->storage);
+}
+
+void InitCondition(ConditionVariable* cv)
+{
+    pthread_cond_init((pthread_cond_t*)cv->storage, nullptr);
+}
+
+void DestroyCondition(ConditionVariable* cv)
+{
+    pthread_cond_destroy((pthread_cond_t*)cv->storage);
+}
+
+void WaitCondition(ConditionVariable* cv, Mutex* mutex)
+{
+    pthread_cond_wait((pthread_cond_t*)cv->storage, (pthread_mutex_t*)mutex->storage);
+}
+
+void SignalCondition(ConditionVariable* cv)
+{
+    pthread_cond_signal((pthread_cond_t*)cv->storage);
+}
+
+void BroadcastCondition(ConditionVariable* cv)
+{
+    pthread_cond_broadcast((pthread_cond_t*)cv->storage);
+}
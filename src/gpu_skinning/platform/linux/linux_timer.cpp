@@ -0,0 +1,15 @@
+#include "../timer.h"
+
+#include <time.h>
+
+uint64_t GetTicks()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+double TicksToSeconds(uint64_t ticks)
+{
+    return (double)ticks * 1e-9;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <stddef.h>
+
+///
+/**
+    Aligned heap blocks, alignment has to be a power of two.
+*/
+void*   AllocateAligned(size_t size, size_t alignment);
+void    FreeAligned(void* block);
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdint.h>
+
+///
+/**
+    Minimal threading primitives. Mutex and ConditionVariable wrap the native objects in opaque storage,
+    they must not be copied or moved once initialized.
+*/
+typedef void (*ThreadProc)(void* userData);
+
+struct Thread
+{
+    void* handle = nullptr;
+};
+
+bool        StartThread(Thread* outThread, ThreadProc proc, void* userData);
+void        JoinThread(Thread* thread);
+void        YieldThread();
+uint32_t    GetNumHardwareThreads();
+
+struct Mutex
+{
+    alignas(16) uint64_t storage[8];
+};
+
+void InitMutex(Mutex* mutex);
+void DestroyMutex(Mutex* mutex);
+void LockMutex(Mutex* mutex);
+void UnlockMutex(Mutex* mutex);
+
+struct ConditionVariable
+{
+    alignas(16) uint64_t storage[8];
+};
+
+void InitCondition(ConditionVariable* cv);
+void DestroyCondition(ConditionVariable* cv);
+// mutex must be locked by the caller, it is released while waiting; spurious wakeups are possible
+void WaitCondition(ConditionVariable* cv, Mutex* mutex);
+void SignalCondition(ConditionVariable* cv);
+void BroadcastCondition(ConditionVariable* cv);
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <stdint.h>
+
+///
+/**
+    High resolution monotonic clock for profiling loads.
+*/
+uint64_t GetTicks();
+double TicksToSeconds(uint64_t ticks);
@@ -0,0 +1,52 @@
+#include "../batchread.h"
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#include <stdio.h>
+
+// no async backend on Windows yet, batches are read file by file
+bool InitBatchReader(BatchReader* outReader, uint32_t queueDepth, uint32_t flags)
+{
+    *outReader = BatchReader();
+    outReader->queueDepth = queueDepth != 0 ? queueDepth : 1;
+    return true;
+}
+
+void ShutdownBatchReader(BatchReader* reader)
+{
+    *reader = BatchReader();
+}
+
+static bool ReadWholeFile(FileRead* read)
+{
+    HANDLE file = CreateFileA(read->path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        printf("Failed to open %s\n", read->path);
+        return false;
+    }
+    while (read->bytesRead < read->size) {
+        size_t remaining = read->size - read->bytesRead;
+        DWORD chunk = remaining > 0x40000000 ? 0x40000000 : (DWORD)remaining;
+        DWORD bytesRead = 0;
+        if (!ReadFile(file, (char*)read->buffer + read->bytesRead, chunk, &bytesRead, NULL) || bytesRead == 0) {
+            printf("Failed to read %s\n", read->path);
+            CloseHandle(file);
+            return false;
+        }
+        read->bytesRead += bytesRead;
+    }
+    CloseHandle(file);
+    return true;
+}
+
+bool ReadFileBatch(BatchReader* reader, FileRead* reads, uint32_t numReads)
+{
+    bool success = true;
+    for (uint32_t i = 0; i < numReads; ++i) {
+        reads[i].bytesRead = 0;
+        reads[i].success = ReadWholeFile(&reads[i]);
+        success &= reads[i].success;
+    }
+    return success;
+}
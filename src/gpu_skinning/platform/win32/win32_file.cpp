@@ -0,0 +1,103 @@
+#include "../file.h"
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#include <stdio.h>
+
+bool MapFile(const char* path, FileMapping* outMapping, uint32_t flags)
+{
+    *outMapping = FileMapping();
+
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        printf("Failed to open %s\n", path);
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        printf("Failed to query size of %s\n", path);
+        CloseHandle(file);
+        return false;
+    }
+    if (size.QuadPart == 0) {   // CreateFileMapping refuses empty files
+        CloseHandle(file);
+        return true;
+    }
+
+    bool copyOnWrite = (flags & FILE_MAPPING_COPY_ON_WRITE) != 0;
+    HANDLE mapping = CreateFileMappingA(file, nullptr, copyOnWrite ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);  // the mapping object keeps its own reference to the file
+    if (mapping == NULL) {
+        printf("Failed to create file mapping for %s\n", path);
+        return false;
+    }
+    void* view = MapViewOfFile(mapping, copyOnWrite ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr) {
+        printf("Failed to map view of %s\n", path);
+        CloseHandle(mapping);
+        return false;
+    }
+
+    outMapping->data = (const char*)view;
+    outMapping->size = (size_t)size.QuadPart;
+    outMapping->handle = mapping;
+    return true;
+}
+
+void UnmapFile(FileMapping* mapping)
+{
+    if (mapping->data != nullptr) {
+        UnmapViewOfFile(mapping->data);
+    }
+    if (mapping->handle != nullptr) {
+        CloseHandle((HANDLE)mapping->handle);
+    }
+    *mapping = FileMapping();
+}
+
+bool QueryFileInfo(const char* path, FileInfo* outInfo)
+{
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExA(path, GetFileExInfoStandard, &data)) {
+        return false;
+    }
+    outInfo->size = ((uint64_t)data.nFileSizeHigh << 32) | (uint64_t)data.nFileSizeLow;
+    outInfo->modifiedTime = ((uint64_t)data.ftLastWriteTime.dwHighDateTime << 32) | (uint64_t)data.ftLastWriteTime.dwLowDateTime;
+    return true;
+}
+
+bool WriteFileContents(const char* path, const void* data, size_t size)
+{
+    // unique per writer, threads and processes writing the same path don't share the temporary file
+    char tempPath[MAX_PATH];
+    if (snprintf(tempPath, sizeof(tempPath), "%s.%lu.%lu.tmp", path, GetCurrentProcessId(), GetCurrentThreadId()) >= (int)sizeof(tempPath)) {
+        printf("Path too long: %s\n", path);
+        return false;
+    }
+    HANDLE file = CreateFileA(tempPath, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        printf("Failed to create %s\n", tempPath);
+        return false;
+    }
+    const char* src = (const char*)data;
+    while (size > 0) {
+        DWORD chunk = size > 0x40000000 ? 0x40000000 : (DWORD)size;
+        DWORD bytesWritten = 0;
+        if (!WriteFile(file, src, chunk, &bytesWritten, NULL) || bytesWritten != chunk) {
+            printf("Failed to write %s\n", tempPath);
+            CloseHandle(file);
+            DeleteFileA(tempPath);
+            return false;
+        }
+        src += chunk;
+        size -= chunk;
+    }
+    CloseHandle(file);
+    if (!MoveFileExA(tempPath, path, MOVEFILE_REPLACE_EXISTING)) {
+        printf("Failed to replace %s\n", path);
+        DeleteFileA(tempPath);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,102 @@
+#include "../filewatch.h"
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#include <stdio.h>
+
+struct Win32FileWatch
+{
+    HANDLE      directory;
+    OVERLAPPED  overlapped;
+    DWORD       buffer[4096];   // ReadDirectoryChangesW wants DWORD alignment
+};
+
+static bool IssueRead(Win32FileWatch* watch)
+{
+    HANDLE event = watch->overlapped.hEvent;
+    ZeroMemory(&watch->overlapped, sizeof(OVERLAPPED));
+    watch->overlapped.hEvent = event;
+    DWORD filter = FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME;
+    return ReadDirectoryChangesW(watch->directory, watch->buffer, sizeof(watch->buffer), FALSE, filter, nullptr, &watch->overlapped, nullptr) != 0;
+}
+
+bool StartFileWatch(const char* directory, const char* const* extensions, uint32_t numExtensions, FileWatch* outWatch)
+{
+    HANDLE dir = CreateFileA(directory, FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+        OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+    if (dir == INVALID_HANDLE_VALUE) {
+        printf("Failed to watch %s\n", directory);
+        return false;
+    }
+    auto watch = new Win32FileWatch;
+    watch->directory = dir;
+    watch->overlapped.hEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+    if (watch->overlapped.hEvent == NULL || !IssueRead(watch)) {
+        printf("Failed to watch %s\n", directory);
+        if (watch->overlapped.hEvent != NULL) { CloseHandle(watch->overlapped.hEvent); }
+        CloseHandle(dir);
+        delete watch;
+        return false;
+    }
+    outWatch->handle = watch;
+    outWatch->extensions = extensions;
+    outWatch->numExtensions = numExtensions;
+    return true;
+}
+
+void StopFileWatch(FileWatch* watch)
+{
+    auto w = (Win32FileWatch*)watch->handle;
+    if (w != nullptr) {
+        DWORD bytes;
+        CancelIo(w->directory);
+        GetOverlappedResult(w->directory, &w->overlapped, &bytes, TRUE);  // the buffer must outlive the cancelled read
+        CloseHandle(w->overlapped.hEvent);
+        CloseHandle(w->directory);
+        delete w;
+    }
+    watch->handle = nullptr;
+}
+
+uint32_t WaitForFileChanges(FileWatch* watch, uint32_t timeoutMs, FileChange* outChanges, uint32_t maxChanges, bool* outOverflow)
+{
+    auto w = (Win32FileWatch*)watch->handle;
+    if (WaitForSingleObject(w->overlapped.hEvent, timeoutMs) != WAIT_OBJECT_0) {
+        return 0;
+    }
+    DWORD bytes = 0;
+    if (!GetOverlappedResult(w->directory, &w->overlapped, &bytes, FALSE)) {
+        IssueRead(w);
+        return 0;
+    }
+
+    uint32_t numChanges = 0;
+    if (bytes == 0) {   // the buffer overflowed and the changes were lost
+        *outOverflow = true;
+    }
+    const char* cursor = (const char*)w->buffer;
+    while (bytes != 0) {
+        auto info = (const FILE_NOTIFY_INFORMATION*)cursor;
+        bool written = info->Action == FILE_ACTION_ADDED || info->Action == FILE_ACTION_MODIFIED || info->Action == FILE_ACTION_RENAMED_NEW_NAME;
+        char name[FILE_CHANGE_MAX_NAME];
+        int len = written ? WideCharToMultiByte(CP_UTF8, 0, info->FileName, (int)(info->FileNameLength / sizeof(WCHAR)),
+            name, FILE_CHANGE_MAX_NAME - 1, nullptr, nullptr) : 0;
+        if (len > 0 && IsWatchedFile(watch, name, (size_t)len)) {
+            if (numChanges < maxChanges) {
+                memcpy(outChanges[numChanges].name, name, (size_t)len);
+                outChanges[numChanges].name[len] = '\0';
+                numChanges++;
+            }
+            else {
+                *outOverflow = true;
+            }
+        }
+        if (info->NextEntryOffset == 0) {
+            break;
+        }
+        cursor += info->NextEntryOffset;
+    }
+    IssueRead(w);
+    return numChanges;
+}
@@ -0,0 +1,13 @@
+#include "../memory.h"
+
+#include <malloc.h>
+
+void* AllocateAligned(size_t size, size_t alignment)
+{
+    return _aligned_malloc(size, alignment);
+}
+
+void FreeAligned(void* block)
+{
+    _aligned_free(block);
+}
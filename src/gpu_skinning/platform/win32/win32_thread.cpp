@@ -0,0 +1,100 @@
+#include "../thread.h"
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#include <stdlib.h>
+
+static_assert(sizeof(SRWLOCK) <= sizeof(Mutex::storage), "Mutex storage too small");
+static_assert(sizeof(CONDITION_VARIABLE) <= sizeof(ConditionVariable::storage), "ConditionVariable storage too small");
+
+struct ThreadStart
+{
+    ThreadProc  proc;
+    void*       userData;
+};
+
+static DWORD WINAPI ThreadTrampoline(LPVOID param)
+{
+    ThreadStart start = *(ThreadStart*)param;
+    free(param);
+    start.proc(start.userData);
+    return 0;
+}
+
+bool StartThread(Thread* outThread, ThreadProc proc, void* userData)
+{
+    auto start = (ThreadStart*)malloc(sizeof(ThreadStart));
+    start->proc = proc;
+    start->userData = userData;
+    HANDLE handle = CreateThread(nullptr, 0, ThreadTrampoline, start, 0, nullptr);
+    if (handle == NULL) {
+        free(start);
+        return false;
+    }
+    outThread->handle = handle;
+    return true;
+}
+
+void JoinThread(Thread* thread)
+{
+    if (thread->handle == nullptr) { return; }
+    WaitForSingleObject((HANDLE)thread->handle, INFINITE);
+    CloseHandle((HANDLE)thread->handle);
+    thread->handle = nullptr;
+}
+
+void YieldThread()
+{
+    SwitchToThread();
+}
+
+uint32_t GetNumHardwareThreads()
+{
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (uint32_t)info.dwNumberOfProcessors;
+}
+
+void InitMutex(Mutex* mutex)
+{
+    InitializeSRWLock((SRWLOCK*)mutex->storage);
+}
+
+void DestroyMutex(Mutex* mutex)
+{
+}
+
+void LockMutex(Mutex* mutex)
+{
+    AcquireSRWLockExclusive((SRWLOCK*)mutex->storage);
+}
+
+void UnlockMutex(Mutex* mutex)
+{
+    ReleaseSRWLockExclusive((SRWLOCK*)mutex->storage);
+}
+
+void InitCondition(ConditionVariable* cv)
+{
+    InitializeConditionVariable((CONDITION_VARIABLE*)cv->storage);
+}
+
+void DestroyCondition(ConditionVariable* cv)
+{
+}
+
+void WaitCondition(ConditionVariable* cv, Mutex* mutex)
+{
+    SleepConditionVariableSRW((CONDITION_VARIABLE*)cv->storage, (SRWLOCK*)mutex->storage, INFINITE, 0);
+}
+
+void SignalCondition(ConditionVariable* cv)
+{
+    WakeConditionVariable((CONDITION_VARIABLE*)cv->storage);
+}
+
+void BroadcastCondition(ConditionVariable* cv)
+{
+    WakeAllConditionVariable((CONDITION_VARIABLE*)cv->storage);
+}
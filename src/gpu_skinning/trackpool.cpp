@@ -0,0 +1,212 @@
+#include "trackpool.h"
+#include <assert.h>
+#include <string.h>
+#include "hash.h"
+
+///
+// the slot holding the array, or the free slot it goes into
+static uint32_t FindArraySlot(const TrackPool* pool, uint64_t hash, const void* data, size_t size)
+{
+    uint32_t mask = pool->capacity - 1;
+    for (uint32_t slot = (uint32_t)hash & mask;; slot = (slot + 1) & mask) {
+        auto& entry = pool->slots[slot];
+        if (entry.data == nullptr || (entry.hash == hash && entry.size == size && memcmp(entry.data, data, size) == 0)) {
+            return slot;
+        }
+    }
+}
+
+static void GrowTrackPool(TrackPool* pool)
+{
+    auto slots = pool->slots;
+    uint32_t capacity = pool->capacity;
+    pool->capacity = capacity != 0 ? capacity * 2 : TRACK_POOL_MIN_CAPACITY;
+    pool->slots = new SharedArray[pool->capacity];
+    for (uint32_t i = 0; i < capacity; ++i) {
+        if (slots[i].data != nullptr) {
+            pool->slots[FindArraySlot(pool, slots[i].hash, slots[i].data, slots[i].size)] = slots[i];
+        }
+    }
+    delete[] slots;
+}
+
+// shifts the entries probing past the slot back, so lookups never stop at the hole
+static void RemoveArraySlot(TrackPool* pool, uint32_t slot)
+{
+    uint32_t mask = pool->capacity - 1;
+    pool->slots[slot] = SharedArray();
+    for (uint32_t next = (slot + 1) & mask; pool->slots[next].data != nullptr; next = (next + 1) & mask) {
+        uint32_t home = (uint32_t)pool->slots[next].hash & mask;
+        bool reachable = slot <= next ? (slot < home && home <= next) : (slot < home || home <= next);
+        if (!reachable) {
+            pool->slots[slot] = pool->slots[next];
+            pool->slots[next] = SharedArray();
+            slot = next;
+        }
+    }
+}
+
+///
+void InitTrackPool(TrackPool* pool)
+{
+    InitMutex(&pool->mutex);
+}
+
+void ShutdownTrackPool(TrackPool* pool)
+{
+    assert(pool->numArrays == 0);
+    delete[] pool->slots;
+    pool->slots = nullptr;
+    pool->capacity = 0;
+    DestroyMutex(&pool->mutex);
+}
+
+void* ShareArray(TrackPool* pool, const void* data, size_t size)
+{
+    uint64_t hash = HashXXH64(data, size);
+    LockMutex(&pool->mutex);
+    if ((pool->numArrays + 1) * 2 > pool->capacity) {
+        GrowTrackPool(pool);
+    }
+    auto& entry = pool->slots[FindArraySlot(pool, hash, data, size)];
+    if (entry.data == nullptr) {
+        entry.hash = hash;
+        entry.data = new char[size];    // new[] aligns for any scalar, floats and keyframes alike
+        entry.size = size;
+        memcpy(entry.data, data, size);
+        pool->numArrays++;
+        pool->storedBytes += size;
+    }
+    entry.refCount++;
+    pool->referencedBytes += size;
+    auto shared = entry.data;
+    UnlockMutex(&pool->mutex);
+    return shared;
+}
+
+void ReleaseSharedArray(TrackPool* pool, void* data, size_t size)
+{
+    uint64_t hash = HashXXH64(data, size);
+    LockMutex(&pool->mutex);
+    uint32_t slot = FindArraySlot(pool, hash, data, size);
+    auto& entry = pool->slots[slot];
+    assert(entry.data == data && entry.refCount > 0);
+    pool->referencedBytes -= size;
+    if (--entry.refCount == 0) {
+        delete[] entry.data;
+        RemoveArraySlot(pool, slot);
+        pool->numArrays--;
+        pool->storedBytes -= size;
+    }
+    UnlockMutex(&pool->mutex);
+}
+
+void ShareClipTracks(TrackPool* pool, AnimationClip* clip)
+{
+    for (uint32_t i = 0; i < MAX_NUM_BONES; ++i) {
+        auto& track = clip->tracks[i];
+        if (track.numKeyframes != 0) {
+            track.times = static_cast<float*>(ShareArray(pool, track.times, sizeof(float) * track.numKeyframes));
+            track.keyframes = static_cast<Keyframe*>(ShareArray(pool, track.keyframes, sizeof(Keyframe) * track.numKeyframes));
+        }
+    }
+}
+
+// copies the name of a clip whose tracks were shared into an arena of its own and frees the rest of the clip's storage
+static void KeepOnlyClipName(char** name, Arena* arena, FileMapping* bakedFile)
+{
+    Arena names;
+    size_t nameSize = strlen(*name) + 1;
+    ArenaMeasure(&names, nameSize, 1);
+    if (!ArenaCommit(&names)) {
+        return;     // keeps the clip's own storage for its name
+    }
+    auto copy = ArenaAllocArray<char>(&names, nameSize);
+    memcpy(copy, *name, nameSize);
+    if (bakedFile != nullptr && bakedFile->data != nullptr) {
+        UnmapFile(bakedFile);
+    }
+    ArenaRelease(arena);
+    *name = copy;
+    *arena = names;
+}
+
+void MoveClipToTrackPool(TrackPool* pool, AnimationClip* clip, FileMapping* bakedFile)
+{
+    ShareClipTracks(pool, clip);
+    KeepOnlyClipName(&clip->name, &clip->arena, bakedFile);
+}
+
+void ReleaseClipTracks(TrackPool* pool, AnimationClip* clip)
+{
+    for (uint32_t i = 0; i < MAX_NUM_BONES; ++i) {
+        auto& track = clip->tracks[i];
+        if (track.numKeyframes != 0) {
+            ReleaseSharedArray(pool, track.times, sizeof(float) * track.numKeyframes);
+            ReleaseSharedArray(pool, track.keyframes, sizeof(Keyframe) * track.numKeyframes);
+            track.times = nullptr;
+            track.keyframes = nullptr;
+        }
+    }
+}
+
+size_t GetClipTrackBytes(const AnimationClip* clip)
+{
+    size_t bytes = 0;
+    for (uint32_t i = 0; i < MAX_NUM_BONES; ++i) {
+        uint32_t numKeyframes = clip->tracks[i].numKeyframes;
+        bytes += sizeof(Keyframe) * numKeyframes + (numKeyframes != 0 && FindSharedTimes(clip, i) == i ? sizeof(float) * numKeyframes : 0);
+    }
+    return bytes;
+}
+
+///
+static size_t GetCompressedSegmentCount(const CompressedTrack& track)
+{
+    return (track.numKeyframes + COMPRESSED_SEGMENT_KEYS - 1) / COMPRESSED_SEGMENT_KEYS;
+}
+
+void ShareCompressedClipTracks(TrackPool* pool, CompressedClip* clip)
+{
+    for (uint32_t i = 0; i < MAX_NUM_BONES; ++i) {
+        auto& track = clip->tracks[i];
+        if (track.numKeyframes != 0) {
+            track.frames = static_cast<uint16_t*>(ShareArray(pool, track.frames, sizeof(uint16_t) * track.numKeyframes));
+            track.segments = static_cast<CompressedSegment*>(ShareArray(pool, track.segments, sizeof(CompressedSegment) * GetCompressedSegmentCount(track)));
+            track.bits = static_cast<uint32_t*>(ShareArray(pool, track.bits, sizeof(uint32_t) * track.numBitWords));
+        }
+    }
+}
+
+void MoveCompressedClipToTrackPool(TrackPool* pool, CompressedClip* clip, FileMapping* bakedFile)
+{
+    ShareCompressedClipTracks(pool, clip);
+    KeepOnlyClipName(&clip->name, &clip->arena, bakedFile);
+}
+
+void ReleaseCompressedClipTracks(TrackPool* pool, CompressedClip* clip)
+{
+    for (uint32_t i = 0; i < MAX_NUM_BONES; ++i) {
+        auto& track = clip->tracks[i];
+        if (track.numKeyframes != 0) {
+            ReleaseSharedArray(pool, track.frames, sizeof(uint16_t) * track.numKeyframes);
+            ReleaseSharedArray(pool, track.segments, sizeof(CompressedSegment) * GetCompressedSegmentCount(track));
+            ReleaseSharedArray(pool, track.bits, sizeof(uint32_t) * track.numBitWords);
+            track.frames = nullptr;
+            track.segments = nullptr;
+            track.bits = nullptr;
+        }
+    }
+}
+
+size_t GetCompressedClipTrackBytes(const CompressedClip* clip)
+{
+    size_t bytes = 0;
+    for (uint32_t i = 0; i < MAX_NUM_BONES; ++i) {
+        auto& track = clip->tracks[i];
+        if (track.numKeyframes != 0) {
+            bytes += sizeof(uint16_t) * track.numKeyframes + sizeof(CompressedSegment) * GetCompressedSegmentCount(track) + sizeof(uint32_t) * track.numBitWords;
+        }
+    }
+    return bytes;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "assets.h"
+#include "clipcompression.h"
+#include "platform/file.h"
+#include "platform/thread.h"
+
+///
+/**
+    Shared tracks
+    A TrackPool stores every distinct keyframe and times array once and counts the tracks referencing it. Arrays are
+    found by a hash of their bytes and confirmed byte for byte, so only exact repeats are shared: the times of all
+    clips exported at the same frame rate and length, a curve a rig's clips have in common, a clip shipped once per
+    prop, or the same clip cooked for two rigs with the same joint layout.
+    Compressed clips share their frame indices, segments and bit streams the same way, frame indices repeat wherever
+    clips are keyed alike, and a clip compressed for two rigs with the same joint layout shares all of them.
+    The pool is locked, loads on the job pool share their tracks while the main thread releases others.
+*/
+#define TRACK_POOL_MIN_CAPACITY 256     // slots, power of two, the table stays at most half full
+
+struct SharedArray
+{
+    uint64_t    hash = 0;
+    char*       data = nullptr;         // nullptr marks a free slot
+    size_t      size = 0;
+    uint32_t    refCount = 0;
+};
+
+struct TrackPool
+{
+    Mutex           mutex;
+    SharedArray*    slots = nullptr;    // open addressed by hash
+    uint32_t        capacity = 0;
+    uint32_t        numArrays = 0;
+    size_t          storedBytes = 0;        // held by the pool
+    size_t          referencedBytes = 0;    // of every reference, storedBytes if nothing is shared
+};
+
+void        InitTrackPool(TrackPool* pool);
+// every shared track must have been released
+void        ShutdownTrackPool(TrackPool* pool);
+
+// returns the pool's copy of the size bytes at data, adding one if there is none yet, and references it
+void*       ShareArray(TrackPool* pool, const void* data, size_t size);
+// data as returned by ShareArray
+void        ReleaseSharedArray(TrackPool* pool, void* data, size_t size);
+
+// points the clip's tracks at the pool's copies, the clip's own times and keyframes aren't referenced afterwards
+void        ShareClipTracks(TrackPool* pool, AnimationClip* clip);
+// shares the clip's tracks and frees its own storage, bakedFile if it was loaded baked and its arena otherwise;
+// the clip's arena only holds its name from then on
+void        MoveClipToTrackPool(TrackPool* pool, AnimationClip* clip, FileMapping* bakedFile);
+void        ReleaseClipTracks(TrackPool* pool, AnimationClip* clip);
+// bytes of times and keyframes the clip references, shared or not, times shared within the clip count once
+size_t      GetClipTrackBytes(const AnimationClip* clip);
+
+// the same for compressed clips, their frames, segments and bits are shared
+void        ShareCompressedClipTracks(TrackPool* pool, CompressedClip* clip);
+void        MoveCompressedClipToTrackPool(TrackPool* pool, CompressedClip* clip, FileMapping* bakedFile);
+void        ReleaseCompressedClipTracks(TrackPool* pool, CompressedClip* clip);
+size_t      GetCompressedClipTrackBytes(const CompressedClip* clip);
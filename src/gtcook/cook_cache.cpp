@@ -0,0 +1,119 @@
+#include "cook_cache.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "gpu_skinning/hash.h"
+#include "gpu_skinning/platform/file.h"
+
+uint64_t HashCookPath(const char* path)
+{
+    uint64_t hash = HashFNV1a64(nullptr, 0);
+    for (const char* c = path; *c != '\0'; ++c) {
+        char ch = *c == '\\' ? '/' : *c;
+        hash = HashFNV1a64(&ch, 1, hash);
+    }
+    return hash;
+}
+
+// index of the first entry with entry.pathHash >= pathHash
+static uint32_t LowerBound(CookCache* cache, uint64_t pathHash)
+{
+    uint32_t first = 0;
+    uint32_t count = cache->numEntries;
+    while (count > 0) {
+        uint32_t step = count / 2;
+        if (cache->entries[first + step].pathHash < pathHash) {
+            first += step + 1;
+            count -= step + 1;
+        }
+        else {
+            count = step;
+        }
+    }
+    return first;
+}
+
+static void ReserveEntries(CookCache* cache, uint32_t numEntries)
+{
+    if (numEntries <= cache->capacity) { return; }
+    uint32_t capacity = cache->capacity ? cache->capacity : 64;
+    while (capacity < numEntries) { capacity *= 2; }
+    cache->entries = (CookCacheEntry*)realloc(cache->entries, sizeof(CookCacheEntry) * capacity);
+    cache->capacity = capacity;
+}
+
+bool LoadCookCache(const char* path, CookCache* outCache)
+{
+    *outCache = CookCache();
+    FileInfo info;
+    if (!QueryFileInfo(path, &info)) {
+        return true;
+    }
+    FileMapping file;
+    if (!MapFile(path, &file)) {
+        return false;
+    }
+    CookCacheHeader header;
+    bool valid = file.size >= sizeof(header);
+    if (valid) {
+        memcpy(&header, file.data, sizeof(header));
+        valid = header.magic == COOK_CACHE_MAGIC && header.version == COOK_CACHE_VERSION
+            && header.numEntries == (file.size - sizeof(header)) / sizeof(CookCacheEntry);
+    }
+    if (!valid) {
+        printf("%s is not a cook cache\n", path);
+        UnmapFile(&file);
+        return false;
+    }
+    ReserveEntries(outCache, (uint32_t)header.numEntries);
+    memcpy(outCache->entries, file.data + sizeof(header), sizeof(CookCacheEntry) * header.numEntries);
+    outCache->numEntries = (uint32_t)header.numEntries;
+    UnmapFile(&file);
+    return true;
+}
+
+bool StoreCookCache(const char* path, CookCache* cache)
+{
+    CookCacheHeader header;
+    header.magic = COOK_CACHE_MAGIC;
+    header.version = COOK_CACHE_VERSION;
+    header.numEntries = cache->numEntries;
+    size_t size = sizeof(header) + sizeof(CookCacheEntry) * cache->numEntries;
+    char* data = (char*)malloc(size);
+    memcpy(data, &header, sizeof(header));
+    if (cache->numEntries != 0) {
+        memcpy(data + sizeof(header), cache->entries, sizeof(CookCacheEntry) * cache->numEntries);
+    }
+    bool res = WriteFileContents(path, data, size);
+    free(data);
+    return res;
+}
+
+void ReleaseCookCache(CookCache* cache)
+{
+    free(cache->entries);
+    *cache = CookCache();
+}
+
+bool FindCookKey(CookCache* cache, uint64_t pathHash, uint64_t* outKey)
+{
+    uint32_t idx = LowerBound(cache, pathHash);
+    if (idx == cache->numEntries || cache->entries[idx].pathHash != pathHash) {
+        return false;
+    }
+    *outKey = cache->entries[idx].key;
+    return true;
+}
+
+void SetCookKey(CookCache* cache, uint64_t pathHash, uint64_t key)
+{
+    uint32_t idx = LowerBound(cache, pathHash);
+    if (idx == cache->numEntries || cache->entries[idx].pathHash != pathHash) {
+        ReserveEntries(cache, cache->numEntries + 1);
+        memmove(cache->entries + idx + 1, cache->entries + idx, sizeof(CookCacheEntry) * (cache->numEntries - idx));
+        cache->entries[idx].pathHash = pathHash;
+        cache->numEntries++;
+    }
+    cache->entries[idx].key = key;
+}
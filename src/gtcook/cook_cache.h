@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+///
+/**
+    Cook cache - remembers which version of each source asset was cooked last.
+    An entry maps the hash of an asset's path to its cook key, a hash over the source bytes, the cooker version and
+    the keys of the assets it was cooked against. Assets whose key is unchanged are not cooked again.
+
+    Layout: CookCacheHeader | CookCacheEntry[numEntries], sorted by pathHash
+*/
+#define COOK_CACHE_MAGIC    0x43435447  // 'GTCC'
+#define COOK_CACHE_VERSION  1
+
+struct CookCacheHeader
+{
+    uint32_t    magic;
+    uint32_t    version;
+    uint64_t    numEntries;
+};
+
+struct CookCacheEntry
+{
+    uint64_t    pathHash;
+    uint64_t    key;
+};
+
+struct CookCache
+{
+    CookCacheEntry* entries = nullptr;
+    uint32_t        numEntries = 0;
+    uint32_t        capacity = 0;
+};
+
+uint64_t    HashCookPath(const char* path);
+
+// a missing cache file loads as an empty cache, only unreadable or corrupt ones fail
+bool        LoadCookCache(const char* path, CookCache* outCache);
+bool        StoreCookCache(const char* path, CookCache* cache);
+void        ReleaseCookCache(CookCache* cache);
+
+bool        FindCookKey(CookCache* cache, uint64_t pathHash, uint64_t* outKey);
+void        SetCookKey(CookCache* cache, uint64_t pathHash, uint64_t key);
@@ -0,0 +1,736 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gpu_skinning/assets.h"
+#include "gpu_skinning/gtbin.h"
+#include "gpu_skinning/hash.h"
+#include "gpu_skinning/jobs.h"
+#include "gpu_skinning/arena.h"
+#include "gpu_skinning/checksum.h"
+#include "gpu_skinning/clipcompression.h"
+#include "gpu_skinning/clipreduction.h"
+#include "gpu_skinning/clipsegments.h"
+#include "gpu_skinning/clipresampling.h"
+#include "gpu_skinning/trackpool.h"
+#include "gpu_skinning/package.h"
+#include "gpu_skinning/platform/timer.h"
+#include "gpu_skinning/platform/thread.h"
+#include "gpu_skinning/platform/batchread.h"
+#include "cook_cache.h"
+
+///
+/**
+    gtcook - offline asset cooker
+    Runs the importers over source assets and leaves a .gtbin next to each of them, so the runtime only has to map
+    data that is already sorted, inverted, widened and remapped (see LoadBaked* in assets.h).
+
+    usage: gtcook [-j threads] [-q depth] [-c cachefile] [-e error] [-b error] [-f] [-p package] assets...
+    Clips are remapped to the joint order of the last skeleton preceding them on the command line, e.g.
+        gtcook assets/knight.gtskel assets/knight_*.gtanimclip assets/knight.gtmesh
+    Skeletons and meshes are cooked first, clips once every skeleton is done.
+    -p packs the sources into a package (see package.h) once all of them cooked, the runtime reads them from
+    assets/assets.gtpak instead of the loose files. Entries keep the paths as given, so run gtcook from the
+    directory the runtime starts in, e.g. gtcook -p assets/assets.gtpak assets/knight.gtskel ...
+
+    Sources are read in one batch (see batchread.h, -q sets the queue depth) and hashed up front, only assets whose
+    cook key changed since the last run are cooked (see cook_cache.h), -f ignores the cache. Bump GTCOOK_VERSION
+    whenever an importer changes what it bakes.
+    Clips are baked four times, as they are, cut into streaming segments (see clipsegments.h), resampled (see
+    clipresampling.h) and compressed (see clipcompression.h); the streaming window, the size and error of every
+    resampled clip and the ratio and error of every compressed clip are reported. Before that, keyframes the runtime
+    can interpolate are dropped (see clipreduction.h).
+    -e sets the hierarchical error reduction may add and -b the one compression may add on top, in the units of the
+    skeleton; -e 0 keeps every keyframe, -b 0 compresses at the highest bit rates. The bit rate searches of all
+    clips run together once the clips are cooked, spread over the workers a depth of the hierarchy at a time.
+    Skeletons that cook to the same bytes are loaded once and shared by their clips. The clips of all skeletons with
+    the same joint layout form a library, their bakes are interchangeable. The clip cache shares identical tracks of
+    the clips it loads whole or compressed (see trackpool.h and CLIP_TRACK_SHARING in gpu_skinning.cpp), the tracks
+    of every library's cooked clips go through the same pools and what they save with all of the library's clips
+    loaded is reported. The bakes on disk keep every clip's own tracks, the sharing happens as they are loaded.
+*/
+#define GTCOOK_VERSION      6
+#define DEFAULT_CACHE_PATH  "gtcook.cache"
+
+enum CookType : uint32_t
+{
+    COOK_SKELETON,
+    COOK_MESH_GT,
+    COOK_MESH_SGM,
+    COOK_ANIMATION_CLIP,
+};
+
+// the tracks of the clips cooked for skeletons with one joint layout, as the clip cache shares them
+struct CookLibrary
+{
+    TrackPool   tracks;                 // of clips loaded whole
+    TrackPool   compressedTracks;
+};
+
+struct CookItem
+{
+    const char* path        = nullptr;
+    CookType    type        = COOK_SKELETON;
+    Skeleton*   skeleton    = nullptr;  // output for skeletons, target for clips
+    CookLibrary* library    = nullptr;  // of skeletons, shared by all skeletons with the same joint layout
+    CookItem*   dependency  = nullptr;  // skeleton item a clip is cooked against
+    FileRead*   source      = nullptr;  // read by the batch before hashing
+    uint64_t    sourceSize  = 0;
+    uint64_t    contentHash = 0;        // of the source bytes, seeded with the cooker version
+    uint64_t    key         = 0;        // contentHash combined with the dependency's key
+    bool        hashed      = false;
+    bool        upToDate    = false;    // the cache already holds key, nothing to cook
+    bool        success     = false;
+    double      seconds     = 0.0;
+    MeshImportStats     meshImport;         // of gtmesh meshes
+    ReductionSettings   reductionSettings;  // of clips, maxError 0 keeps every keyframe
+    ReductionStats      reduction;
+    CompressionSettings compressionSettings;
+    CompressionStats    compression;
+    uint32_t            numSegments = 0;    // of the segmented bake
+    size_t              segmentedBytes = 0;
+    size_t              maxSegmentSize = 0;
+    ResampleStats       resampling;
+    bool                compressed = false;     // false for clips the compressor refuses, they get no .q bake
+    AnimationClip*      clip = nullptr;     // reduced bake, mapped from clipFile while the bit rates are searched
+    AnimationClip*      shared = nullptr;   // the reduced tracks as shared through the library, until it is reported
+    CompressedClip*     sharedCompressed = nullptr;     // the same for the compressed bake
+    FileMapping         clipFile;
+    BitRateSearch*      search = nullptr;
+};
+
+static bool EndsWith(const char* str, const char* suffix)
+{
+    size_t strLen = strlen(str);
+    size_t suffixLen = strlen(suffix);
+    return strLen >= suffixLen && strcmp(str + strLen - suffixLen, suffix) == 0;
+}
+
+// importers bake as a side effect, loading the .gtbin back confirms the bake made it to disk
+static bool CookSkeleton(CookItem* item)
+{
+    Skeleton* check = new Skeleton();
+    bool success = ImportGTSkeleton(item->path, item->skeleton) && LoadBakedSkeleton(item->path, check);
+    delete check;
+    return success;
+}
+
+static bool CookMesh(CookItem* item)
+{
+    MeshDesc meshDesc;
+    bool imported = item->type == COOK_MESH_GT ? ImportGTMesh(item->path, &meshDesc, nullptr, &item->meshImport) : ImportSGM(item->path, &meshDesc);
+    if (!imported) {
+        return false;
+    }
+    ReleaseMeshDesc(&meshDesc);
+    FileMapping baked;
+    bool success = LoadBakedMesh(item->path, &baked, &meshDesc);
+    UnmapFile(&baked);
+    return success;
+}
+
+static bool CookSegmentedClip(CookItem* item, AnimationClip* clip)
+{
+    FileMapping baked;
+    SegmentedClip segmented;
+    if (!BakeSegmentedClip(item->path, item->skeleton, clip) || !LoadBakedSegmentedClip(item->path, item->skeleton, &baked, &segmented)) {
+        return false;
+    }
+    item->numSegments = segmented.numSegments;
+    item->maxSegmentSize = segmented.maxSegmentSize;
+    for (uint32_t s = 0; s < segmented.numSegments; ++s) {
+        item->segmentedBytes += segmented.segments[s].size;
+    }
+    UnmapFile(&baked);
+    return true;
+}
+
+static bool CookResampledClip(CookItem* item, AnimationClip* clip)
+{
+    ResampledClip* resampled = new ResampledClip;
+    bool success = ResampleClip(clip, item->skeleton, ResampleSettings(), resampled, &item->resampling) &&
+        BakeResampledClip(item->path, item->skeleton, resampled);
+    ReleaseResampledClip(resampled);
+    if (success) {
+        FileMapping baked;
+        success = LoadBakedResampledClip(item->path, item->skeleton, &baked, resampled);
+        UnmapFile(&baked);
+    }
+    delete resampled;
+    return success;
+}
+
+static bool CookAnimationClip(CookItem* item)
+{
+    AnimationClip* clip = new AnimationClip;
+    if (!ImportGTAnimation(item->path, item->skeleton, clip)) {
+        delete clip;
+        return false;
+    }
+    if (item->reductionSettings.maxError > 0.0f) {
+        AnimationClip* reduced = new AnimationClip;
+        bool reducedClip = ReduceClip(clip, item->skeleton, item->reductionSettings, reduced, &item->reduction) &&
+            BakeAnimation(item->path, item->skeleton, reduced);
+        ReleaseAnimationClip(reduced);
+        delete reduced;
+        if (!reducedClip) {
+            ReleaseAnimationClip(clip);
+            delete clip;
+            return false;
+        }
+    }
+    ReleaseAnimationClip(clip);
+    // the segmented, resampled and compressed clips are made from the reduced bake, CompressClips searches the bit rates
+    FileMapping baked;
+    bool success = LoadBakedAnimation(item->path, item->skeleton, &baked, clip) && CookSegmentedClip(item, clip) &&
+        CookResampledClip(item, clip);
+    if (!success) {
+        UnmapFile(&baked);
+        delete clip;
+        return false;
+    }
+    item->shared = new AnimationClip;
+    memcpy(item->shared->tracks, clip->tracks, sizeof(clip->tracks));
+    ShareClipTracks(&item->dependency->library->tracks, item->shared);
+    // the compressor refuses some clips, e.g. with rotations that aren't unit quaternions; the runtime loads those
+    // whole, so they are cooked without their compressed bake rather than failed
+    item->compressed = BeginCompressClip(clip, item->skeleton, item->compressionSettings, &item->search);
+    if (!item->compressed) {
+        printf("%s: cooked without a compressed bake\n", item->path);
+        UnmapFile(&baked);
+        delete clip;
+        return true;
+    }
+    item->clip = clip;
+    item->clipFile = baked;
+    return true;
+}
+
+static void FinishCompressedClip(CookItem* item)
+{
+    CompressedClip* compressed = new CompressedClip;
+    bool success = EndCompressClip(item->search, compressed, &item->compression) && BakeCompressedClip(item->path, item->skeleton, compressed);
+    item->search = nullptr;
+    ReleaseCompressedClip(compressed);
+    if (success) {
+        FileMapping baked;
+        success = LoadBakedCompressedClip(item->path, item->skeleton, &baked, compressed);
+        if (success) {
+            item->sharedCompressed = new CompressedClip;
+            memcpy(item->sharedCompressed->tracks, compressed->tracks, sizeof(compressed->tracks));
+            ShareCompressedClipTracks(&item->dependency->library->compressedTracks, item->sharedCompressed);
+        }
+        UnmapFile(&baked);
+    }
+    delete compressed;
+    UnmapFile(&item->clipFile);
+    delete item->clip;
+    item->clip = nullptr;
+    item->success = success;
+}
+
+static void HashJob(void* userData)
+{
+    auto item = static_cast<CookItem*>(userData);
+    if (!item->source->success) {
+        return;
+    }
+    uint64_t seed = ((uint64_t)GTCOOK_VERSION << 32) | GTBIN_VERSION;
+    item->contentHash = HashXXH64(item->source->buffer, item->source->size, seed);
+    item->sourceSize = item->source->size;
+    item->hashed = true;
+}
+
+// sizes every source first so the whole batch lands in one arena block
+static bool ReadSources(CookItem* items, uint32_t numItems, uint32_t queueDepth, FileRead* reads, Arena* arena)
+{
+    for (uint32_t i = 0; i < numItems; ++i) {
+        FileInfo info;
+        reads[i].path = items[i].path;
+        reads[i].size = QueryFileInfo(items[i].path, &info) ? (size_t)info.size : 0;
+        ArenaMeasure(arena, reads[i].size, 1);
+        items[i].source = &reads[i];
+    }
+    if (!ArenaCommit(arena)) {
+        printf("Out of memory reading the sources\n");
+        return false;
+    }
+    for (uint32_t i = 0; i < numItems; ++i) {
+        reads[i].buffer = ArenaAlloc(arena, reads[i].size, 1);
+    }
+    BatchReader reader;
+    InitBatchReader(&reader, queueDepth);
+    ReadFileBatch(&reader, reads, numItems);
+    ShutdownBatchReader(&reader);
+    return true;
+}
+
+// an up to date asset only needs its bake restamped in case the source was touched, skeletons are loaded for their clips
+static bool ReuseCookedItem(CookItem* item)
+{
+    char bakedPath[512];
+    if (!GTBinPathFor(item->path, bakedPath, sizeof(bakedPath)) || !GTBinRestamp(bakedPath, item->path)) {
+        return false;
+    }
+    static const char* clipVariants[] = { "s", "r", "q" };     // segmented, resampled and compressed
+    for (uint32_t i = 0; item->type == COOK_ANIMATION_CLIP && i < 3; ++i) {
+        if (!GTBinPathFor(item->path, bakedPath, sizeof(bakedPath), clipVariants[i])) {
+            return false;
+        }
+        FileInfo info;
+        bool optional = i == 2;     // clips the compressor refused have no compressed bake
+        if ((!optional || QueryFileInfo(bakedPath, &info)) && !GTBinRestamp(bakedPath, item->path)) {
+            return false;
+        }
+    }
+    if (item->type == COOK_SKELETON) {
+        return LoadBakedSkeleton(item->path, item->skeleton);
+    }
+    return true;
+}
+
+static void CookJob(void* userData)
+{
+    auto item = static_cast<CookItem*>(userData);
+    if (item->dependency != nullptr && !item->dependency->success) {
+        printf("%s: skipped, %s failed to cook\n", item->path, item->dependency->path);
+        return;
+    }
+    auto start = GetTicks();
+    switch (item->type) {
+    case COOK_SKELETON:         item->success = CookSkeleton(item); break;
+    case COOK_MESH_GT:
+    case COOK_MESH_SGM:         item->success = CookMesh(item); break;
+    case COOK_ANIMATION_CLIP:   item->success = CookAnimationClip(item); break;
+    }
+    item->seconds = TicksToSeconds(GetTicks() - start);
+}
+
+struct TrackSearch
+{
+    CookItem*   item = nullptr;
+    uint32_t    jointIdx = 0;
+};
+
+static void TrackSearchJob(void* userData)
+{
+    auto search = static_cast<TrackSearch*>(userData);
+    SearchTrackBitRates(search->item->search, search->jointIdx);
+}
+
+static void FinishCompressedClipJob(void* userData)
+{
+    auto item = static_cast<CookItem*>(userData);
+    auto start = GetTicks();
+    FinishCompressedClip(item);
+    item->seconds += TicksToSeconds(GetTicks() - start);
+}
+
+static void RunJob(JobPool* pool, JobFunc func, void* userData)
+{
+    if (pool != nullptr) {
+        PushJob(pool, func, userData);
+    }
+    else {
+        func(userData);
+    }
+}
+
+// the bit rate searches of all clips run together, one depth of the hierarchy at a time, since a track's search
+// needs its ancestors done
+static void CompressClips(JobPool* pool, CookItem* items, uint32_t numItems)
+{
+    TrackSearch* searches = new TrackSearch[numItems * MAX_NUM_BONES];
+    uint8_t* depths = new uint8_t[numItems * MAX_NUM_BONES];
+    uint32_t maxDepth = 0;
+    for (uint32_t i = 0; i < numItems; ++i) {
+        if (items[i].search == nullptr) {
+            continue;
+        }
+        auto skeleton = items[i].skeleton;
+        for (uint32_t j = 0; j < skeleton->numJoints; ++j) {
+            int parent = skeleton->joints[j].parent;
+            uint8_t depth = parent != -1 ? depths[i * MAX_NUM_BONES + parent] + 1 : 0;
+            depths[i * MAX_NUM_BONES + j] = depth;
+            searches[i * MAX_NUM_BONES + j].item = &items[i];
+            searches[i * MAX_NUM_BONES + j].jointIdx = j;
+            maxDepth = math::Max(maxDepth, (uint32_t)depth);
+        }
+    }
+    for (uint32_t depth = 0; depth <= maxDepth; ++depth) {
+        for (uint32_t i = 0; i < numItems; ++i) {
+            for (uint32_t j = 0; items[i].search != nullptr && j < items[i].skeleton->numJoints; ++j) {
+                if (depths[i * MAX_NUM_BONES + j] == depth && items[i].clip->tracks[j].numKeyframes != 0) {
+                    RunJob(pool, TrackSearchJob, &searches[i * MAX_NUM_BONES + j]);
+                }
+            }
+        }
+        if (pool != nullptr) {
+            WaitForJobs(pool);
+        }
+    }
+    for (uint32_t i = 0; i < numItems; ++i) {
+        if (items[i].search != nullptr) {
+            RunJob(pool, FinishCompressedClipJob, &items[i]);
+        }
+    }
+    if (pool != nullptr) {
+        WaitForJobs(pool);
+    }
+    delete[] depths;
+    delete[] searches;
+}
+
+// skeletons that cooked to the same bytes share one, skeletons with the same joint layout one library
+static void ShareSkeletons(CookItem* items, uint32_t numItems)
+{
+    for (uint32_t i = 0; i < numItems; ++i) {
+        auto& item = items[i];
+        if (item.type != COOK_SKELETON || !item.success) {
+            continue;
+        }
+        uint64_t layout = HashSkeletonLayout(item.skeleton);
+        for (uint32_t j = 0; j < i && item.library == nullptr; ++j) {
+            auto& other = items[j];
+            if (other.type != COOK_SKELETON || other.library == nullptr || HashSkeletonLayout(other.skeleton) != layout) {
+                continue;
+            }
+            item.library = other.library;
+            if (memcmp(item.skeleton, other.skeleton, sizeof(Skeleton)) == 0) {
+                printf("%s: same skeleton as %s, shared\n", item.path, other.path);
+                for (uint32_t k = i + 1; k < numItems; ++k) {
+                    if (items[k].dependency == &item) {
+                        items[k].skeleton = other.skeleton;
+                    }
+                }
+                delete item.skeleton;
+                item.skeleton = other.skeleton;
+            }
+        }
+        if (item.library == nullptr) {
+            item.library = new CookLibrary;
+            InitTrackPool(&item.library->tracks);
+            InitTrackPool(&item.library->compressedTracks);
+        }
+    }
+}
+
+static void PrintLibraryPool(const char* what, const TrackPool& pool, uint32_t numClips, uint32_t numArrays)
+{
+    printf("%20s %s: %u clips, %u of %u arrays distinct, %.1f KB of %.1f KB, %.1f KB saved\n", "", what, numClips,
+        pool.numArrays, numArrays, pool.storedBytes / 1024.0, pool.referencedBytes / 1024.0, (pool.referencedBytes - pool.storedBytes) / 1024.0);
+}
+
+// per library, the first of its skeletons on the command line names it; releases the shared tracks
+static void ReportLibraries(CookItem* items, uint32_t numItems)
+{
+    for (uint32_t i = 0; i < numItems; ++i) {
+        auto library = items[i].library;
+        if (items[i].type != COOK_SKELETON || library == nullptr) {
+            continue;
+        }
+        uint32_t numRigs = 0;
+        uint32_t numClips = 0;
+        uint32_t numArrays = 0;     // times and keyframes of every track
+        uint32_t numCompressedClips = 0;
+        uint32_t numCompressedArrays = 0;   // frames, segments and bits of every track
+        for (uint32_t j = i; j < numItems; ++j) {
+            auto& item = items[j];
+            numRigs += item.type == COOK_SKELETON && item.library == library ? 1 : 0;
+            if (item.type != COOK_ANIMATION_CLIP || item.dependency->library != library) {
+                continue;
+            }
+            numClips += item.shared != nullptr ? 1 : 0;
+            numCompressedClips += item.sharedCompressed != nullptr ? 1 : 0;
+            for (uint32_t k = 0; k < MAX_NUM_BONES; ++k) {
+                numArrays += item.shared != nullptr && item.shared->tracks[k].numKeyframes != 0 ? 2 : 0;
+                numCompressedArrays += item.sharedCompressed != nullptr && item.sharedCompressed->tracks[k].numKeyframes != 0 ? 3 : 0;
+            }
+        }
+        if (numClips != 0) {
+            printf("library %s, %u rigs, the clip cache shares tracks of clips loaded\n", items[i].path, numRigs);
+            PrintLibraryPool("whole", library->tracks, numClips, numArrays);
+            PrintLibraryPool("compressed", library->compressedTracks, numCompressedClips, numCompressedArrays);
+        }
+        for (uint32_t j = i; j < numItems; ++j) {
+            auto& item = items[j];
+            if (item.type != COOK_ANIMATION_CLIP || item.dependency->library != library) {
+                continue;
+            }
+            if (item.shared != nullptr) {
+                ReleaseClipTracks(&library->tracks, item.shared);
+                delete item.shared;
+                item.shared = nullptr;
+            }
+            if (item.sharedCompressed != nullptr) {
+                ReleaseCompressedClipTracks(&library->compressedTracks, item.sharedCompressed);
+                delete item.sharedCompressed;
+                item.sharedCompressed = nullptr;
+            }
+        }
+        for (uint32_t j = i + 1; j < numItems; ++j) {
+            if (items[j].type == COOK_SKELETON && items[j].library == library) {
+                items[j].library = nullptr;
+            }
+        }
+        ShutdownTrackPool(&library->tracks);
+        ShutdownTrackPool(&library->compressedTracks);
+        delete library;
+        items[i].library = nullptr;
+    }
+}
+
+// pool == nullptr cooks on the calling thread
+static void CookPhase(JobPool* pool, CookItem* items, uint32_t numItems, bool clips)
+{
+    for (uint32_t i = 0; i < numItems; ++i) {
+        if ((items[i].type == COOK_ANIMATION_CLIP) != clips || items[i].upToDate || !items[i].hashed) {
+            continue;
+        }
+        if (pool != nullptr) {
+            PushJob(pool, CookJob, &items[i]);
+        }
+        else {
+            CookJob(&items[i]);
+        }
+    }
+    if (pool != nullptr) {
+        WaitForJobs(pool);
+    }
+}
+
+static void PrintUsage()
+{
+    printf("usage: gtcook [-j threads] [-q depth] [-c cachefile] [-e error] [-b error] [-f] [-p package] assets...\n");
+    printf("    .gtskel .gtmesh .sgm .gtanimclip, clips are cooked against the last skeleton before them\n");
+    printf("    reports what the clip cache saves sharing the tracks of clips with the same joint layout\n");
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t numThreads = GetNumHardwareThreads();
+    uint32_t queueDepth = BATCH_READ_DEFAULT_QUEUE_DEPTH;
+    const char* cachePath = DEFAULT_CACHE_PATH;
+    const char* packagePath = nullptr;
+    bool force = false;
+    ReductionSettings reductionSettings;
+    CompressionSettings compressionSettings;
+    CookItem* items = new CookItem[argc];
+    uint32_t numItems = 0;
+    CookItem* currentSkeleton = nullptr;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            numThreads = (uint32_t)atoi(argv[++i]);
+            continue;
+        }
+        if (strcmp(argv[i], "-q") == 0 && i + 1 < argc) {
+            queueDepth = (uint32_t)atoi(argv[++i]);
+            continue;
+        }
+        if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            cachePath = argv[++i];
+            continue;
+        }
+        if (strcmp(argv[i], "-e") == 0 && i + 1 < argc) {
+            reductionSettings.maxError = (float)atof(argv[++i]);
+            continue;
+        }
+        if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            compressionSettings.maxError = (float)atof(argv[++i]);
+            continue;
+        }
+        if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+            packagePath = argv[++i];
+            continue;
+        }
+        if (strcmp(argv[i], "-f") == 0) {
+            force = true;
+            continue;
+        }
+        if (argv[i][0] == '-') {
+            PrintUsage();
+            return 1;
+        }
+        auto& item = items[numItems];
+        item.path = argv[i];
+        if (EndsWith(item.path, ".gtskel")) {
+            item.type = COOK_SKELETON;
+            item.skeleton = new Skeleton();
+            currentSkeleton = &item;
+        }
+        else if (EndsWith(item.path, ".gtmesh")) {
+            item.type = COOK_MESH_GT;
+        }
+        else if (EndsWith(item.path, ".sgm")) {
+            item.type = COOK_MESH_SGM;
+        }
+        else if (EndsWith(item.path, ".gtanimclip")) {
+            if (currentSkeleton == nullptr) {
+                printf("%s: no skeleton to cook the clip against, list one before it\n", item.path);
+                return 1;
+            }
+            item.type = COOK_ANIMATION_CLIP;
+            item.skeleton = currentSkeleton->skeleton;
+            item.dependency = currentSkeleton;
+            item.reductionSettings = reductionSettings;
+            item.compressionSettings = compressionSettings;
+        }
+        else {
+            printf("%s: unknown asset type\n", item.path);
+            return 1;
+        }
+        numItems++;
+    }
+    if (numItems == 0) {
+        PrintUsage();
+        return 1;
+    }
+
+    // the main thread helps out in WaitForJobs, so one worker less keeps every hardware thread busy
+    JobPool* pool = nullptr;
+    uint32_t numWorkers = numThreads > 1 ? numThreads - 1 : 0;
+    if (numWorkers > 0) {
+        pool = new JobPool;
+        if (!InitJobPool(pool, numWorkers)) {
+            printf("Failed to start cook workers\n");
+            return 1;
+        }
+        numWorkers = pool->numWorkers;
+    }
+    SetChecksumMode(CHECKSUM_VERIFY_TIMED);    // every bake is loaded back, which verifies its checksums
+    CookCache cache;
+    if (!LoadCookCache(cachePath, &cache)) {
+        printf("%s: ignoring the cook cache\n", cachePath);
+    }
+
+    auto start = GetTicks();
+    FileRead* reads = new FileRead[numItems];
+    Arena sources;
+    if (!ReadSources(items, numItems, queueDepth, reads, &sources)) {
+        return 1;
+    }
+    auto readSeconds = TicksToSeconds(GetTicks() - start);
+    for (uint32_t i = 0; i < numItems; ++i) {
+        if (pool != nullptr) {
+            PushJob(pool, HashJob, &items[i]);
+        }
+        else {
+            HashJob(&items[i]);
+        }
+    }
+    if (pool != nullptr) {
+        WaitForJobs(pool);
+    }
+    auto hashSeconds = TicksToSeconds(GetTicks() - start) - readSeconds;
+    ArenaRelease(&sources);
+    delete[] reads;
+    uint64_t bytesHashed = 0;
+    uint32_t numUpToDate = 0;
+    for (uint32_t i = 0; i < numItems; ++i) {   // skeletons precede their clips, so dependency keys are final here
+        auto& item = items[i];
+        if (!item.hashed) {
+            printf("%s: failed to read the source\n", item.path);
+            continue;
+        }
+        bytesHashed += item.sourceSize;
+        item.key = item.contentHash;
+        if (item.dependency != nullptr) {
+            item.key = HashXXH64(&item.dependency->key, sizeof(uint64_t), item.key);
+        }
+        if (item.type == COOK_ANIMATION_CLIP) {
+            float settings[4] = { item.reductionSettings.maxError, item.reductionSettings.vertexDistance,
+                item.compressionSettings.maxError, item.compressionSettings.vertexDistance };
+            item.key = HashXXH64(settings, sizeof(settings), item.key);
+        }
+        uint64_t cachedKey = 0;
+        bool dependencyUpToDate = item.dependency == nullptr || item.dependency->upToDate;
+        if (!force && dependencyUpToDate && FindCookKey(&cache, HashCookPath(item.path), &cachedKey) && cachedKey == item.key) {
+            item.upToDate = ReuseCookedItem(&item);
+            item.success = item.upToDate;
+            numUpToDate += item.upToDate ? 1 : 0;
+        }
+    }
+    CookPhase(pool, items, numItems, false);
+    ShareSkeletons(items, numItems);
+    CookPhase(pool, items, numItems, true);
+    auto compressStart = GetTicks();
+    CompressClips(pool, items, numItems);
+    auto compressSeconds = TicksToSeconds(GetTicks() - compressStart);
+    auto seconds = TicksToSeconds(GetTicks() - start);
+    if (pool != nullptr) {
+        ShutdownJobPool(pool);
+    }
+
+    uint32_t numFailed = 0;
+    for (uint32_t i = 0; i < numItems; ++i) {
+        auto& item = items[i];
+        if (item.success) {
+            SetCookKey(&cache, HashCookPath(item.path), item.key);
+        }
+        if (!item.upToDate) {
+            printf("%-6s %8.2f ms  %s\n", item.success ? "ok" : "FAILED", item.seconds * 1000.0, item.path);
+        }
+        if (!item.upToDate && item.success && item.type == COOK_MESH_GT && item.meshImport.decodeSeconds > 0.0) {
+            auto& stats = item.meshImport;
+            double megabytes = stats.vertexBytes / (1024.0 * 1024.0);
+            printf("%20s decoded %u vertices at %.1f MB/s\n", "", stats.numVertices, megabytes / stats.decodeSeconds);
+            if (stats.perFieldSeconds > 0.0) {
+                printf("%20s per-field decode at %.1f MB/s\n", "", megabytes / stats.perFieldSeconds);
+            }
+        }
+        if (!item.upToDate && item.success && item.type == COOK_ANIMATION_CLIP && item.reduction.numKeyframes != 0) {
+            auto& stats = item.reduction;
+            printf("%20s reduced %u to %u keyframes, %.1f%%, max error %.5f\n", "", stats.numKeyframes, stats.numReducedKeyframes,
+                100.0 * stats.numReducedKeyframes / stats.numKeyframes, stats.maxError);
+        }
+        if (!item.upToDate && item.success && item.type == COOK_ANIMATION_CLIP) {
+            printf("%20s segmented into %u segments of %.1f KB, streams %.1f KB of them at a time\n", "", item.numSegments,
+                item.segmentedBytes / 1024.0 / item.numSegments, item.maxSegmentSize * math::Min(item.numSegments, (uint32_t)CLIP_STREAMING_WINDOW) / 1024.0);
+        }
+        if (!item.upToDate && item.success && item.type == COOK_ANIMATION_CLIP) {
+            auto& stats = item.resampling;
+            printf("%20s resampled %.1f KB to %.1f KB, max error %.5f\n", "", stats.rawBytes / 1024.0, stats.resampledBytes / 1024.0, stats.maxError);
+        }
+        if (!item.upToDate && item.success && item.type == COOK_ANIMATION_CLIP && item.compressed && item.compression.compressedBytes != 0) {
+            auto& stats = item.compression;
+            printf("%20s compressed %.1f KB to %.1f KB, %.2fx, max error %.5f\n", "",
+                stats.rawBytes / 1024.0, stats.compressedBytes / 1024.0, (double)stats.rawBytes / (double)stats.compressedBytes, stats.maxError);
+        }
+        numFailed += item.success ? 0 : 1;
+    }
+    ReportLibraries(items, numItems);
+    if (!StoreCookCache(cachePath, &cache)) {
+        printf("%s: failed to store the cook cache\n", cachePath);
+    }
+    ReleaseCookCache(&cache);
+    bool packed = true;
+    if (packagePath != nullptr && numFailed != 0) {
+        printf("%s: not packed, %u assets failed to cook\n", packagePath, numFailed);
+    }
+    else if (packagePath != nullptr) {
+        const char** sources = new const char*[numItems];
+        for (uint32_t i = 0; i < numItems; ++i) {
+            sources[i] = items[i].path;
+        }
+        auto packStart = GetTicks();
+        packed = WritePackage(packagePath, sources, numItems);
+        if (packed) {
+            printf("packed %u sources into %s in %.2f ms\n", numItems, packagePath, TicksToSeconds(GetTicks() - packStart) * 1000.0);
+        }
+        else {
+            printf("%s: failed to write the package\n", packagePath);
+        }
+        delete[] sources;
+    }
+    printf("read %.1f MB in %.2f ms, hashed in %.2f ms (%.0f MB/s)\n",
+        bytesHashed / (1024.0 * 1024.0), readSeconds * 1000.0, hashSeconds * 1000.0, bytesHashed / (1024.0 * 1024.0) / hashSeconds);
+    ChecksumStats checksumStats;
+    GetChecksumStats(&checksumStats);
+    printf("verified %.1f MB of bakes in %.2f ms, %llu of %llu sections rejected\n", checksumStats.numBytes / (1024.0 * 1024.0),
+        checksumStats.seconds * 1000.0, (unsigned long long)checksumStats.numFailures, (unsigned long long)checksumStats.numSections);
+    printf("searched clip bit rates in %.2f ms\n", compressSeconds * 1000.0);
+    printf("cooked %u of %u assets, %u up to date, in %.2f ms on %u threads\n",
+        numItems - numFailed - numUpToDate, numItems - numUpToDate, numUpToDate, seconds * 1000.0, numWorkers + 1);
+    return numFailed == 0 && packed ? 0 : 1;
+}
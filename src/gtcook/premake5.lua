@@ -0,0 +1,24 @@
+make_exe("gtcook", main_dir)
+-- asset code shared with the renderer, everything D3D11 stays in gpu_skinning.cpp
+files {
+    "../gpu_skinning/arena.*",
+    "../gpu_skinning/assets.*",
+    "../gpu_skinning/bytestream.h",
+    "../gpu_skinning/checksum.*",
+    "../gpu_skinning/clipcompression.*",
+    "../gpu_skinning/clipmetric.*",
+    "../gpu_skinning/clipreduction.*",
+    "../gpu_skinning/clipresampling.*",
+    "../gpu_skinning/clipsegments.*",
+    "../gpu_skinning/trackpool.*",
+    "../gpu_skinning/hash.h",
+    "../gpu_skinning/gtbin.*",
+    "../gpu_skinning/lz.*",
+    "../gpu_skinning/package.*",
+    "../gpu_skinning/jobs.*",
+    "../gpu_skinning/math.*",
+    "../gpu_skinning/platform/**",
+}
+filter {"system:linux"}
+    links { "pthread" }
+filter {}
@@ -0,0 +1,149 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gpu_skinning/arena.h"
+#include "gpu_skinning/hash.h"
+#include "gpu_skinning/platform/file.h"
+#include "gpu_skinning/platform/timer.h"
+#include "gpu_skinning/platform/batchread.h"
+
+///
+/**
+    gtreadbench - batch reads against blocking reads
+    Reads the same set of files over and over, once file by file with blocking reads and once through the batch
+    reader at each queue depth, all into the same preallocated buffers. Every mode has to produce the same bytes.
+
+    usage: gtreadbench [-n iterations] [-q depth]... files...
+        gtreadbench -n 50 -q 1 -q 16 -q 64 assets/knight.gtskel assets/knight_run.gtanimclip ...
+
+    A warm-up pass runs first, so the numbers are for files in the page cache, which is the common case for
+    content servers loading the same assets at every boot.
+*/
+#define MAX_QUEUE_DEPTHS 16
+
+struct BenchResult
+{
+    double      bestSeconds = 0.0;
+    double      totalSeconds = 0.0;
+    uint64_t    hash = 0;
+    bool        success = true;
+};
+
+static void RunBench(BatchReader* reader, FileRead* reads, uint32_t numReads, Arena* buffers, uint32_t numIterations, BenchResult* outResult)
+{
+    *outResult = BenchResult();
+    outResult->success = ReadFileBatch(reader, reads, numReads);    // warm-up
+    for (uint32_t i = 0; i < numIterations; ++i) {
+        memset(buffers->block, 0x0, buffers->size);
+        auto start = GetTicks();
+        outResult->success &= ReadFileBatch(reader, reads, numReads);
+        auto seconds = TicksToSeconds(GetTicks() - start);
+        outResult->totalSeconds += seconds;
+        outResult->bestSeconds = i == 0 || seconds < outResult->bestSeconds ? seconds : outResult->bestSeconds;
+    }
+    outResult->hash = HashXXH64(buffers->block, buffers->size);
+}
+
+static void PrintResult(const char* mode, BenchResult* result, uint32_t numReads, uint64_t numBytes, uint32_t numIterations, double baselineSeconds)
+{
+    double avgSeconds = result->totalSeconds / numIterations;
+    printf("%-18s %9.3f ms avg %9.3f ms best %9.1f MB/s %10.0f files/s  %5.2fx%s\n",
+        mode, avgSeconds * 1000.0, result->bestSeconds * 1000.0, numBytes / (1024.0 * 1024.0) / avgSeconds,
+        numReads / avgSeconds, baselineSeconds / avgSeconds, result->success ? "" : "  FAILED");
+}
+
+static void PrintUsage()
+{
+    printf("usage: gtreadbench [-n iterations] [-q depth]... files...\n");
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t numIterations = 20;
+    uint32_t queueDepths[MAX_QUEUE_DEPTHS];
+    uint32_t numQueueDepths = 0;
+    FileRead* reads = new FileRead[argc];
+    uint32_t numReads = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            numIterations = (uint32_t)atoi(argv[++i]);
+            continue;
+        }
+        if (strcmp(argv[i], "-q") == 0 && i + 1 < argc) {
+            if (numQueueDepths < MAX_QUEUE_DEPTHS) {
+                queueDepths[numQueueDepths++] = (uint32_t)atoi(argv[++i]);
+            }
+            continue;
+        }
+        if (argv[i][0] == '-') {
+            PrintUsage();
+            return 1;
+        }
+        reads[numReads++].path = argv[i];
+    }
+    if (numReads == 0 || numIterations == 0) {
+        PrintUsage();
+        return 1;
+    }
+    if (numQueueDepths == 0) {
+        const uint32_t defaultDepths[] = { 1, 4, 16, 64 };
+        for (uint32_t depth : defaultDepths) {
+            queueDepths[numQueueDepths++] = depth;
+        }
+    }
+
+    Arena buffers;
+    uint64_t numBytes = 0;
+    for (uint32_t i = 0; i < numReads; ++i) {
+        FileInfo info;
+        if (!QueryFileInfo(reads[i].path, &info)) {
+            printf("Failed to query %s\n", reads[i].path);
+            return 1;
+        }
+        reads[i].size = (size_t)info.size;
+        numBytes += info.size;
+        ArenaMeasure(&buffers, reads[i].size, 1);
+    }
+    if (!ArenaCommit(&buffers)) {
+        printf("Out of memory\n");
+        return 1;
+    }
+    for (uint32_t i = 0; i < numReads; ++i) {
+        reads[i].buffer = ArenaAlloc(&buffers, reads[i].size, 1);
+    }
+    printf("%u files, %.2f MB, %u iterations\n", numReads, numBytes / (1024.0 * 1024.0), numIterations);
+
+    BatchReader reader;
+    BenchResult baseline;
+    InitBatchReader(&reader, 1, BATCH_READ_BLOCKING);
+    RunBench(&reader, reads, numReads, &buffers, numIterations, &baseline);
+    ShutdownBatchReader(&reader);
+    double baselineSeconds = baseline.totalSeconds / numIterations;
+    PrintResult("blocking", &baseline, numReads, numBytes, numIterations, baselineSeconds);
+
+    bool success = baseline.success;
+    for (uint32_t i = 0; i < numQueueDepths; ++i) {
+        InitBatchReader(&reader, queueDepths[i]);
+        if (!reader.async) {
+            ShutdownBatchReader(&reader);
+            printf("no async backend, nothing to compare against\n");
+            break;
+        }
+        BenchResult result;
+        RunBench(&reader, reads, numReads, &buffers, numIterations, &result);
+        char mode[32];
+        snprintf(mode, sizeof(mode), "batch depth %u", reader.queueDepth);
+        ShutdownBatchReader(&reader);
+        if (result.hash != baseline.hash) {
+            printf("%s read different bytes than the blocking reads\n", mode);
+            result.success = false;
+        }
+        PrintResult(mode, &result, numReads, numBytes, numIterations, baselineSeconds);
+        success &= result.success;
+    }
+    ArenaRelease(&buffers);
+    delete[] reads;
+    return success ? 0 : 1;
+}
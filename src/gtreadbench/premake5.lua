@@ -0,0 +1,9 @@
+make_exe("gtreadbench", main_dir)
+-- only needs the platform layer and the arena the buffers come from
+files {
+    "../gpu_skinning/arena.*",
+    "../gpu_skinning/platform/**",
+}
+filter {"system:linux"}
+    links { "pthread" }
+filter {}